@@ -32,10 +32,8 @@ class Visual:
         fig = plt.figure()
         ax, im = self.create_ax_plane_(fig, shape, title, xlabel, ylabel, min_coords, max_coords, value_limits)
         
-        coords0 = np.linspace(min_coords[0], max_coords[0], shape[0])
-        coords1 = np.linspace(min_coords[1], max_coords[1], shape[1])         
-        fields = self.get_field_plane_((coords0, coords1), shape, plane, last_coordinate_value,
-            self.generate_func_get_(field, field_coord, norm))
+        fields = self.extract_plane_(shape, plane, last_coordinate_value,
+            field, field_coord, norm)
             
         im.set_array(fields)
         
@@ -60,8 +58,8 @@ class Visual:
         ax = self.create_ax_axis_(fig, title, xlabel, ylabel, min_coords, max_coords, y_limits)
         
         coords = np.linspace(min_coords, max_coords, n_points)
-        fields = self.get_field_axis_(coords, n_points, axis, last_coordinate_value,
-            self.generate_func_get_(field, field_coord, norm))
+        fields = self.extract_axis_(n_points, axis, last_coordinate_value,
+            field, field_coord, norm)
             
         ax.plot(coords, fields, line_plot, label=label)
         
@@ -83,9 +81,6 @@ class Visual:
         
         fig = plt.figure()
         ax, im = self.create_ax_plane_(fig, shape, title, xlabel, ylabel, min_coords, max_coords, value_limits)
-        
-        coords0 = np.linspace(min_coords[0], max_coords[0], shape[0])
-        coords1 = np.linspace(min_coords[1], max_coords[1], shape[1])         
 
         fig.tight_layout()
                 
@@ -93,8 +88,8 @@ class Visual:
             if (i > n_iter):
                 exit()
             func_update()
-            fields = self.get_field_plane_((coords0, coords1), shape, plane, last_coordinate_value,
-                self.generate_func_get_(field, field_coord, norm))
+            fields = self.extract_plane_(shape, plane, last_coordinate_value,
+                field, field_coord, norm)
             im.set_array(fields)
             return im,   
     
@@ -116,8 +111,8 @@ class Visual:
         ax = self.create_ax_axis_(fig, title, xlabel, ylabel, min_coords, max_coords, y_limits)
         
         coords = np.linspace(min_coords, max_coords, n_points)
-        fields = self.get_field_axis_(coords, n_points, axis, last_coordinate_value,
-            self.generate_func_get_(field, field_coord, norm))
+        fields = self.extract_axis_(n_points, axis, last_coordinate_value,
+            field, field_coord, norm)
             
         line, = ax.plot(coords, fields, line_plot, label=label)
         
@@ -127,8 +122,8 @@ class Visual:
             if (i > n_iter):
                 exit()
             func_update()
-            fields = self.get_field_axis_(coords, n_points, axis, last_coordinate_value,
-                self.generate_func_get_(field, field_coord, norm))
+            fields = self.extract_axis_(n_points, axis, last_coordinate_value,
+                field, field_coord, norm)
             line.set_data(coords, fields)
             return line,   
     
@@ -163,93 +158,18 @@ class Visual:
         return ax        
         
         
-    def generate_func_get_(self, field, field_coord, norm):
-        func = None
-        
-        if field == Field.E:
-            if norm:
-                func = lambda self, coords: self.field.get_E(coords).norm()
-            else:
-                if field_coord == Axis.X:
-                    func = lambda self, coords: self.field.get_E(coords).x
-                elif field_coord == Axis.Y:
-                    func = lambda self, coords: self.field.get_E(coords).y
-                elif field_coord == Axis.Z:
-                    func = lambda self, coords: self.field.get_E(coords).z
-                    
-        elif field == Field.B:
-            if norm:
-                func = lambda self, coords: self.field.get_B(coords).norm()
-            else:
-                if field_coord == Axis.X:
-                    func = lambda self, coords: self.field.get_B(coords).x
-                elif field_coord == Axis.Y:
-                    func = lambda self, coords: self.field.get_B(coords).y
-                elif field_coord == Axis.Z:
-                    func = lambda self, coords: self.field.get_B(coords).z   
-                    
-        elif field == Field.J:
-            if norm:
-                func = lambda self, coords: self.field.get_J(coords).norm()
-            else:
-                if field_coord == Axis.X:
-                    func = lambda self, coords: self.field.get_J(coords).x
-                elif field_coord == Axis.Y:
-                    func = lambda self, coords: self.field.get_J(coords).y
-                elif field_coord == Axis.Z:
-                    func = lambda self, coords: self.field.get_J(coords).z 
-                    
-        return func                    
-    
-    
-    def get_field_plane_(self, coords, shape, plane, last_coordinate_value, func):
-        field = np.zeros(shape=(shape[1], shape[0]))
-        
-        if plane == Plane.XOY:
-            for i0 in range(shape[0]):
-                for i1 in range(shape[1]):
-                    coord = hichi.Vector3d(coords[0][i0], coords[1][i1], last_coordinate_value)
-                    field[shape[1]-i1-1, i0] = func(self, coord) 
-            return field
-            
-        elif plane == Plane.XOZ:
-            for i0 in range(shape[0]):
-                for i1 in range(shape[1]):
-                    coord = hichi.Vector3d(coords[0][i0], last_coordinate_value, coords[1][i1])
-                    field[shape[1]-i1-1, i0] = func(self, coord) 
-            return field
-            
-        elif plane == Plane.YOZ:
-            for i0 in range(shape[0]):
-                for i1 in range(shape[1]):
-                    coord = hichi.Vector3d(last_coordinate_value, coords[0][i0], coords[1][i1])
-                    field[shape[1]-i1-1, i0] = func(self, coord) 
-            return field
-            
-        return None
-    
+    def extract_plane_(self, shape, plane, last_coordinate_value, field, field_coord, norm):
+        return self.field.extract_plane(getattr(hichi.Field, field.name), getattr(hichi.Axis, field_coord.name),
+            getattr(hichi.Axis, plane.value[0].name), getattr(hichi.Axis, plane.value[1].name),
+            last_coordinate_value, self.to_vector_(self.min_coords), self.to_vector_(self.max_coords),
+            shape, norm)[::-1, :]
+
     
-    def get_field_axis_(self, coords, n_points, axis, last_coordinate_value, func):
-        field = np.zeros(shape=(n_points))
-        
-        if axis == Axis.X:
-            for i in range(n_points):
-                coord = hichi.Vector3d(coords[i], last_coordinate_value[0], last_coordinate_value[1])
-                field[i] = func(self, coord) 
-            return field
-            
-        elif axis == Axis.Y:
-            for i in range(n_points):
-                coord = hichi.Vector3d(last_coordinate_value[0], coords[i], last_coordinate_value[1])
-                field[i] = func(self, coord) 
-            return field
-            
-        elif axis == Axis.Z:
-            for i in range(n_points):
-                coord = hichi.Vector3d(last_coordinate_value[0], last_coordinate_value[1], coords[i])
-                field[i] = func(self, coord) 
-            return field
-            
-        return None
+    def extract_axis_(self, n_points, axis, last_coordinate_value, field, field_coord, norm):
+        return self.field.extract_line(getattr(hichi.Field, field.name), getattr(hichi.Axis, field_coord.name),
+            getattr(hichi.Axis, axis.name), last_coordinate_value,
+            self.to_vector_(self.min_coords), self.to_vector_(self.max_coords), n_points, norm)
+
     
-    
\ No newline at end of file
+    def to_vector_(self, coords):
+        return hichi.Vector3d(coords.x, coords.y, coords.z)
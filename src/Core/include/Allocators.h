@@ -1,38 +1,99 @@
 #pragma once
+#include <cstdlib>
 #include <cstring>
+#include <new>
+#include <utility>
 #include <vector>
 #include <omp.h>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 namespace pfc {
 
-    // NUMA allocator for ScalarField
+    // Memory aligned to a cache line, free with alignedFree
+    inline void* alignedMalloc(size_t len, size_t alignment = 64)
+    {
+#ifdef _MSC_VER
+        return _aligned_malloc(len, alignment);
+#else
+        void* p = 0;
+        if (posix_memalign(&p, alignment, len))
+            return 0;
+        return p;
+#endif
+    }
+
+    inline void alignedFree(void* p)
+    {
+#ifdef _MSC_VER
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+
+    /* Huge pages for large allocations of NUMA_Allocator: transparent huge
+    pages requested by madvise or explicit huge pages mapped by mmap, the latter
+    must be reserved in the system. Only supported on Linux, otherwise and if
+    the system refuses usual pages are used. */
+    enum HugePages { HugePages_None, HugePages_Transparent, HugePages_Explicit };
+
+    inline HugePages& hugePagesMode()
+    {
+        static HugePages mode = HugePages_None;
+        return mode;
+    }
+
+    inline void setHugePages(HugePages mode)
+    {
+        hugePagesMode() = mode;
+    }
+
+    // NUMA allocator for ScalarField, memory is aligned to 64 bytes
     // Based upon ideas by Georg Hager and Gerhard Wellein
+    // Memory is first touched by equal blocks per thread. With ifFirstTouch = false
+    // it is not touched and values are not initialized, the owner must write all
+    // of them in the parallel loops that will use them.
     template <class Data>
     class NUMA_Allocator {
     public:
 
+        static const size_t alignment = 64;
+        static const size_t hugePageSize = 2 * 1024 * 1024;
+
         using value_type = Data;
         using propagate_on_container_move_assignment = true_type;
         using is_always_equal = true_type;
 
-        constexpr NUMA_Allocator() noexcept {}
-        constexpr NUMA_Allocator(const NUMA_Allocator&) noexcept = default;
+        NUMA_Allocator(bool ifFirstTouch = true) noexcept : ifFirstTouch(ifFirstTouch) {}
+        NUMA_Allocator(const NUMA_Allocator&) noexcept = default;
         template<class OtherData>
-        constexpr NUMA_Allocator(const NUMA_Allocator<OtherData>&) noexcept {}
+        NUMA_Allocator(const NUMA_Allocator<OtherData>& a) noexcept : ifFirstTouch(a.ifFirstTouch) {}
+
+        // copies of containers touch their memory
+        NUMA_Allocator select_on_container_copy_construction() const
+        {
+            return NUMA_Allocator();
+        }
 
         value_type * allocate(const size_t num)
         {
             const size_t size_vt = sizeof(value_type);
             const size_t len = num * size_vt;
+            char * p = allocateBytes(len);
+            if (!ifFirstTouch)
+                return reinterpret_cast<value_type*>(p);
             const size_t num_threads = omp_get_max_threads();
             if (num_threads > num) {
-                char * p = reinterpret_cast<char*>(std::malloc(len));
                 std::memset(p, 0, len);
                 return reinterpret_cast<value_type*>(p);
             }
             const size_t block_size = (num / num_threads) * size_vt;
             const size_t block_size_rem = len - block_size * (num_threads - 1);
-            char * p = reinterpret_cast<char*>(std::malloc(len));
 #pragma omp parallel for
             for (int thr = 0; thr < num_threads; thr++) {
                 const size_t cur_block_size = thr == num_threads - 1 ? block_size_rem : block_size;
@@ -43,7 +104,23 @@ namespace pfc {
 
         void deallocate(value_type * const p, const size_t num)
         {
-            std::free(p);
+            deallocateBytes(reinterpret_cast<char*>(p));
+        }
+
+        // without the first touch values are written by the owner, so they are not touched here
+        template <class U>
+        void construct(U* p)
+        {
+            if (ifFirstTouch)
+                ::new((void*)p) U();
+            else
+                ::new((void*)p) U;
+        }
+
+        template <class U, class... Args>
+        void construct(U* p, Args&&... args)
+        {
+            ::new((void*)p) U(std::forward<Args>(args)...);
         }
 
         friend int operator==(const NUMA_Allocator& a1, const NUMA_Allocator& a2) {
@@ -54,6 +131,62 @@ namespace pfc {
             return false;
         }
 
+        bool ifFirstTouch;
+
+    private:
+
+        // Memory starts with a header of 'alignment' bytes, it keeps the length of the mapping
+        // for explicit huge pages and 0 otherwise.
+        static char* allocateBytes(size_t len)
+        {
+            const size_t total = len + alignment;
+            char* p = 0;
+            size_t mappedLength = 0;
+#ifdef __linux__
+            if (hugePagesMode() != HugePages_None && total >= hugePageSize) {
+                const size_t roundedLength = (total + hugePageSize - 1) / hugePageSize * hugePageSize;
+#ifdef MAP_HUGETLB
+                if (hugePagesMode() == HugePages_Explicit) {
+                    void* mapping = mmap(0, roundedLength, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                    if (mapping != MAP_FAILED) {
+                        p = reinterpret_cast<char*>(mapping);
+                        mappedLength = roundedLength;
+                    }
+                }
+#endif
+                if (!p) {
+                    p = reinterpret_cast<char*>(alignedMalloc(roundedLength, hugePageSize));
+#ifdef MADV_HUGEPAGE
+                    if (p)
+                        madvise(p, roundedLength, MADV_HUGEPAGE);
+#endif
+                }
+            }
+#endif
+            if (!p)
+                p = reinterpret_cast<char*>(alignedMalloc(total, alignment));
+            if (!p)
+                throw std::bad_alloc();
+            *reinterpret_cast<size_t*>(p) = mappedLength;
+            return p + alignment;
+        }
+
+        static void deallocateBytes(char* data)
+        {
+            if (!data)
+                return;
+            char* p = data - alignment;
+            const size_t mappedLength = *reinterpret_cast<size_t*>(p);
+#ifdef __linux__
+            if (mappedLength) {
+                munmap(p, mappedLength);
+                return;
+            }
+#endif
+            alignedFree(p);
+        }
+
     };
 
 }
@@ -66,6 +66,11 @@ namespace pfc {
                 this->funcBz(coord.x, coord.y, coord.z, this->globalTime));
         }
 
+        void getFields(const FP3& coord, FP3& e, FP3& b) const {
+            e = getE(coord);
+            b = getB(coord);
+        }
+
         FP3 getJ(FP3 coord) const {
             return FP3(this->funcJx(coord.x, coord.y, coord.z, this->globalTime),
                 this->funcJy(coord.x, coord.y, coord.z, this->globalTime),
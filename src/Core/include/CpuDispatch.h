@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdlib>
+#include <string>
+
+/* Hot kernels are compiled for several instruction sets in the same binary,
+the variant is selected at run time by getCpuIsa(). A kernel is written as an
+inline function, the variants are functions with PFC_TARGET_* attributes that
+call it, so the kernel is inlined and compiled for their instruction set. Loops
+of a kernel must not be OpenMP parallel regions: the code of a region is outlined
+before inlining and would keep the baseline instruction set, so the variants are
+called inside the parallel loops. Multiversioning needs GCC or Clang on x86-64,
+otherwise all variants are the baseline code. */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(__INTEL_COMPILER)
+    #define PFC_MULTIVERSION
+    #define PFC_TARGET_AVX2 __attribute__((target("avx2,fma")))
+    #define PFC_TARGET_AVX512 __attribute__((target("avx512f,avx512dq,avx512vl,avx2,fma")))
+#else
+    #define PFC_TARGET_AVX2
+    #define PFC_TARGET_AVX512
+#endif
+
+/* Defines functions name##Generic, name##AVX2 and name##AVX512 with parameters
+params that call kernel with arguments args, header is a template header or empty.
+The functions are static to be members of classes. */
+#define PFC_KERNEL_VARIANTS(header, name, kernel, params, args) \
+    header static void name##Generic params { kernel args; } \
+    header PFC_TARGET_AVX2 static void name##AVX2 params { kernel args; } \
+    header PFC_TARGET_AVX512 static void name##AVX512 params { kernel args; }
+
+namespace pfc
+{
+    enum CpuIsa { CpuIsa_Generic, CpuIsa_AVX2, CpuIsa_AVX512 };
+
+    inline std::string toString(CpuIsa isa)
+    {
+        switch (isa) {
+        case CpuIsa_AVX512:
+            return "avx512";
+        case CpuIsa_AVX2:
+            return "avx2";
+        default:
+            return "generic";
+        }
+    }
+
+    // the best instruction set supported by the CPU and the OS
+    inline CpuIsa detectCpuIsa()
+    {
+#ifdef PFC_MULTIVERSION
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+            __builtin_cpu_supports("avx512vl"))
+            return CpuIsa_AVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return CpuIsa_AVX2;
+#endif
+        return CpuIsa_Generic;
+    }
+
+    namespace detail
+    {
+        /* The detected instruction set, HICHI_CPU_ISA = generic, avx2 or avx512
+        selects a lower one. */
+        inline CpuIsa initCpuIsa()
+        {
+            CpuIsa isa = detectCpuIsa();
+            const char* value = std::getenv("HICHI_CPU_ISA");
+            if (value)
+                for (int i = CpuIsa_Generic; i < isa; i++)
+                    if (toString((CpuIsa)i) == value)
+                        return (CpuIsa)i;
+            return isa;
+        }
+
+        inline CpuIsa& cpuIsa()
+        {
+            static CpuIsa isa = initCpuIsa();
+            return isa;
+        }
+    }
+
+    // the instruction set of the kernels
+    inline CpuIsa getCpuIsa()
+    {
+        return detail::cpuIsa();
+    }
+
+    /* Sets the instruction set of the kernels, an instruction set
+    not supported by the CPU is replaced by the best supported one.
+    Must not be called while kernels are running. */
+    inline CpuIsa setCpuIsa(CpuIsa isa)
+    {
+        CpuIsa supported = detectCpuIsa();
+        detail::cpuIsa() = isa < supported ? isa : supported;
+        return getCpuIsa();
+    }
+
+    // the variant of a kernel for getCpuIsa()
+    template<class Function>
+    inline Function selectKernel(Function generic, Function avx2, Function avx512)
+    {
+        switch (getCpuIsa()) {
+        case CpuIsa_AVX512:
+            return avx512;
+        case CpuIsa_AVX2:
+            return avx2;
+        default:
+            return generic;
+        }
+    }
+}
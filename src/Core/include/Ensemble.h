@@ -1,4 +1,5 @@
 #pragma once
+#include "macros.h"
 #include "ParticleArray.h"
 #include "ParticleTypes.h"
 
@@ -62,6 +63,71 @@ namespace pfc {
             pArrays[particleNames[particle.getType()]].pushBack(particle);
         }
 
+        /* Adds particles of all blocks in their order. Each array is resized once,
+        places of blocks are given by the prefix sums of counts of particles of
+        each type, the blocks are copied in parallel. */
+        void addParticles(const std::vector<std::vector<ParticleType>>& blocks)
+        {
+            const int numBlocks = (int)blocks.size();
+            std::vector<int> places(numBlocks * sizeParticleTypes, 0);
+            OMP_FOR()
+            for (int b = 0; b < numBlocks; b++)
+                for (int idx = 0; idx < (int)blocks[b].size(); idx++)
+                    places[b * sizeParticleTypes + blocks[b][idx].getType()]++;
+
+            pArray* arrays[sizeParticleTypes];
+            for (int t = 0; t < sizeParticleTypes; t++) {
+                arrays[t] = &(*this)[t];
+                const int oldSize = (int)arrays[t]->size();
+                int size = oldSize;
+                for (int b = 0; b < numBlocks; b++) {
+                    int count = places[b * sizeParticleTypes + t];
+                    places[b * sizeParticleTypes + t] = size;
+                    size += count;
+                }
+                if (size != oldSize)
+                    arrays[t]->resize(size);
+            }
+
+            OMP_FOR_DYNAMIC()
+            for (int b = 0; b < numBlocks; b++) {
+                int* blockPlaces = &places[b * sizeParticleTypes];
+                for (int idx = 0; idx < (int)blocks[b].size(); idx++) {
+                    int type = blocks[b][idx].getType();
+                    arrays[type]->setParticle(blockPlaces[type]++, blocks[b][idx]);
+                }
+            }
+        }
+
+        // removes the marked particles of all types
+        inline void compact(bool keepOrder = true)
+        {
+            for (auto it = pArrays.begin(); it != pArrays.end(); it++)
+                it->second.compact(keepOrder);
+        }
+
+        // sorts particles of all types by cells of the grid
+        template<class TGrid>
+        void sortByCell(const TGrid* grid)
+        {
+            for (auto it = pArrays.begin(); it != pArrays.end(); it++)
+                it->second.sortByCell(grid);
+        }
+
+        void setSortPeriod(int period)
+        {
+            for (auto it = pArrays.begin(); it != pArrays.end(); it++)
+                it->second.setSortPeriod(period);
+        }
+
+        // is called once per step, see ParticleArraySoA::sortByCellPeriodically()
+        template<class TGrid>
+        void sortByCellPeriodically(const TGrid* grid)
+        {
+            for (auto it = pArrays.begin(); it != pArrays.end(); it++)
+                it->second.sortByCellPeriodically(grid);
+        }
+
         inline void clear() 
         {
             pArrays.clear();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "macros.h"
+#include "CpuDispatch.h"
 
 #include "GridTypes.h"
 #include "ScalarField.h"
@@ -87,6 +88,11 @@ namespace pfc {
         virtual FP3 getE(const FP3& coords) const;
         virtual FP3 getB(const FP3& coords) const;
 
+        /* Interpolate E and B at n points given as arrays of coordinates,
+        the interpolation type is chosen once for the whole batch. */
+        void getFieldsBatch(const FP* x, const FP* y, const FP* z, int n,
+            FP* ex, FP* ey, FP* ez, FP* bx, FP* by, FP* bz) const;
+
         void getFieldsCIC(const FP3& coords, FP3 & e, FP3 & b) const;
         void getFieldsTSC(const FP3& coords, FP3 & e, FP3 & b) const;
         void getFieldsSecondOrder(const FP3& coords, FP3 & e, FP3 & b) const;
@@ -277,6 +283,23 @@ namespace pfc {
         /* Make all current density values zero. */
         void zeroizeJ();
 
+        /* Change memory layout of all fields, see ScalarFieldLayout. With the
+        interleaved layout the six components of E and B at a node are adjacent,
+        so a gather reads one stream instead of six; J stays row-major. Spectral
+        grids share memory with FFT and support only the row-major layout. */
+        void setLayout(ScalarFieldLayout layout, int brickSize = 4);
+
+        ScalarFieldLayout getLayout() const
+        {
+            return Ex.getLayout();
+        }
+
+        /* Move field values to memory first touched by the threads of
+        OMP_FOR_COLLAPSE() over (i, j) in [begin, end), so that a solver loop
+        over this area updates memory of the NUMA nodes of its threads.
+        Pointers to field data become invalid. */
+        void placeRows(const Int3& begin, const Int3& end);
+
         const Int3 getNumExternalLeftCells() const
         {
             Int3 result(2, 2, 2);
@@ -345,6 +368,35 @@ namespace pfc {
             return coords >= minCoords && coords <= maxCoords;
         }
 
+        void interleaveEB();
+        void separateEB();
+        void setInterleavedEB();
+
+        template <FP (ScalarField<Data>::*interpolate)(const Int3&, const FP3&) const, bool closest>
+        forceinline void getFieldsBatchShared(const FP* x, const FP* y, const FP* z, int n,
+            FP* ex, FP* ey, FP* ez, FP* bx, FP* by, FP* bz) const;
+
+        /* The batch interpolation of the given type, the variants for instruction
+        sets are selected by getCpuIsa() in getFieldsBatch(). */
+        typedef void(*GetFieldsBatch)(const Grid*, const FP*, const FP*, const FP*, int,
+            FP*, FP*, FP*, FP*, FP*, FP*);
+
+        template <InterpolationType type>
+        forceinline static void getFieldsBatchKernel(const Grid* grid, const FP* x, const FP* y, const FP* z,
+            int n, FP* ex, FP* ey, FP* ez, FP* bx, FP* by, FP* bz);
+
+        PFC_KERNEL_VARIANTS(template <InterpolationType type>, getFieldsBatch, getFieldsBatchKernel<type>,
+            (const Grid* grid, const FP* x, const FP* y, const FP* z, int n,
+                FP* ex, FP* ey, FP* ez, FP* bx, FP* by, FP* bz),
+            (grid, x, y, z, n, ex, ey, ez, bx, by, bz))
+
+        template <InterpolationType type>
+        static GetFieldsBatch selectFieldsBatch()
+        {
+            return selectKernel(&getFieldsBatchGeneric<type>, &getFieldsBatchAVX2<type>,
+                &getFieldsBatchAVX512<type>);
+        }
+
         FP getFieldCIC(const FP3& coords, const ScalarField<Data>& field, const FP3 & shift) const;
         FP getFieldTSC(const FP3& coords, const ScalarField<Data>& field, const FP3 & shift) const;
         FP getFieldSecondOrder(const FP3& coords, const ScalarField<Data>& field, const FP3 & shift) const;
@@ -362,6 +414,9 @@ namespace pfc {
         FP(Grid::*interpolationJx)(const FP3&) const;
         FP(Grid::*interpolationJy)(const FP3&) const;
         FP(Grid::*interpolationJz)(const FP3&) const;
+
+        // common memory of E and B for the interleaved layout
+        std::vector<Data, NUMA_Allocator<Data>> interleavedEB;
     };
 
     typedef Grid<FP, GridTypes::YeeGridType> YeeGrid;
@@ -392,6 +447,10 @@ namespace pfc {
         Jy(grid.Jy, ifShallowCopy),
         Jz(grid.Jz, ifShallowCopy)
     {
+        if (!ifShallowCopy && grid.getLayout() == ScalarFieldLayout_Interleaved) {
+            interleavedEB = grid.interleavedEB;
+            setInterleavedEB();
+        }
         setInterpolationType(grid.interpolationType);
     }
 
@@ -825,6 +884,101 @@ namespace pfc {
         b.z = Bz.interpolatePCS(idx, internalCoords);
     }
 
+    template< typename Data, GridTypes gT>
+    inline void Grid<Data, gT>::getFieldsBatch(const FP* x, const FP* y, const FP* z, int n,
+        FP* ex, FP* ey, FP* ez, FP* bx, FP* by, FP* bz) const
+    {
+        GetFieldsBatch getFieldsBatchKernel;
+        switch (interpolationType)
+        {
+        case Interpolation_CIC:
+            getFieldsBatchKernel = selectFieldsBatch<Interpolation_CIC>();
+            break;
+        case Interpolation_TSC:
+            getFieldsBatchKernel = selectFieldsBatch<Interpolation_TSC>();
+            break;
+        case Interpolation_SecondOrder:
+            getFieldsBatchKernel = selectFieldsBatch<Interpolation_SecondOrder>();
+            break;
+        case Interpolation_FourthOrder:
+            getFieldsBatchKernel = selectFieldsBatch<Interpolation_FourthOrder>();
+            break;
+        case Interpolation_PCS:
+            getFieldsBatchKernel = selectFieldsBatch<Interpolation_PCS>();
+            break;
+        default:
+            return;
+        }
+        getFieldsBatchKernel(this, x, y, z, n, ex, ey, ez, bx, by, bz);
+    }
+
+    template< typename Data, GridTypes gT>
+    template <InterpolationType type>
+    forceinline void Grid<Data, gT>::getFieldsBatchKernel(const Grid* grid, const FP* x, const FP* y, const FP* z,
+        int n, FP* ex, FP* ey, FP* ez, FP* bx, FP* by, FP* bz)
+    {
+        typedef ScalarField<Data> Field;
+        if (type == Interpolation_CIC)
+            grid->getFieldsBatchShared<&Field::interpolateCIC, false>(x, y, z, n, ex, ey, ez, bx, by, bz);
+        else if (type == Interpolation_TSC)
+            grid->getFieldsBatchShared<&Field::interpolateTSC, true>(x, y, z, n, ex, ey, ez, bx, by, bz);
+        else if (type == Interpolation_SecondOrder)
+            grid->getFieldsBatchShared<&Field::interpolateSecondOrder, true>(x, y, z, n, ex, ey, ez, bx, by, bz);
+        else if (type == Interpolation_FourthOrder)
+            grid->getFieldsBatchShared<&Field::interpolateFourthOrder, true>(x, y, z, n, ex, ey, ez, bx, by, bz);
+        else
+            grid->getFieldsBatchShared<&Field::interpolatePCS, false>(x, y, z, n, ex, ey, ez, bx, by, bz);
+    }
+
+    template< typename Data, GridTypes gT>
+    template <FP (ScalarField<Data>::*interpolate)(const Int3&, const FP3&) const, bool closest>
+    forceinline void Grid<Data, gT>::getFieldsBatchShared(const FP* x, const FP* y, const FP* z, int n,
+        FP* ex, FP* ey, FP* ez, FP* bx, FP* by, FP* bz) const
+    {
+        /* Each shift is zero or half a step along each dimension, so base index and
+        coefficients are computed twice per dimension and shared by all components.
+        The base index is the closest node as in getClosestGridCoords() if closest,
+        otherwise the node below as in getGridCoords(). */
+        const FP3 shifts[6] = { shiftEJx, shiftEJy, shiftEJz, shiftBx, shiftBy, shiftBz };
+        Int3 half[6];
+        for (int c = 0; c < 6; c++)
+            for (int d = 0; d < 3; d++)
+                half[c][d] = shifts[c][d] > 0 ? 1 : 0;
+        const FP3 invSteps = FP3(1, 1, 1) / steps;
+
+        OMP_SIMD()
+        for (int i = 0; i < n; i++)
+        {
+            const FP3 coords = (FP3(x[i], y[i], z[i]) - origin) * invSteps;
+            Int3 idx[2];
+            FP3 internalCoords[2];
+            for (int d = 0; d < 3; d++) {
+                idx[0][d] = (int)(coords[d] + (closest ? (FP)0.5 : (FP)0));
+                internalCoords[0][d] = coords[d] - idx[0][d];
+                idx[1][d] = (int)(coords[d] - (closest ? (FP)0 : (FP)0.5));
+                internalCoords[1][d] = coords[d] - (FP)0.5 - idx[1][d];
+            }
+            ex[i] = (Ex.*interpolate)(
+                Int3(idx[half[0].x].x, idx[half[0].y].y, idx[half[0].z].z),
+                FP3(internalCoords[half[0].x].x, internalCoords[half[0].y].y, internalCoords[half[0].z].z));
+            ey[i] = (Ey.*interpolate)(
+                Int3(idx[half[1].x].x, idx[half[1].y].y, idx[half[1].z].z),
+                FP3(internalCoords[half[1].x].x, internalCoords[half[1].y].y, internalCoords[half[1].z].z));
+            ez[i] = (Ez.*interpolate)(
+                Int3(idx[half[2].x].x, idx[half[2].y].y, idx[half[2].z].z),
+                FP3(internalCoords[half[2].x].x, internalCoords[half[2].y].y, internalCoords[half[2].z].z));
+            bx[i] = (Bx.*interpolate)(
+                Int3(idx[half[3].x].x, idx[half[3].y].y, idx[half[3].z].z),
+                FP3(internalCoords[half[3].x].x, internalCoords[half[3].y].y, internalCoords[half[3].z].z));
+            by[i] = (By.*interpolate)(
+                Int3(idx[half[4].x].x, idx[half[4].y].y, idx[half[4].z].z),
+                FP3(internalCoords[half[4].x].x, internalCoords[half[4].y].y, internalCoords[half[4].z].z));
+            bz[i] = (Bz.*interpolate)(
+                Int3(idx[half[5].x].x, idx[half[5].y].y, idx[half[5].z].z),
+                FP3(internalCoords[half[5].x].x, internalCoords[half[5].y].y, internalCoords[half[5].z].z));
+        }
+    }
+
     template< typename Data, GridTypes gT>
     inline FP3 Grid<Data, gT>::getJ(const FP3& coords) const
     {
@@ -902,6 +1056,94 @@ namespace pfc {
         Jz.zeroize();
     }
 
+    template< typename Data, GridTypes gT>
+    inline void Grid<Data, gT>::setLayout(ScalarFieldLayout layout, int brickSize)
+    {
+        if (layout != ScalarFieldLayout_RowMajor &&
+            gT != GridTypes::YeeGridType && gT != GridTypes::StraightGridType)
+            throw "Only row-major layout is supported for spectral grids";
+        if (getLayout() == ScalarFieldLayout_Interleaved)
+            separateEB();
+        if (layout == ScalarFieldLayout_Interleaved) {
+            Jx.setLayout(ScalarFieldLayout_RowMajor);
+            Jy.setLayout(ScalarFieldLayout_RowMajor);
+            Jz.setLayout(ScalarFieldLayout_RowMajor);
+            interleaveEB();
+            return;
+        }
+        Ex.setLayout(layout, brickSize);
+        Ey.setLayout(layout, brickSize);
+        Ez.setLayout(layout, brickSize);
+        Bx.setLayout(layout, brickSize);
+        By.setLayout(layout, brickSize);
+        Bz.setLayout(layout, brickSize);
+        Jx.setLayout(layout, brickSize);
+        Jy.setLayout(layout, brickSize);
+        Jz.setLayout(layout, brickSize);
+    }
+
+    template< typename Data, GridTypes gT>
+    inline void Grid<Data, gT>::placeRows(const Int3& begin, const Int3& end)
+    {
+        // memory of spectral grids is shared with their complex grids
+        if (gT != GridTypes::YeeGridType && gT != GridTypes::StraightGridType)
+            throw "Memory of spectral grids can't be moved";
+        if (getLayout() == ScalarFieldLayout_Interleaved) {
+            placeStorageRows(interleavedEB, sizeStorage, 6 * sizeStorage.z, begin, end);
+            setInterleavedEB();
+        }
+        else {
+            Ex.placeRows(begin, end);
+            Ey.placeRows(begin, end);
+            Ez.placeRows(begin, end);
+            Bx.placeRows(begin, end);
+            By.placeRows(begin, end);
+            Bz.placeRows(begin, end);
+        }
+        Jx.placeRows(begin, end);
+        Jy.placeRows(begin, end);
+        Jz.placeRows(begin, end);
+    }
+
+    template< typename Data, GridTypes gT>
+    inline void Grid<Data, gT>::interleaveEB()
+    {
+        ScalarField<Data>* fields[6] = { &Ex, &Ey, &Ez, &Bx, &By, &Bz };
+        std::vector<Data, NUMA_Allocator<Data>> storage(6 * sizeStorage.volume());
+        OMP_FOR()
+        for (int i = 0; i < sizeStorage.x; i++)
+            for (int j = 0; j < sizeStorage.y; j++)
+                for (int k = 0; k < sizeStorage.z; k++)
+                    for (int c = 0; c < 6; c++)
+                        storage[6 * (k + (j + i * sizeStorage.y) * sizeStorage.z) + c] = (*fields[c])(i, j, k);
+        interleavedEB.swap(storage);
+        setInterleavedEB();
+    }
+
+    template< typename Data, GridTypes gT>
+    inline void Grid<Data, gT>::separateEB()
+    {
+        ScalarField<Data>* fields[6] = { &Ex, &Ey, &Ez, &Bx, &By, &Bz };
+        for (int c = 0; c < 6; c++) {
+            ScalarField<Data> field(sizeStorage);
+            OMP_FOR()
+            for (int i = 0; i < sizeStorage.x; i++)
+                for (int j = 0; j < sizeStorage.y; j++)
+                    for (int k = 0; k < sizeStorage.z; k++)
+                        field(i, j, k) = (*fields[c])(i, j, k);
+            *fields[c] = field;
+        }
+        std::vector<Data, NUMA_Allocator<Data>>().swap(interleavedEB);
+    }
+
+    template< typename Data, GridTypes gT>
+    inline void Grid<Data, gT>::setInterleavedEB()
+    {
+        ScalarField<Data>* fields[6] = { &Ex, &Ey, &Ez, &Bx, &By, &Bz };
+        for (int c = 0; c < 6; c++)
+            *fields[c] = ScalarField<Data>(interleavedEB.data() + c, sizeStorage, 6);
+    }
+
     template< typename Data, GridTypes gT>
     inline void Grid<Data, gT>::setInterpolationType(InterpolationType type)
     {
@@ -0,0 +1,120 @@
+#pragma once
+#include "macros.h"
+#include "Grid.h"
+
+namespace pfc {
+
+    /* Interpolation methods of Grid for the given interpolation type,
+    resolved at compile time. */
+    template <InterpolationType interpolationType, GridTypes gridType>
+    struct InterpolationMethods {
+    };
+
+    template <GridTypes gridType>
+    struct InterpolationMethods<Interpolation_CIC, gridType> {
+        typedef Grid<FP, gridType> GridType;
+        static forceinline void getFields(const GridType* grid, const FP3& coords, FP3& e, FP3& b) {
+            grid->getFieldsCIC(coords, e, b);
+        }
+        static forceinline FP3 getE(const GridType* grid, const FP3& coords) {
+            return FP3(grid->getExCIC(coords), grid->getEyCIC(coords), grid->getEzCIC(coords));
+        }
+        static forceinline FP3 getB(const GridType* grid, const FP3& coords) {
+            return FP3(grid->getBxCIC(coords), grid->getByCIC(coords), grid->getBzCIC(coords));
+        }
+    };
+
+    template <GridTypes gridType>
+    struct InterpolationMethods<Interpolation_TSC, gridType> {
+        typedef Grid<FP, gridType> GridType;
+        static forceinline void getFields(const GridType* grid, const FP3& coords, FP3& e, FP3& b) {
+            grid->getFieldsTSC(coords, e, b);
+        }
+        static forceinline FP3 getE(const GridType* grid, const FP3& coords) {
+            return FP3(grid->getExTSC(coords), grid->getEyTSC(coords), grid->getEzTSC(coords));
+        }
+        static forceinline FP3 getB(const GridType* grid, const FP3& coords) {
+            return FP3(grid->getBxTSC(coords), grid->getByTSC(coords), grid->getBzTSC(coords));
+        }
+    };
+
+    template <GridTypes gridType>
+    struct InterpolationMethods<Interpolation_SecondOrder, gridType> {
+        typedef Grid<FP, gridType> GridType;
+        static forceinline void getFields(const GridType* grid, const FP3& coords, FP3& e, FP3& b) {
+            grid->getFieldsSecondOrder(coords, e, b);
+        }
+        static forceinline FP3 getE(const GridType* grid, const FP3& coords) {
+            return FP3(grid->getExSecondOrder(coords), grid->getEySecondOrder(coords), grid->getEzSecondOrder(coords));
+        }
+        static forceinline FP3 getB(const GridType* grid, const FP3& coords) {
+            return FP3(grid->getBxSecondOrder(coords), grid->getBySecondOrder(coords), grid->getBzSecondOrder(coords));
+        }
+    };
+
+    template <GridTypes gridType>
+    struct InterpolationMethods<Interpolation_FourthOrder, gridType> {
+        typedef Grid<FP, gridType> GridType;
+        static forceinline void getFields(const GridType* grid, const FP3& coords, FP3& e, FP3& b) {
+            grid->getFieldsFourthOrder(coords, e, b);
+        }
+        static forceinline FP3 getE(const GridType* grid, const FP3& coords) {
+            return FP3(grid->getExFourthOrder(coords), grid->getEyFourthOrder(coords), grid->getEzFourthOrder(coords));
+        }
+        static forceinline FP3 getB(const GridType* grid, const FP3& coords) {
+            return FP3(grid->getBxFourthOrder(coords), grid->getByFourthOrder(coords), grid->getBzFourthOrder(coords));
+        }
+    };
+
+    template <GridTypes gridType>
+    struct InterpolationMethods<Interpolation_PCS, gridType> {
+        typedef Grid<FP, gridType> GridType;
+        static forceinline void getFields(const GridType* grid, const FP3& coords, FP3& e, FP3& b) {
+            grid->getFieldsPCS(coords, e, b);
+        }
+        static forceinline FP3 getE(const GridType* grid, const FP3& coords) {
+            return FP3(grid->getExPCS(coords), grid->getEyPCS(coords), grid->getEzPCS(coords));
+        }
+        static forceinline FP3 getB(const GridType* grid, const FP3& coords) {
+            return FP3(grid->getBxPCS(coords), grid->getByPCS(coords), grid->getBzPCS(coords));
+        }
+    };
+
+    /* Grid with the interpolation type fixed at compile time. It has the same
+    getFields, getE, getB interface as Grid and AnalyticalField, so it can be
+    given to pushers and QED handlers in their place. Unlike
+    Grid::setInterpolationType there is no call through a member pointer,
+    so interpolation is inlined into the particle loop. */
+    template <InterpolationType interpolationType, GridTypes gridType>
+    class Interpolator {
+    public:
+
+        typedef Grid<FP, gridType> GridType;
+        typedef InterpolationMethods<interpolationType, gridType> Methods;
+
+        Interpolator(const GridType* grid) : grid(grid) {}
+
+        const GridType* getGrid() const { return grid; }
+
+        static InterpolationType getInterpolationType() { return interpolationType; }
+
+        forceinline void getFields(const FP3& coords, FP3& e, FP3& b) const
+        {
+            Methods::getFields(grid, coords, e, b);
+        }
+
+        forceinline FP3 getE(const FP3& coords) const
+        {
+            return Methods::getE(grid, coords);
+        }
+
+        forceinline FP3 getB(const FP3& coords) const
+        {
+            return Methods::getB(grid, coords);
+        }
+
+    private:
+
+        const GridType* grid;
+    };
+}
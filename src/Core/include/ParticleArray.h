@@ -1,19 +1,110 @@
 #pragma once
 
 #include "Dimension.h"
+#include "macros.h"
 #include "Particle.h"
 #include "ParticleTypes.h"
 #include "ParticleTraits.h"
 #include "Vectors.h"
 #include "VectorsProxy.h"
 
+#include <algorithm>
+#include <cmath>
 #include <map>
 #include <vector>
 #include <string>
 #include <functional>
+#include <omp.h>
 
 namespace pfc {
 
+    /* Parallel compaction of arrays with particles marked as removed. Selected
+    elements of a block of compactionBlockSize elements go to places starting
+    from the prefix sum of numbers of selected elements of the previous blocks.
+    The stable compaction copies the kept elements in their order, the unstable
+    one moves the kept elements from the tail to the removed ones in the front. */
+    const int compactionBlockSize = 4096;
+
+    // computes places of blocks of [begin, end) for the elements with the mark equal to value,
+    // returns the number of such elements
+    inline int getBlockPlaces(const std::vector<char>& removed, int begin, int end, char value,
+        std::vector<int>& blockPlaces)
+    {
+        const int numBlocks = (end - begin + compactionBlockSize - 1) / compactionBlockSize;
+        blockPlaces.resize(numBlocks);
+        OMP_FOR()
+        for (int b = 0; b < numBlocks; b++) {
+            const int blockEnd = std::min(end, begin + (b + 1) * compactionBlockSize);
+            int count = 0;
+            for (int i = begin + b * compactionBlockSize; i < blockEnd; i++)
+                count += (removed[i] == value);
+            blockPlaces[b] = count;
+        }
+        int total = 0;
+        for (int b = 0; b < numBlocks; b++) {
+            int count = blockPlaces[b];
+            blockPlaces[b] = total;
+            total += count;
+        }
+        return total;
+    }
+
+    // indices of the elements of [begin, end) with the mark equal to value in increasing order
+    inline void getMarkedIndices(const std::vector<char>& removed, int begin, int end, char value,
+        std::vector<int>& indices)
+    {
+        std::vector<int> blockPlaces;
+        indices.resize(getBlockPlaces(removed, begin, end, value, blockPlaces));
+        OMP_FOR()
+        for (int b = 0; b < (int)blockPlaces.size(); b++) {
+            const int blockEnd = std::min(end, begin + (b + 1) * compactionBlockSize);
+            int place = blockPlaces[b];
+            for (int i = begin + b * compactionBlockSize; i < blockEnd; i++)
+                if (removed[i] == value)
+                    indices[place++] = i;
+        }
+    }
+
+    template<class T>
+    inline void compactColumn(std::vector<T>& column, const std::vector<char>& removed,
+        const std::vector<int>& blockPlaces, int numKept)
+    {
+        const int size = (int)removed.size();
+        std::vector<T> result(numKept);
+        OMP_FOR()
+        for (int b = 0; b < (int)blockPlaces.size(); b++) {
+            const int end = std::min(size, (b + 1) * compactionBlockSize);
+            int place = blockPlaces[b];
+            for (int i = b * compactionBlockSize; i < end; i++)
+                if (!removed[i])
+                    result[place++] = column[i];
+        }
+        column.swap(result);
+    }
+
+    template<class T>
+    inline void moveColumn(std::vector<T>& column, const std::vector<int>& holes,
+        const std::vector<int>& moved, int numKept)
+    {
+        OMP_FOR()
+        for (int i = 0; i < (int)holes.size(); i++)
+            column[holes[i]] = column[moved[i]];
+        column.resize(numKept);
+    }
+
+    /* The i-th element of the result is the order[i]-th element of the column.
+    The result is written to the buffer that is swapped with the column, so the
+    next column permuted with the buffer reuses the storage of this one. */
+    template<class T>
+    inline void permuteColumn(std::vector<T>& column, const std::vector<int>& order, std::vector<T>& buffer)
+    {
+        buffer.resize(order.size());
+        OMP_FOR()
+        for (int i = 0; i < (int)order.size(); i++)
+            buffer[i] = column[order[i]];
+        column.swap(buffer);
+    }
+
     template<typename pArray_t, typename ParticleType>
     class iteratorPArray : public std::iterator<std::random_access_iterator_tag, ParticleType, size_t>
     {
@@ -136,10 +227,56 @@ namespace pfc {
 
         inline void pushBack(ConstParticleRef particle) 
         { 
-            if(particle.getType() == typeIndex)
-                particles.push_back(particle); 
+            if (particle.getType() == typeIndex) {
+                particles.push_back(particle);
+                removed.push_back(0);
+            }
+        }
+
+        inline void reserve(int capacity)
+        {
+            particles.reserve(capacity);
+            removed.reserve(capacity);
+        }
+
+        // new particles are default ones at rest, they are to be set with setParticle
+        inline void resize(int newSize)
+        {
+            ParticleType particle;
+            particle.setType(typeIndex);
+            particles.resize(newSize, particle);
+            removed.resize(newSize, 0);
+        }
+
+        /* Appends n particles given by arrays of coordinates, momenta and weights,
+        coordinates above the dimension are not used and may be null,
+        weights may be null for the unit weights. The particles are set in parallel. */
+        void append(const FP* x, const FP* y, const FP* z, const FP* px, const FP* py, const FP* pz,
+            const FP* weight, int n)
+        {
+            const FP* coords[3] = { x, y, z };
+            const int first = this->size();
+            resize(first + n);
+            OMP_FOR()
+            for (int i = 0; i < n; i++) {
+                PositionType position;
+                for (int d = 0; d < VectorDimensionHelper<PositionType>::dimension; d++)
+                    position[d] = coords[d][i];
+                particles[first + i] = ParticleType(position, MomentumType(px[i], py[i], pz[i]),
+                    weight ? weight[i] : 1, typeIndex);
+            }
+        }
+
+        inline void setParticle(int idx, ConstParticleRef particle)
+        {
+            particles[idx] = particle;
+        }
+
+        inline void popBack()
+        {
+            particles.pop_back();
+            removed.pop_back();
         }
-        inline void popBack() { particles.pop_back(); }
 
         inline void deleteParticle(iterator& idx)
         {
@@ -152,13 +289,59 @@ namespace pfc {
             if (idx < this->size())
             {
                 std::swap(particles[idx], particles[this->size() - 1]);
+                std::swap(removed[idx], removed[this->size() - 1]);
                 particles.pop_back();
+                removed.pop_back();
+            }
+        }
+
+        // marked particles are kept until compact(), marking of different particles is thread-safe
+        inline void markRemoved(int idx)
+        {
+            removed[idx] = 1;
+        }
+
+        inline bool isRemoved(int idx) const
+        {
+            return removed[idx] != 0;
+        }
+
+        /* Removes the marked particles, the order of the rest is preserved if keepOrder.
+        Otherwise the last kept particles take places of the removed ones. */
+        void compact(bool keepOrder = true)
+        {
+            const int size = (int)this->size();
+            std::vector<int> blockPlaces;
+            int numKept = getBlockPlaces(removed, 0, size, 0, blockPlaces);
+            if (numKept == size)
+                return;
+            if (keepOrder)
+                compactColumn(particles, removed, blockPlaces, numKept);
+            else {
+                std::vector<int> holes, moved;
+                getMarkedIndices(removed, 0, numKept, 1, holes);
+                getMarkedIndices(removed, numKept, size, 0, moved);
+                moveColumn(particles, holes, moved, numKept);
             }
+            removed.assign(numKept, 0);
+        }
+
+        // removes the particles with true values of mask[idx]
+        template<class Mask>
+        void removeIf(const Mask& mask, bool keepOrder = true)
+        {
+            const int size = (int)this->size();
+            OMP_FOR()
+            for (int idx = 0; idx < size; idx++)
+                if (mask[idx])
+                    removed[idx] = 1;
+            compact(keepOrder);
         }
 
         inline void clear()
         {
             particles.clear();
+            removed.clear();
         }
 
         inline iterator begin() { return iterator(this, 0); }
@@ -169,6 +352,7 @@ namespace pfc {
     private:
         ParticleTypes typeIndex;
         std::vector<ParticleType> particles;
+        std::vector<char> removed;
     };
 
     // Collection of particles with array-like semantics,
@@ -203,7 +387,8 @@ namespace pfc {
 
         inline int size() const { return static_cast<int>(weights.size()); }
 
-        ParticleArraySoA(ParticleTypes type = Electron)
+        ParticleArraySoA(ParticleTypes type = Electron) :
+            sortPeriod(0), numSortSteps(0)
         {
             setType(type);
         }
@@ -237,9 +422,71 @@ namespace pfc {
                     ps[d].push_back(p[d]);
                 weights.push_back(particle.getWeight());
                 gammas.push_back(particle.getGamma());
+                removed.push_back(0);
             }
             
         }
+
+        inline void reserve(int capacity)
+        {
+            for (int d = 0; d < positionDimension; d++)
+                positions[d].reserve(capacity);
+            for (int d = 0; d < momentumDimension; d++)
+                ps[d].reserve(capacity);
+            weights.reserve(capacity);
+            gammas.reserve(capacity);
+            removed.reserve(capacity);
+        }
+
+        // new particles are default ones at rest, they are to be set with setParticle
+        inline void resize(int newSize)
+        {
+            for (int d = 0; d < positionDimension; d++)
+                positions[d].resize(newSize);
+            for (int d = 0; d < momentumDimension; d++)
+                ps[d].resize(newSize);
+            weights.resize(newSize, 1);
+            gammas.resize(newSize, 1);
+            removed.resize(newSize, 0);
+        }
+
+        inline void setParticle(int idx, ConstParticleRef particle)
+        {
+            const PositionType position = particle.getPosition();
+            for (int d = 0; d < positionDimension; d++)
+                positions[d][idx] = position[d];
+            const MomentumType p = particle.getP();
+            for (int d = 0; d < momentumDimension; d++)
+                ps[d][idx] = p[d];
+            weights[idx] = particle.getWeight();
+            gammas[idx] = particle.getGamma();
+        }
+
+        /* Appends n particles given by arrays of coordinates, momenta and weights,
+        coordinates above the dimension are not used and may be null,
+        weights may be null for the unit weights. The columns are filled in parallel. */
+        void append(const FP* x, const FP* y, const FP* z, const FP* px, const FP* py, const FP* pz,
+            const FP* weight, int n)
+        {
+            const FP* coords[3] = { x, y, z };
+            const FP* momenta[3] = { px, py, pz };
+            const FP momentumUnit = Constants<FP>::c() * ParticleInfo::types[typeIndex].mass;
+            const int first = this->size();
+            resize(first + n);
+            OMP_FOR()
+            for (int i = 0; i < n; i++) {
+                for (int d = 0; d < positionDimension; d++)
+                    positions[d][first + i] = coords[d][i];
+                FP p2 = 0;
+                for (int d = 0; d < momentumDimension; d++) {
+                    FP p = momenta[d][i] / momentumUnit;
+                    ps[d][first + i] = p;
+                    p2 += p * p;
+                }
+                weights[first + i] = weight ? weight[i] : 1;
+                gammas[first + i] = sqrt((FP)1 + p2);
+            }
+        }
         inline void popBack()
         {
             for (int d = 0; d < positionDimension; d++)
@@ -248,6 +495,7 @@ namespace pfc {
                 ps[d].pop_back();
             weights.pop_back();
             gammas.pop_back();
+            removed.pop_back();
         }
 
         inline void deleteParticle(iterator& idx)
@@ -276,7 +524,61 @@ namespace pfc {
                 weights.pop_back();
                 std::swap(gammas[idx], gammas[size - 1]);
                 gammas.pop_back();
+                std::swap(removed[idx], removed[size - 1]);
+                removed.pop_back();
+            }
+        }
+
+        // marked particles are kept until compact(), marking of different particles is thread-safe
+        inline void markRemoved(int idx)
+        {
+            removed[idx] = 1;
+        }
+
+        inline bool isRemoved(int idx) const
+        {
+            return removed[idx] != 0;
+        }
+
+        /* Removes the marked particles, the order of the rest is preserved if keepOrder.
+        Otherwise the last kept particles take places of the removed ones. */
+        void compact(bool keepOrder = true)
+        {
+            std::vector<int> blockPlaces;
+            int numKept = getBlockPlaces(removed, 0, this->size(), 0, blockPlaces);
+            if (numKept == this->size())
+                return;
+            if (keepOrder) {
+                for (int d = 0; d < positionDimension; d++)
+                    compactColumn(positions[d], removed, blockPlaces, numKept);
+                for (int d = 0; d < momentumDimension; d++)
+                    compactColumn(ps[d], removed, blockPlaces, numKept);
+                compactColumn(weights, removed, blockPlaces, numKept);
+                compactColumn(gammas, removed, blockPlaces, numKept);
             }
+            else {
+                std::vector<int> holes, moved;
+                getMarkedIndices(removed, 0, numKept, 1, holes);
+                getMarkedIndices(removed, numKept, this->size(), 0, moved);
+                for (int d = 0; d < positionDimension; d++)
+                    moveColumn(positions[d], holes, moved, numKept);
+                for (int d = 0; d < momentumDimension; d++)
+                    moveColumn(ps[d], holes, moved, numKept);
+                moveColumn(weights, holes, moved, numKept);
+                moveColumn(gammas, holes, moved, numKept);
+            }
+            removed.assign(numKept, 0);
+        }
+
+        // removes the particles with true values of mask[idx]
+        template<class Mask>
+        void removeIf(const Mask& mask, bool keepOrder = true)
+        {
+            OMP_FOR()
+            for (int idx = 0; idx < this->size(); idx++)
+                if (mask[idx])
+                    removed[idx] = 1;
+            compact(keepOrder);
         }
 
         inline void clear()
@@ -287,6 +589,8 @@ namespace pfc {
                 ps[d].clear();
             weights.clear();
             gammas.clear();
+            removed.clear();
+            cellOffsets.clear();
         }
 
         inline iterator begin() { return iterator(this, 0); }
@@ -294,11 +598,142 @@ namespace pfc {
         inline const iterator cbegin() { return begin(); }
         inline const iterator cend() { return end(); }
 
+        /* Columns of particle data of size() elements. The pointers stay valid while
+        the columns are not reallocated: pushBack, append, resize and reserve over
+        the capacity, compact, removeIf, permute, sortByCell and clear may invalidate them.
+        Momenta are in units of mc, a changed momentum needs an updated gamma. */
+        inline typename ScalarType<PositionType>::Type* getPositionData(int d) { return positions[d].data(); }
+        inline typename ScalarType<MomentumType>::Type* getPData(int d) { return ps[d].data(); }
+        inline WeightType* getWeightData() { return weights.data(); }
+        inline GammaType* getGammaData() { return gammas.data(); }
+
+        // recomputes gammas after the momenta were changed through getPData
+        void updateGammas()
+        {
+            OMP_FOR()
+            for (int idx = 0; idx < this->size(); idx++) {
+                GammaType p2 = 0;
+                for (int d = 0; d < momentumDimension; d++)
+                    p2 += ps[d][idx] * ps[d][idx];
+                gammas[idx] = sqrt((GammaType)1 + p2);
+            }
+        }
+
+        /* Reorders the particles, the new idx-th particle is the old order[idx]-th one.
+        The columns are permuted one by one through a buffer, so a single extra column
+        is allocated. */
+        void permute(const std::vector<int>& order)
+        {
+            std::vector<FP> buffer;
+            for (int d = 0; d < positionDimension; d++)
+                permuteColumn(positions[d], order, buffer);
+            for (int d = 0; d < momentumDimension; d++)
+                permuteColumn(ps[d], order, buffer);
+            permuteColumn(weights, order, buffer);
+            permuteColumn(gammas, order, buffer);
+            std::vector<char> removedBuffer;
+            permuteColumn(removed, order, removedBuffer);
+        }
+
+        /* Sorts particles by cells with the counting sort. The cells are numCells cells
+        of a grid with the given origin and steps starting at the cell begin, particles
+        outside of them go to the boundary cells. Chunks of particles are counted and
+        scattered in parallel, each with a histogram of its own; the number of chunks is
+        limited so that the histograms take at most twice as much memory as the indices. */
+        void sortByCell(const FP3& origin, const FP3& steps, const Int3& begin, const Int3& numCells)
+        {
+            const int n = this->size();
+            const int numSortCells = numCells.x * numCells.y * numCells.z;
+            std::vector<int> cellIdx(n);
+            OMP_FOR()
+            for (int idx = 0; idx < n; idx++) {
+                Int3 cell(0, 0, 0);
+                for (int d = 0; d < positionDimension; d++) {
+                    FP x = std::floor((positions[d][idx] - origin[d]) / steps[d]) - begin[d];
+                    cell[d] = (int)std::min(std::max(x, (FP)0), (FP)(numCells[d] - 1));
+                }
+                cellIdx[idx] = (cell.x * numCells.y + cell.y) * numCells.z + cell.z;
+            }
+
+            const int numThreads = omp_in_parallel() ? 1 : omp_get_max_threads();
+            const int numChunks = std::max(1, std::min(numThreads, 2 * n / std::max(numSortCells, 1)));
+            const int chunkSize = (n + numChunks - 1) / numChunks;
+            std::vector<int> places((size_t)numChunks * numSortCells, 0);
+            OMP_FOR()
+            for (int chunk = 0; chunk < numChunks; chunk++) {
+                int* chunkCounts = places.data() + (size_t)chunk * numSortCells;
+                const int chunkEnd = std::min(n, (chunk + 1) * chunkSize);
+                for (int idx = chunk * chunkSize; idx < chunkEnd; idx++)
+                    chunkCounts[cellIdx[idx]]++;
+            }
+
+            // cellOffsets are the prefix sums of the cell totals, a chunk starts
+            // in the cell after the particles of the previous chunks
+            cellOffsets.assign(numSortCells + 1, 0);
+            OMP_FOR()
+            for (int c = 0; c < numSortCells; c++)
+                for (int chunk = 0; chunk < numChunks; chunk++)
+                    cellOffsets[c + 1] += places[(size_t)chunk * numSortCells + c];
+            for (int c = 0; c < numSortCells; c++)
+                cellOffsets[c + 1] += cellOffsets[c];
+            OMP_FOR()
+            for (int c = 0; c < numSortCells; c++) {
+                int place = cellOffsets[c];
+                for (int chunk = 0; chunk < numChunks; chunk++) {
+                    int& chunkPlace = places[(size_t)chunk * numSortCells + c];
+                    const int count = chunkPlace;
+                    chunkPlace = place;
+                    place += count;
+                }
+            }
+
+            std::vector<int> order(n);
+            OMP_FOR()
+            for (int chunk = 0; chunk < numChunks; chunk++) {
+                int* chunkPlaces = places.data() + (size_t)chunk * numSortCells;
+                const int chunkEnd = std::min(n, (chunk + 1) * chunkSize);
+                for (int idx = chunk * chunkSize; idx < chunkEnd; idx++)
+                    order[chunkPlaces[cellIdx[idx]]++] = idx;
+            }
+            permute(order);
+        }
+
+        // sorts particles by cells of the grid
+        template<class TGrid>
+        void sortByCell(const TGrid* grid)
+        {
+            sortByCell(grid->origin, grid->steps, Int3(0, 0, 0), grid->numCells);
+        }
+
+        int getSortPeriod() const { return sortPeriod; }
+        void setSortPeriod(int period) { sortPeriod = period; numSortSteps = 0; }
+
+        /* Is called once per step, every sortPeriod-th call sorts particles by cells
+        of the grid if sortPeriod > 0. */
+        template<class TGrid>
+        void sortByCellPeriodically(const TGrid* grid)
+        {
+            numSortSteps++;
+            if (sortPeriod > 0 && numSortSteps % sortPeriod == 0)
+                sortByCell(grid);
+        }
+
+        /* After sortByCell() particles of the cell (i, j, k) are [offsets[c], offsets[c + 1])
+        for c = (i * numCells.y + j) * numCells.z + k. The offsets are valid until the
+        array is changed. */
+        const std::vector<int>& getCellOffsets() const
+        {
+            return cellOffsets;
+        }
+
     private:
         std::vector<typename ScalarType<PositionType>::Type> positions[positionDimension];
         std::vector<typename ScalarType<MomentumType>::Type> ps[momentumDimension];
         std::vector<WeightType> weights;
         std::vector<GammaType> gammas;
+        std::vector<char> removed;
+        std::vector<int> cellOffsets;
+        int sortPeriod, numSortSteps;
         ParticleTypes typeIndex;
     };
 
@@ -0,0 +1,88 @@
+#pragma once
+#include "macros.h"
+#include "FP.h"
+
+#include <cstdint>
+
+namespace pfc {
+
+    /* Counter-based random number generator Philox4x32-10 (J.K. Salmon et al.,
+    "Parallel random numbers: as easy as 1, 2, 3", SC'11). The output is a
+    function of a key and a counter, so any number of independent streams
+    needs neither shared state nor locks. */
+    class Philox4x32 {
+    public:
+
+        struct Counter {
+            uint32_t v[4];
+        };
+
+        struct Key {
+            uint32_t v[2];
+        };
+
+        static forceinline Counter generate(Counter counter, Key key)
+        {
+            counter = round(counter, key);
+            for (int r = 1; r < 10; r++) {
+                key.v[0] += 0x9E3779B9;
+                key.v[1] += 0xBB67AE85;
+                counter = round(counter, key);
+            }
+            return counter;
+        }
+
+    private:
+
+        static forceinline Counter round(const Counter& counter, const Key& key)
+        {
+            const uint64_t product0 = (uint64_t)0xD2511F53 * counter.v[0];
+            const uint64_t product1 = (uint64_t)0xCD9E8D57 * counter.v[2];
+            Counter result;
+            result.v[0] = (uint32_t)(product1 >> 32) ^ counter.v[1] ^ key.v[0];
+            result.v[1] = (uint32_t)product1;
+            result.v[2] = (uint32_t)(product0 >> 32) ^ counter.v[3] ^ key.v[1];
+            result.v[3] = (uint32_t)product0;
+            return result;
+        }
+    };
+
+    /* Stream of uniformly distributed in [0, 1) numbers given by a seed and
+    three stream ids (e.g. time step, kind of particles and particle index).
+    The same seed and ids give the same numbers on any thread. */
+    class RandomStream {
+    public:
+
+        RandomStream(uint64_t seed = 0, uint32_t id0 = 0, uint32_t id1 = 0, uint32_t id2 = 0)
+        {
+            key.v[0] = (uint32_t)seed;
+            key.v[1] = (uint32_t)(seed >> 32);
+            counter.v[0] = 0;
+            counter.v[1] = id0;
+            counter.v[2] = id1;
+            counter.v[3] = id2;
+            position = 2;
+        }
+
+        forceinline FP next()
+        {
+            if (position == 2) {
+                const Philox4x32::Counter bits = Philox4x32::generate(counter, key);
+                counter.v[0]++;
+                // 53 random bits per double
+                for (int i = 0; i < 2; i++)
+                    values[i] = ((bits.v[2 * i] >> 5) * 67108864.0 + (bits.v[2 * i + 1] >> 6)) *
+                        (1.0 / 9007199254740992.0);
+                position = 0;
+            }
+            return (FP)values[position++];
+        }
+
+    private:
+
+        Philox4x32::Key key;
+        Philox4x32::Counter counter;  // counter.v[0] is the number of the block in the stream
+        double values[2];
+        int position;
+    };
+}
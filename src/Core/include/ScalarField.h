@@ -1,6 +1,8 @@
 #pragma once
+#include <algorithm>
 #include <vector>
 
+#include "macros.h"
 #include "FormFactor.h"
 #include "Vectors.h"
 #include "VectorsProxy.h"
@@ -9,6 +11,57 @@
 
 namespace pfc {
 
+    /* Order of values in memory. RowMajor is k + (j + i * size.y) * size.z.
+    Bricks stores small cubes of brickSize^3 values (brickSize along each
+    dimension larger than 1) contiguously, so interpolation and deposition
+    stencils touch fewer cache lines and pages. Interleaved is RowMajor with
+    values of several fields alternating in common memory, so the field is
+    a view with a stride. Padded is RowMajor with the row length (pitch) along z
+    rounded up to 64 bytes, so each row starts at an aligned address. Only
+    RowMajor fields can share memory with FFT. */
+    enum ScalarFieldLayout {
+        ScalarFieldLayout_RowMajor, ScalarFieldLayout_Bricks, ScalarFieldLayout_Interleaved,
+        ScalarFieldLayout_Padded
+    };
+
+    /* Move values of size.x * size.y rows of rowLength values to memory first
+    touched row by row by the threads of OMP_FOR_COLLAPSE() over (i, j) in
+    [begin, end), rows outside of the area are touched by the thread of the
+    nearest row in it. A solver loop over the same area then updates memory of
+    the NUMA node of its thread. */
+    template <class Data>
+    inline void placeStorageRows(std::vector<Data, NUMA_Allocator<Data>>& storage, const Int3& size,
+        int rowLength, const Int3& begin, const Int3& end)
+    {
+        if (storage.size() != (size_t)size.x * size.y * rowLength)
+            throw "Storage does not consist of rows";
+        Int3 first = begin, last = end;
+        if (!(first.x >= 0 && first.x < last.x && last.x <= size.x)) {
+            first.x = 0;
+            last.x = size.x;
+        }
+        if (!(first.y >= 0 && first.y < last.y && last.y <= size.y)) {
+            first.y = 0;
+            last.y = size.y;
+        }
+        std::vector<Data, NUMA_Allocator<Data>> placed(storage.size(), NUMA_Allocator<Data>(false));
+        const Data* src = storage.data();
+        Data* dst = placed.data();
+        OMP_FOR_COLLAPSE()
+        for (int i = first.x; i < last.x; i++)
+            for (int j = first.y; j < last.y; j++)
+            {
+                const int iMin = (i == first.x) ? 0 : i, iMax = (i == last.x - 1) ? size.x : i + 1;
+                const int jMin = (j == first.y) ? 0 : j, jMax = (j == last.y - 1) ? size.y : j + 1;
+                for (int ii = iMin; ii < iMax; ii++)
+                    for (int jj = jMin; jj < jMax; jj++) {
+                        const size_t offset = ((size_t)ii * size.y + jj) * rowLength;
+                        std::copy(src + offset, src + offset + rowLength, dst + offset);
+                    }
+            }
+        storage.swap(placed);
+    }
+
     /* Class for storing 3d scalar field on a regular grid.
     Provides index-wise access, interpolation and deposition.*/
     template <typename Data>
@@ -20,6 +73,7 @@ namespace pfc {
         ScalarField(const Int3& size);
         ScalarField(const ScalarField<Data>& field, bool ifShallowCopy = false);
         ScalarField(Data* data, const Int3& size);
+        ScalarField(Data* data, const Int3& size, int stride);  // interleaved view
         ScalarField& operator =(const ScalarField& field);
 
         ScalarField createShallowCopy() {  // common memory
@@ -40,31 +94,97 @@ namespace pfc {
             return size;
         }
 
+        // number of elements in memory, can be larger than getSize().volume()
+        int getStorageSize() const {
+            return storageSize;
+        }
+
+        ScalarFieldLayout getLayout() const {
+            return layout;
+        }
+
+        // distance between rows along z in memory
+        int getPitch() const {
+            return pitch;
+        }
+
+        // distances in memory between neighboring values along each dimension,
+        // the brick layout can't be described by strides
+        Int3 getStrides() const {
+            if (layout == ScalarFieldLayout_Bricks)
+                throw "Brick layout of scalar field has no strides";
+            return Int3(size.y * pitch * stride, pitch * stride, stride);
+        }
+
+        /* Reorder values in memory, brickSize must be a power of 2.
+        The field must own its storage. */
+        void setLayout(ScalarFieldLayout layout, int brickSize = 4);
+
+        /* Position of value (i, j, k) in memory */
+        forceinline int index(int i, int j, int k) const
+        {
+            // the pitch is size.z and the stride is 1 for the row-major layout
+            return (layout == ScalarFieldLayout_Bricks) ? index<ScalarFieldLayout_Bricks>(i, j, k) :
+                (k + (j + i * size.y) * pitch) * stride;
+        }
+
+        /* Position of value (i, j, k) in memory for the layout known at compile time,
+        lets loops over row-major fields be vectorized. */
+        template <ScalarFieldLayout fieldLayout>
+        forceinline int index(int i, int j, int k) const
+        {
+            return (fieldLayout == ScalarFieldLayout_Bricks) ? brickIndex(i, j, k) :
+                (fieldLayout == ScalarFieldLayout_Interleaved) ? (k + (j + i * size.y) * size.z) * stride :
+                (fieldLayout == ScalarFieldLayout_Padded) ? k + (j + i * size.y) * pitch :
+                k + (j + i * size.y) * size.z;
+        }
+
+        template <ScalarFieldLayout fieldLayout>
+        forceinline Data at(int i, int j, int k) const
+        {
+            return raw[index<fieldLayout>(i, j, k)];
+        }
+
+        template <ScalarFieldLayout fieldLayout>
+        forceinline Data& at(int i, int j, int k)
+        {
+            return raw[index<fieldLayout>(i, j, k)];
+        }
+
         /* Read-only access by scalar indexes */
         Data operator()(int i, int j, int k) const
         {
-            return raw[k + (j + i * size.y) * size.z];
+            return raw[index(i, j, k)];
         }
 
         /* Read-write access by scalar indexes */
         Data& operator()(int i, int j, int k)
         {
-            return raw[k + (j + i * size.y) * size.z];
+            return raw[index(i, j, k)];
         }
 
         /* Read-only access by vector index */
         Data operator()(const Int3& index) const
         {
-            return raw[index.z + (index.y + index.x * size.y) * size.z];
+            return raw[this->index(index.x, index.y, index.z)];
         }
 
         /* Read-write access by vector index */
         Data& operator()(const Int3& index)
         {
-            return raw[index.z + (index.y + index.x * size.y) * size.z];
+            return raw[this->index(index.x, index.y, index.z)];
         }
 
-        /* Interpolation: with given base index and coefficients */
+        /* Make all values zero. */
+        void zeroize();
+
+        /* Move values to memory first touched with the partitioning of OMP_FOR_COLLAPSE()
+        over (i, j) in [begin, end), see placeStorageRows. Needs a row-major or padded
+        layout and own storage, pointers to the data become invalid. */
+        void placeRows(const Int3& begin, const Int3& end);
+
+        /* Interpolation: with given base index and coefficients. The layout is
+        dispatched once per call, values of the stencil are read with at<layout>. */
         FP interpolateCIC(const Int3& baseIdx, const FP3& coeffs) const;
         FP interpolateTSC(const Int3& baseIdx, const FP3& coeffs) const;
         FP interpolateSecondOrder(const Int3& baseIdx, const FP3& coeffs) const;
@@ -74,24 +194,82 @@ namespace pfc {
     private:
 
         FP interpolateThreePoints(const Int3& baseIdx, FP c[3][3]) const;
+
+        template <ScalarFieldLayout fieldLayout>
+        FP interpolateCICWithLayout(const Int3& baseIdx, const FP3& coeffs) const;
+        template <ScalarFieldLayout fieldLayout>
+        FP interpolateThreePointsWithLayout(const Int3& baseIdx, FP c[3][3]) const;
+        template <ScalarFieldLayout fieldLayout>
+        FP interpolateFourthOrderWithLayout(const Int3& baseIdx, const FP3& coeffs) const;
+        template <ScalarFieldLayout fieldLayout>
+        FP interpolatePCSWithLayout(const Int3& baseIdx, const FP3& coeffs) const;
+
+        forceinline int brickIndex(int i, int j, int k) const
+        {
+            const int brick = ((i >> brickShift.x) * numBricks.y + (j >> brickShift.y)) * numBricks.z +
+                (k >> brickShift.z);
+            const int inBrick = ((((i & brickMask.x) << brickShift.y) + (j & brickMask.y)) << brickShift.z) +
+                (k & brickMask.z);
+            return (brick << brickVolumeShift) + inBrick;
+        }
+
+        void setDimensionCoeffs()
+        {
+            for (int d = 0; d < 3; d++) {
+                dimensionCoeffInt[d] = (size[d] > 1) ? 1 : 0;
+                dimensionCoeffFP[d] = (FP)dimensionCoeffInt[d];
+            }
+        }
+
+        void setBrickCoeffs(int shift)
+        {
+            pitch = size.z;
+            brickVolumeShift = 0;
+            for (int d = 0; d < 3; d++) {
+                brickShift[d] = (size[d] > 1) ? shift : 0;
+                brickMask[d] = (1 << brickShift[d]) - 1;
+                numBricks[d] = (size[d] + brickMask[d]) >> brickShift[d];
+                brickVolumeShift += brickShift[d];
+            }
+            storageSize = numBricks.volume() << brickVolumeShift;
+        }
+
+        void copyLayout(const ScalarField& field)
+        {
+            storageSize = field.storageSize;
+            layout = field.layout;
+            brickShift = field.brickShift;
+            brickMask = field.brickMask;
+            numBricks = field.numBricks;
+            brickVolumeShift = field.brickVolumeShift;
+            stride = field.stride;
+            pitch = field.pitch;
+        }
+
         bool ifStorage = true;  // if it's false then "elements" is empty, "raw" is a pointer to the data
         std::vector<Data, NUMA_Allocator<Data>> elements; // storage
         Data* raw; // raw pointer to elements vector
         Int3 size; // size of each dimension
+        int storageSize = 0; // number of elements in memory
         Int3 dimensionCoeffInt; // 0 for fake dimensions, 1 otherwise
         FP3 dimensionCoeffFP; // 0 for fake dimensions, 1 otherwise
+
+        // brick layout: log2 and mask of the brick size, number of bricks along each dimension
+        ScalarFieldLayout layout = ScalarFieldLayout_RowMajor;
+        Int3 brickShift, brickMask, numBricks;
+        int brickVolumeShift = 0;
+        int stride = 1;  // distance between neighboring values in memory for the interleaved layout
+        int pitch = 0;  // distance between rows along z in memory
     };
 
     template <class Data>
     inline ScalarField<Data>::ScalarField(const Int3& _size)
     {
         size = _size;
-        elements.resize(size.volume());
+        setBrickCoeffs(0);
+        elements.resize(storageSize);
         raw = elements.data();
-        for (int d = 0; d < 3; d++) {
-            dimensionCoeffInt[d] = (size[d] > 1) ? 1 : 0;
-            dimensionCoeffFP[d] = (FP)dimensionCoeffInt[d];
-        }
+        setDimensionCoeffs();
     }
 
     template <class Data>
@@ -106,6 +284,7 @@ namespace pfc {
         else {
             raw = field.raw;
         }
+        copyLayout(field);
         dimensionCoeffInt = field.dimensionCoeffInt;
         dimensionCoeffFP = field.dimensionCoeffFP;
     }
@@ -114,12 +293,22 @@ namespace pfc {
     inline ScalarField<Data>::ScalarField(Data * data, const Int3 & _size)
     {
         size = _size;
+        setBrickCoeffs(0);
         ifStorage = false;
         raw = data;
-        for (int d = 0; d < 3; d++) {
-            dimensionCoeffInt[d] = (size[d] > 1) ? 1 : 0;
-            dimensionCoeffFP[d] = (FP)dimensionCoeffInt[d];
-        }
+        setDimensionCoeffs();
+    }
+
+    template<typename Data>
+    inline ScalarField<Data>::ScalarField(Data * data, const Int3 & _size, int _stride)
+    {
+        size = _size;
+        setBrickCoeffs(0);
+        ifStorage = false;
+        raw = data;
+        layout = ScalarFieldLayout_Interleaved;
+        stride = _stride;
+        setDimensionCoeffs();
     }
 
     template <class Data>
@@ -134,22 +323,118 @@ namespace pfc {
         else {
             raw = field.raw;
         }
+        copyLayout(field);
         dimensionCoeffInt = field.dimensionCoeffInt;
         dimensionCoeffFP = field.dimensionCoeffFP;
         return *this;
     }
 
+    template <class Data>
+    inline void ScalarField<Data>::setLayout(ScalarFieldLayout newLayout, int brickSize)
+    {
+        if (!ifStorage)
+            throw "Can't change layout of scalar field without own storage";
+        if (newLayout == ScalarFieldLayout_Interleaved)
+            throw "Interleaved layout needs common memory of several fields";
+        if (brickSize < 1 || (brickSize & (brickSize - 1)))
+            throw "Brick size must be a power of 2";
+
+        ScalarField<Data> old(*this);
+        layout = newLayout;
+        int shift = 0;
+        if (layout == ScalarFieldLayout_Bricks)
+            while ((1 << shift) < brickSize)
+                shift++;
+        setBrickCoeffs(shift);
+        if (layout == ScalarFieldLayout_Padded && size.z > 1) {
+            const int rowAlignment = (int)(NUMA_Allocator<Data>::alignment / sizeof(Data));
+            if (rowAlignment > 1) {
+                pitch = (size.z + rowAlignment - 1) / rowAlignment * rowAlignment;
+                storageSize = size.x * size.y * pitch;
+            }
+        }
+
+        elements = std::vector<Data, NUMA_Allocator<Data>>(storageSize);
+        raw = elements.data();
+        OMP_FOR()
+        for (int i = 0; i < size.x; i++)
+            for (int j = 0; j < size.y; j++)
+                for (int k = 0; k < size.z; k++)
+                    (*this)(i, j, k) = old(i, j, k);
+    }
+
+    template <class Data>
+    inline void ScalarField<Data>::placeRows(const Int3& begin, const Int3& end)
+    {
+        if (!ifStorage)
+            throw "Can't move memory of scalar field without own storage";
+        if (layout == ScalarFieldLayout_Bricks)
+            throw "Memory can be placed by rows only for row-major layouts";
+        placeStorageRows(elements, size, pitch, begin, end);
+        raw = elements.data();
+    }
+
+    // calls function<layout> args for the layout of the field
+#define PFC_SCALAR_FIELD_LAYOUT_DISPATCH(function, args) \
+    switch (layout) { \
+    case ScalarFieldLayout_Bricks: \
+        return function<ScalarFieldLayout_Bricks> args; \
+    case ScalarFieldLayout_Interleaved: \
+        return function<ScalarFieldLayout_Interleaved> args; \
+    case ScalarFieldLayout_Padded: \
+        return function<ScalarFieldLayout_Padded> args; \
+    default: \
+        return function<ScalarFieldLayout_RowMajor> args; \
+    }
+
+    template <class Data>
+    inline FP ScalarField<Data>::interpolateCIC(const Int3& baseIdx, const FP3& coeffs) const
+    {
+        PFC_SCALAR_FIELD_LAYOUT_DISPATCH(interpolateCICWithLayout, (baseIdx, coeffs))
+    }
+
+    template <class Data>
+    inline FP ScalarField<Data>::interpolateThreePoints(const Int3& baseIdx, FP c[3][3]) const
+    {
+        PFC_SCALAR_FIELD_LAYOUT_DISPATCH(interpolateThreePointsWithLayout, (baseIdx, c))
+    }
+
+    template <class Data>
+    inline FP ScalarField<Data>::interpolateFourthOrder(const Int3& baseIdx, const FP3& coeffs) const
+    {
+        PFC_SCALAR_FIELD_LAYOUT_DISPATCH(interpolateFourthOrderWithLayout, (baseIdx, coeffs))
+    }
+
+    template <class Data>
+    inline FP ScalarField<Data>::interpolatePCS(const Int3& baseIdx, const FP3& coeffs) const
+    {
+        PFC_SCALAR_FIELD_LAYOUT_DISPATCH(interpolatePCSWithLayout, (baseIdx, coeffs))
+    }
+
+#undef PFC_SCALAR_FIELD_LAYOUT_DISPATCH
+
+    template <class Data>
+    inline void ScalarField<Data>::zeroize()
+    {
+        const int n = storageSize;
+        const int step = stride;
+        OMP_FOR()
+        for (int i = 0; i < n; i++)
+            raw[i * step] = Data();
+    }
+
     template <>
-    inline FP ScalarField<FP>::interpolateCIC(const Int3& baseIdx, const FP3& coeffs) const
+    template <ScalarFieldLayout fieldLayout>
+    inline FP ScalarField<FP>::interpolateCICWithLayout(const Int3& baseIdx, const FP3& coeffs) const
     {
         FP3 c = coeffs * dimensionCoeffFP;
         FP3 invC = FP3(1, 1, 1) - c;
         Int3 base = (baseIdx * dimensionCoeffInt) % size;  // % size for spectral grids
         Int3 next = (base + dimensionCoeffInt) % size;
-        return invC.x * (invC.y * (invC.z * (*this)(base.x, base.y, base.z) + c.z * (*this)(base.x, base.y, next.z)) +
-                            c.y * (invC.z * (*this)(base.x, next.y, base.z) + c.z * (*this)(base.x, next.y, next.z))) +
-                  c.x * (invC.y * (invC.z * (*this)(next.x, base.y, base.z) + c.z * (*this)(next.x, base.y, next.z)) +
-                            c.y * (invC.z * (*this)(next.x, next.y, base.z) + c.z * (*this)(next.x, next.y, next.z)));
+        return invC.x * (invC.y * (invC.z * at<fieldLayout>(base.x, base.y, base.z) + c.z * at<fieldLayout>(base.x, base.y, next.z)) +
+                            c.y * (invC.z * at<fieldLayout>(base.x, next.y, base.z) + c.z * at<fieldLayout>(base.x, next.y, next.z))) +
+                  c.x * (invC.y * (invC.z * at<fieldLayout>(next.x, base.y, base.z) + c.z * at<fieldLayout>(next.x, base.y, next.z)) +
+                            c.y * (invC.z * at<fieldLayout>(next.x, next.y, base.z) + c.z * at<fieldLayout>(next.x, next.y, next.z)));
     }
     
     template <class Data>
@@ -182,7 +467,8 @@ namespace pfc {
     }
     
     template <>
-    inline FP ScalarField<FP>::interpolateThreePoints(const Int3& baseIdx, FP c[3][3]) const
+    template <ScalarFieldLayout fieldLayout>
+    inline FP ScalarField<FP>::interpolateThreePointsWithLayout(const Int3& baseIdx, FP c[3][3]) const
     {
         for (int d = 0; d < 3; d++)
             if (!dimensionCoeffInt[d]) {
@@ -197,12 +483,13 @@ namespace pfc {
         for (int ii = minIndex.x; ii <= maxIndex.x; ii++)
             for (int jj = minIndex.y; jj <= maxIndex.y; jj++)
                 for (int kk = minIndex.z; kk <= maxIndex.z; kk++)
-                    result += c[0][ii + 1] * c[1][jj + 1] * c[2][kk + 1] * (*this)(base.x + ii, base.y + jj, base.z + kk);
+                    result += c[0][ii + 1] * c[1][jj + 1] * c[2][kk + 1] * at<fieldLayout>(base.x + ii, base.y + jj, base.z + kk);
         return result;
     }
 
     template <>
-    inline FP ScalarField<FP>::interpolateFourthOrder(const Int3& baseIdx, const FP3& coeffs) const
+    template <ScalarFieldLayout fieldLayout>
+    inline FP ScalarField<FP>::interpolateFourthOrderWithLayout(const Int3& baseIdx, const FP3& coeffs) const
     {
         Int3 base = baseIdx * dimensionCoeffInt;
         const Int3 minAllowedIdx = Int3(2, 2, 2) * dimensionCoeffInt;
@@ -227,12 +514,13 @@ namespace pfc {
         for (int ii = minIndex.x; ii <= maxIndex.x; ii++)
             for (int jj = minIndex.y; jj <= maxIndex.y; jj++)
                 for (int kk = minIndex.z; kk <= maxIndex.z; kk++)
-                    result += c[0][ii + 2] * c[1][jj + 2] * c[2][kk + 2] * (*this)(base.x + ii, base.y + jj, base.z + kk);
+                    result += c[0][ii + 2] * c[1][jj + 2] * c[2][kk + 2] * at<fieldLayout>(base.x + ii, base.y + jj, base.z + kk);
         return result;
     }
 
     template <>
-    inline FP ScalarField<FP>::interpolatePCS(const Int3& baseIdx, const FP3& coeffs) const
+    template <ScalarFieldLayout fieldLayout>
+    inline FP ScalarField<FP>::interpolatePCSWithLayout(const Int3& baseIdx, const FP3& coeffs) const
     {
         FP c[3][4];
         for (int i = 0; i < 4; i++)
@@ -255,25 +543,27 @@ namespace pfc {
         for (int ii = minIndex.x; ii <= maxIndex.x; ii++)
             for (int jj = minIndex.y; jj <= maxIndex.y; jj++)
                 for (int kk = minIndex.z; kk <= maxIndex.z; kk++)
-                    result += c[0][ii] * c[1][jj] * c[2][kk] * (*this)(base.x + ii, base.y + jj, base.z + kk);
+                    result += c[0][ii] * c[1][jj] * c[2][kk] * at<fieldLayout>(base.x + ii, base.y + jj, base.z + kk);
         return result;
     }
 
     template <>
-    inline FP ScalarField<complex>::interpolateCIC(const Int3& baseIdx, const FP3& coeffs) const
+    template <ScalarFieldLayout fieldLayout>
+    inline FP ScalarField<complex>::interpolateCICWithLayout(const Int3& baseIdx, const FP3& coeffs) const
     {
         FP3 c = coeffs * dimensionCoeffFP;
         FP3 invC = FP3(1, 1, 1) - c;
         Int3 base = baseIdx * dimensionCoeffInt;
         Int3 next = base + dimensionCoeffInt;
-        return invC.x * (invC.y * (invC.z * (*this)(base.x, base.y, base.z).real + c.z * (*this)(base.x, base.y, next.z).real) +
-            c.y * (invC.z * (*this)(base.x, next.y, base.z).real + c.z * (*this)(base.x, next.y, next.z).real)) +
-            c.x * (invC.y * (invC.z * (*this)(next.x, base.y, base.z).real + c.z * (*this)(next.x, base.y, next.z).real) +
-                c.y * (invC.z * (*this)(next.x, next.y, base.z).real + c.z * (*this)(next.x, next.y, next.z).real));
+        return invC.x * (invC.y * (invC.z * at<fieldLayout>(base.x, base.y, base.z).real + c.z * at<fieldLayout>(base.x, base.y, next.z).real) +
+            c.y * (invC.z * at<fieldLayout>(base.x, next.y, base.z).real + c.z * at<fieldLayout>(base.x, next.y, next.z).real)) +
+            c.x * (invC.y * (invC.z * at<fieldLayout>(next.x, base.y, base.z).real + c.z * at<fieldLayout>(next.x, base.y, next.z).real) +
+                c.y * (invC.z * at<fieldLayout>(next.x, next.y, base.z).real + c.z * at<fieldLayout>(next.x, next.y, next.z).real));
     }
     
     template <>
-    inline FP ScalarField<complex>::interpolateThreePoints(const Int3& baseIdx, FP c[3][3]) const
+    template <ScalarFieldLayout fieldLayout>
+    inline FP ScalarField<complex>::interpolateThreePointsWithLayout(const Int3& baseIdx, FP c[3][3]) const
     {
         for (int d = 0; d < 3; d++)
             if (!dimensionCoeffInt[d]) {
@@ -288,12 +578,13 @@ namespace pfc {
         for (int ii = minIndex.x; ii <= maxIndex.x; ii++)
             for (int jj = minIndex.y; jj <= maxIndex.y; jj++)
                 for (int kk = minIndex.z; kk <= maxIndex.z; kk++)
-                    result += c[0][ii + 1] * c[1][jj + 1] * c[2][kk + 1] * (*this)(base.x + ii, base.y + jj, base.z + kk).real;
+                    result += c[0][ii + 1] * c[1][jj + 1] * c[2][kk + 1] * at<fieldLayout>(base.x + ii, base.y + jj, base.z + kk).real;
         return result;
     }
 
     template <>
-    inline FP ScalarField<complex>::interpolateFourthOrder(const Int3& baseIdx, const FP3& coeffs) const
+    template <ScalarFieldLayout fieldLayout>
+    inline FP ScalarField<complex>::interpolateFourthOrderWithLayout(const Int3& baseIdx, const FP3& coeffs) const
     {
         Int3 base = baseIdx * dimensionCoeffInt;
         const Int3 minAllowedIdx = Int3(2, 2, 2) * dimensionCoeffInt;
@@ -318,12 +609,13 @@ namespace pfc {
         for (int ii = minIndex.x; ii <= maxIndex.x; ii++)
             for (int jj = minIndex.y; jj <= maxIndex.y; jj++)
                 for (int kk = minIndex.z; kk <= maxIndex.z; kk++)
-                    result += c[0][ii + 2] * c[1][jj + 2] * c[2][kk + 2] * (*this)(base.x + ii, base.y + jj, base.z + kk).real;
+                    result += c[0][ii + 2] * c[1][jj + 2] * c[2][kk + 2] * at<fieldLayout>(base.x + ii, base.y + jj, base.z + kk).real;
         return result;
     }
 
     template <>
-    inline FP ScalarField<complex>::interpolatePCS(const Int3& baseIdx, const FP3& coeffs) const
+    template <ScalarFieldLayout fieldLayout>
+    inline FP ScalarField<complex>::interpolatePCSWithLayout(const Int3& baseIdx, const FP3& coeffs) const
     {
         FP c[3][4];
         for (int i = 0; i < 4; i++)
@@ -346,7 +638,7 @@ namespace pfc {
         for (int ii = minIndex.x; ii <= maxIndex.x; ii++)
             for (int jj = minIndex.y; jj <= maxIndex.y; jj++)
                 for (int kk = minIndex.z; kk <= maxIndex.z; kk++)
-                    result += c[0][ii] * c[1][jj] * c[2][kk] * (*this)(base.x + ii, base.y + jj, base.z + kk).real;
+                    result += c[0][ii] * c[1][jj] * c[2][kk] * at<fieldLayout>(base.x + ii, base.y + jj, base.z + kk).real;
         return result;
     }
 }
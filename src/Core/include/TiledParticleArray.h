@@ -0,0 +1,220 @@
+#pragma once
+
+#include "Dimension.h"
+#include "macros.h"
+#include "Particle.h"
+#include "ParticleArray.h"
+#include "ParticleTypes.h"
+#include "Vectors.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace pfc {
+
+    /* Particles of a type partitioned by tiles of tileSize cells of a grid given by
+    numCells, origin and steps. Each tile is a ParticleArraySoA with the particles
+    of its cells, so that processing of a tile touches a small box of the grid and
+    tiles can be processed as independent tasks. Particles outside of the grid are
+    kept in the boundary tiles. After positions are changed particles are moved to
+    their tiles by exchange(). Particles of a tile can be sorted by cells, every
+    sortPeriod-th exchange does it if sortPeriod > 0. */
+    template<Dimension dimension>
+    class TiledParticleArray {
+    public:
+
+        typedef ParticleArraySoA<dimension> TileType;
+        typedef typename TileType::ParticleType ParticleType;
+        typedef typename TileType::ConstParticleRef ConstParticleRef;
+
+        static const int positionDimension = TileType::positionDimension;
+
+        TiledParticleArray(ParticleTypes type, const Int3& numCells, const FP3& origin, const FP3& steps,
+            const Int3& tileSize = Int3(8, 8, 8)) :
+            type(type), numCells(numCells), origin(origin), steps(steps),
+            sortPeriod(0), numExchanges(0)
+        {
+            for (int d = 0; d < 3; d++) {
+                if (numCells[d] < 1 || tileSize[d] < 1)
+                    throw "ERROR: wrong sizes of tiles of particles";
+                if (d >= positionDimension && numCells[d] != 1)
+                    throw "ERROR: grid of tiles has more dimensions than particles";
+                this->tileSize[d] = std::min(tileSize[d], numCells[d]);
+                numTiles[d] = (numCells[d] + this->tileSize[d] - 1) / this->tileSize[d];
+            }
+            tiles.assign(numTiles.x * numTiles.y * numTiles.z, TileType(type));
+        }
+
+        // tiles of all cells of the grid including the external ones
+        template<class TGrid>
+        TiledParticleArray(ParticleTypes type, const TGrid* grid, const Int3& tileSize = Int3(8, 8, 8)) :
+            TiledParticleArray(type, grid->numCells, grid->origin, grid->steps, tileSize)
+        {}
+
+        int size() const
+        {
+            int result = 0;
+            for (int t = 0; t < getNumTiles(); t++)
+                result += tiles[t].size();
+            return result;
+        }
+
+        ParticleTypes getType() const { return type; }
+        int getNumTiles() const { return (int)tiles.size(); }
+        Int3 getNumTilesPerDimension() const { return numTiles; }
+        Int3 getTileSize() const { return tileSize; }
+        Int3 getNumCells() const { return numCells; }
+        FP3 getOrigin() const { return origin; }
+        FP3 getSteps() const { return steps; }
+
+        TileType& getTile(int tileIdx) { return tiles[tileIdx]; }
+        const TileType& getTile(int tileIdx) const { return tiles[tileIdx]; }
+
+        int getTileIndex(const Int3& tile) const
+        {
+            return (tile.x * numTiles.y + tile.y) * numTiles.z + tile.z;
+        }
+
+        Int3 getTileCoords(int tileIdx) const
+        {
+            return Int3(tileIdx / (numTiles.y * numTiles.z), (tileIdx / numTiles.z) % numTiles.y,
+                tileIdx % numTiles.z);
+        }
+
+        // the first cell of the tile
+        Int3 getTileBegin(int tileIdx) const
+        {
+            Int3 tile = getTileCoords(tileIdx);
+            return Int3(tile.x * tileSize.x, tile.y * tileSize.y, tile.z * tileSize.z);
+        }
+
+        // the number of cells of the tile along each dimension, the last tiles may be smaller
+        Int3 getTileCells(int tileIdx) const
+        {
+            Int3 begin = getTileBegin(tileIdx);
+            Int3 result;
+            for (int d = 0; d < 3; d++)
+                result[d] = std::min(tileSize[d], numCells[d] - begin[d]);
+            return result;
+        }
+
+        template<class TPosition>
+        int getTileIndex(const TPosition& position) const
+        {
+            Int3 tile;
+            for (int d = 0; d < 3; d++)
+                tile[d] = (d < positionDimension) ? getCell(position[d], d) / tileSize[d] : 0;
+            return getTileIndex(tile);
+        }
+
+        void pushBack(ConstParticleRef particle)
+        {
+            if (particle.getType() == type)
+                tiles[getTileIndex(particle.getPosition())].pushBack(particle);
+        }
+
+        void clear()
+        {
+            for (int t = 0; t < getNumTiles(); t++)
+                tiles[t].clear();
+        }
+
+        int getSortPeriod() const { return sortPeriod; }
+        void setSortPeriod(int period) { sortPeriod = period; }
+
+        /* Moves particles that left their tiles to the new ones. The particles leaving
+        a tile are collected in parallel over tiles, the arrival lists are built
+        sequentially, tiles receive their particles in parallel. */
+        void exchange()
+        {
+            const int n = getNumTiles();
+            std::vector<std::vector<ParticleType>> leaving(n);
+            std::vector<std::vector<int>> destinations(n);
+            OMP_FOR_DYNAMIC()
+            for (int t = 0; t < n; t++) {
+                TileType& tile = tiles[t];
+                for (int idx = 0; idx < tile.size(); idx++) {
+                    int destination = getParticleTile(tile, idx);
+                    if (destination != t) {
+                        leaving[t].push_back(ParticleType(tile[idx]));
+                        destinations[t].push_back(destination);
+                        tile.markRemoved(idx);
+                    }
+                }
+                if (!leaving[t].empty())
+                    tile.compact(false);
+            }
+
+            // arrivals of tile t are arrivals[arrivalOffsets[t], arrivalOffsets[t + 1])
+            std::vector<int> arrivalOffsets(n + 1, 0);
+            for (int t = 0; t < n; t++)
+                for (int i = 0; i < (int)destinations[t].size(); i++)
+                    arrivalOffsets[destinations[t][i] + 1]++;
+            for (int t = 0; t < n; t++)
+                arrivalOffsets[t + 1] += arrivalOffsets[t];
+            std::vector<const ParticleType*> arrivals(arrivalOffsets[n]);
+            std::vector<int> places(arrivalOffsets.begin(), arrivalOffsets.end() - 1);
+            for (int t = 0; t < n; t++)
+                for (int i = 0; i < (int)destinations[t].size(); i++)
+                    arrivals[places[destinations[t][i]]++] = &leaving[t][i];
+
+            OMP_FOR_DYNAMIC()
+            for (int t = 0; t < n; t++) {
+                if (arrivalOffsets[t + 1] == arrivalOffsets[t])
+                    continue;
+                tiles[t].reserve(tiles[t].size() + arrivalOffsets[t + 1] - arrivalOffsets[t]);
+                for (int i = arrivalOffsets[t]; i < arrivalOffsets[t + 1]; i++)
+                    tiles[t].pushBack(*arrivals[i]);
+            }
+
+            numExchanges++;
+            if (sortPeriod > 0 && numExchanges % sortPeriod == 0)
+                sortByCell();
+        }
+
+        // sorts particles of each tile by the cells of the tile with ParticleArraySoA::sortByCell
+        void sortByCell()
+        {
+            OMP_FOR_DYNAMIC()
+            for (int t = 0; t < getNumTiles(); t++)
+                tiles[t].sortByCell(origin, steps, getTileBegin(t), getTileCells(t));
+        }
+
+        /* After sortByCell() particles of the local cell (i, j, k) of the tile are
+        [offsets[c], offsets[c + 1]) for c = (i * cells.y + j) * cells.z + k,
+        cells = getTileCells(tileIdx). The offsets are valid until the tile is changed. */
+        const std::vector<int>& getCellOffsets(int tileIdx) const
+        {
+            return tiles[tileIdx].getCellOffsets();
+        }
+
+    private:
+
+        // cell of the grid along dimension d, coordinates outside of the grid go to the boundary cells
+        forceinline int getCell(FP coord, int d) const
+        {
+            FP x = std::floor((coord - origin[d]) / steps[d]);
+            if (x < 0)
+                return 0;
+            if (x >= (FP)numCells[d])
+                return numCells[d] - 1;
+            return (int)x;
+        }
+
+        forceinline int getParticleTile(TileType& tile, int idx) const
+        {
+            Int3 result;
+            for (int d = 0; d < 3; d++)
+                result[d] = (d < positionDimension) ? getCell(tile.getPositionData(d)[idx], d) / tileSize[d] : 0;
+            return getTileIndex(result);
+        }
+
+        ParticleTypes type;
+        Int3 numCells, tileSize, numTiles;
+        FP3 origin, steps;
+        int sortPeriod, numExchanges;
+        std::vector<TileType> tiles;
+    };
+
+}
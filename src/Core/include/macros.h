@@ -18,9 +18,11 @@
 #if _OPENMP >= 201307
     #define OMP_FOR()   _Pragma("omp parallel for")
     #define OMP_FOR_COLLAPSE()   _Pragma("omp parallel for collapse(2)")
+    #define OMP_FOR_DYNAMIC()   _Pragma("omp parallel for schedule(dynamic)")
     #define OMP_SIMD()  _Pragma("omp simd")
 #else
     #define OMP_FOR()   _Pragma("omp parallel for")
     #define OMP_FOR_COLLAPSE()   _Pragma("omp parallel for")
+    #define OMP_FOR_DYNAMIC()   _Pragma("omp parallel for schedule(dynamic)")
     #define OMP_SIMD()  _Pragma("ivdep")
 #endif
\ No newline at end of file
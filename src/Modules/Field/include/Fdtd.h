@@ -1,5 +1,6 @@
 #pragma once
 #include "Constants.h"
+#include "CpuDispatch.h"
 #include "FieldSolver.h"
 #include "Grid.h"
 #include "PmlFdtd.h"
@@ -23,6 +24,11 @@ namespace pfc {
         void updateHalfB();
         void updateE();
 
+        /* Move grid values to memory first touched with the partitioning of the
+        update loops, so that on NUMA systems each thread updates memory of its
+        node. Call after setPML, pointers to field data become invalid. */
+        void placeGridMemory();
+
         void setTimeStep(FP dt);
 
         FP getCourantCondition() const {
@@ -38,13 +44,68 @@ namespace pfc {
 
     private:
 
+        template <ScalarFieldLayout layout>
+        void updateHalfB();
+        template <ScalarFieldLayout layout>
+        void updateE();
+
+        template <ScalarFieldLayout layout>
         void updateHalfB3D();
+        template <ScalarFieldLayout layout>
         void updateHalfB2D();
         void updateHalfB1D();
+        template <ScalarFieldLayout layout>
         void updateE3D();
+        template <ScalarFieldLayout layout>
         void updateE2D();
         void updateE1D();
 
+        /* Updates of rows along z of the internal area of the 3d grid, coeffs are
+        the coefficients of the update in their order in the loop. The variants for
+        instruction sets are selected by getCpuIsa() before the loop. */
+        typedef void(*UpdateRow)(YeeGrid*, int, int, int, int, const FP*);
+
+        template <ScalarFieldLayout layout>
+        forceinline static void updateHalfBRow(YeeGrid* grid, int i, int j, int beginK, int endK, const FP* coeffs);
+        template <ScalarFieldLayout layout>
+        forceinline static void updateERow(YeeGrid* grid, int i, int j, int beginK, int endK, const FP* coeffs);
+
+        PFC_KERNEL_VARIANTS(template <ScalarFieldLayout layout>, updateHalfBRow, updateHalfBRow<layout>,
+            (YeeGrid* grid, int i, int j, int beginK, int endK, const FP* coeffs),
+            (grid, i, j, beginK, endK, coeffs))
+        PFC_KERNEL_VARIANTS(template <ScalarFieldLayout layout>, updateERow, updateERow<layout>,
+            (YeeGrid* grid, int i, int j, int beginK, int endK, const FP* coeffs),
+            (grid, i, j, beginK, endK, coeffs))
+
+        // the same for rows along y of the 2d grid
+        typedef void(*UpdateRow2D)(YeeGrid*, int, int, int, const FP*);
+
+        template <ScalarFieldLayout layout>
+        forceinline static void updateHalfBRow2D(YeeGrid* grid, int i, int beginJ, int endJ, const FP* coeffs);
+        template <ScalarFieldLayout layout>
+        forceinline static void updateERow2D(YeeGrid* grid, int i, int beginJ, int endJ, const FP* coeffs);
+
+        PFC_KERNEL_VARIANTS(template <ScalarFieldLayout layout>, updateHalfBRow2D, updateHalfBRow2D<layout>,
+            (YeeGrid* grid, int i, int beginJ, int endJ, const FP* coeffs),
+            (grid, i, beginJ, endJ, coeffs))
+        PFC_KERNEL_VARIANTS(template <ScalarFieldLayout layout>, updateERow2D, updateERow2D<layout>,
+            (YeeGrid* grid, int i, int beginJ, int endJ, const FP* coeffs),
+            (grid, i, beginJ, endJ, coeffs))
+
+        // and for blocks of blockSize1D cells of the 1d grid
+        typedef void(*UpdateBlock1D)(YeeGrid*, int, int, const FP*);
+        static const int blockSize1D = 1024;
+
+        forceinline static void updateHalfBBlock1D(YeeGrid* grid, int beginI, int endI, const FP* coeffs);
+        forceinline static void updateEBlock1D(YeeGrid* grid, int beginI, int endI, const FP* coeffs);
+
+        PFC_KERNEL_VARIANTS(, updateHalfBBlock1D, updateHalfBBlock1D,
+            (YeeGrid* grid, int beginI, int endI, const FP* coeffs),
+            (grid, beginI, endI, coeffs))
+        PFC_KERNEL_VARIANTS(, updateEBlock1D, updateEBlock1D,
+            (YeeGrid* grid, int beginI, int endI, const FP* coeffs),
+            (grid, beginI, endI, coeffs))
+
         FP3 anisotropyCoeff;
         void setAnisotropy(const FP frequency, int axis);
 
@@ -89,6 +150,18 @@ namespace pfc {
         }
     }
 
+    inline void FDTD::placeGridMemory()
+    {
+        // the internal area of updateE3D, updateHalfB3D differs by a layer of cells
+        Int3 begin, end;
+        for (int d = 0; d < 3; ++d)
+        {
+            begin[d] = std::max(0, pml->leftDims[d]);
+            end[d] = std::min(grid->numCells[d] - 1, grid->numCells[d] - pml->rightDims[d]);
+        }
+        grid->placeRows(begin, end);
+    }
+
     inline void FDTD::setFieldGenerator(FieldGeneratorYee * _generator)
     {
         generator.reset(_generator->createInstance(this));
@@ -146,15 +219,37 @@ namespace pfc {
 
     // Update grid values of magnetic field in FDTD.
     inline void FDTD::updateHalfB()
+    {
+        // the layout is a template parameter, so that loops over row-major fields are vectorized
+        switch (grid->getLayout())
+        {
+        case ScalarFieldLayout_Bricks:
+            updateHalfB<ScalarFieldLayout_Bricks>();
+            break;
+        case ScalarFieldLayout_Interleaved:
+            updateHalfB<ScalarFieldLayout_Interleaved>();
+            break;
+        case ScalarFieldLayout_Padded:
+            updateHalfB<ScalarFieldLayout_Padded>();
+            break;
+        default:
+            updateHalfB<ScalarFieldLayout_RowMajor>();
+            break;
+        }
+    }
+
+    template <ScalarFieldLayout layout>
+    inline void FDTD::updateHalfB()
     {
         if (grid->dimensionality == 3)
-            updateHalfB3D();
+            updateHalfB3D<layout>();
         else if (grid->dimensionality == 2)
-            updateHalfB2D();
+            updateHalfB2D<layout>();
         else if (grid->dimensionality == 1)
             updateHalfB1D();
     }
 
+    template <ScalarFieldLayout layout>
     inline void FDTD::updateHalfB3D()
     {
         updateBAreaBegin = Int3(1, 1, 1);
@@ -183,23 +278,33 @@ namespace pfc {
         //     (e.y(i, j, k) - e.y(i-1, j, k)) / eps_x * dx),
         const Int3 begin = internalBAreaBegin;
         const Int3 end = internalBAreaEnd;
+        const FP coeffs[] = { coeffZX, coeffYX, coeffXY, coeffZY, coeffYZ, coeffXZ };
+        const UpdateRow updateRow = selectKernel(&updateHalfBRowGeneric<layout>,
+            &updateHalfBRowAVX2<layout>, &updateHalfBRowAVX512<layout>);
         OMP_FOR_COLLAPSE()
         for (int i = begin.x; i < end.x; i++)
             for (int j = begin.y; j < end.y; j++)
-            {
-#pragma simd
-                for (int k = begin.z; k < end.z; k++)
-                {
-                    grid->Bx(i, j, k) += coeffZX * (grid->Ey(i, j, k) - grid->Ey(i, j, k - 1)) -
-                        coeffYX * (grid->Ez(i, j, k) - grid->Ez(i, j - 1, k));
-                    grid->By(i, j, k) += coeffXY * (grid->Ez(i, j, k) - grid->Ez(i - 1, j, k)) -
-                        coeffZY * (grid->Ex(i, j, k) - grid->Ex(i, j, k - 1));
-                    grid->Bz(i, j, k) += coeffYZ * (grid->Ex(i, j, k) - grid->Ex(i, j - 1, k)) -
-                        coeffXZ * (grid->Ey(i, j, k) - grid->Ey(i - 1, j, k));
-                }
-            }
+                updateRow(grid, i, j, begin.z, end.z, coeffs);
+    }
+
+    template <ScalarFieldLayout layout>
+    forceinline void FDTD::updateHalfBRow(YeeGrid* grid, int i, int j, int beginK, int endK, const FP* coeffs)
+    {
+        const FP coeffZX = coeffs[0], coeffYX = coeffs[1], coeffXY = coeffs[2],
+            coeffZY = coeffs[3], coeffYZ = coeffs[4], coeffXZ = coeffs[5];
+        OMP_SIMD()
+        for (int k = beginK; k < endK; k++)
+        {
+            grid->Bx.at<layout>(i, j, k) += coeffZX * (grid->Ey.at<layout>(i, j, k) - grid->Ey.at<layout>(i, j, k - 1)) -
+                coeffYX * (grid->Ez.at<layout>(i, j, k) - grid->Ez.at<layout>(i, j - 1, k));
+            grid->By.at<layout>(i, j, k) += coeffXY * (grid->Ez.at<layout>(i, j, k) - grid->Ez.at<layout>(i - 1, j, k)) -
+                coeffZY * (grid->Ex.at<layout>(i, j, k) - grid->Ex.at<layout>(i, j, k - 1));
+            grid->Bz.at<layout>(i, j, k) += coeffYZ * (grid->Ex.at<layout>(i, j, k) - grid->Ex.at<layout>(i, j - 1, k)) -
+                coeffXZ * (grid->Ey.at<layout>(i, j, k) - grid->Ey.at<layout>(i - 1, j, k));
+        }
     }
 
+    template <ScalarFieldLayout layout>
     inline void FDTD::updateHalfB2D()
     {
         updateBAreaBegin = Int3(1, 1, 0);
@@ -226,16 +331,25 @@ namespace pfc {
         //     (e.y(i, j, k) - e.y(i-1, j, k)) / eps_x * dx),
         const Int3 begin = internalBAreaBegin;
         const Int3 end = internalBAreaEnd;
+        const FP coeffs[] = { coeffYX, coeffXY, coeffYZ, coeffXZ };
+        const UpdateRow2D updateRow = selectKernel(&updateHalfBRow2DGeneric<layout>,
+            &updateHalfBRow2DAVX2<layout>, &updateHalfBRow2DAVX512<layout>);
         OMP_FOR()
-        for (int i = begin.x; i < end.x; i++) {
-#pragma simd
-            for (int j = begin.y; j < end.y; j++)
-            {
-                grid->Bx(i, j, 0) += -coeffYX * (grid->Ez(i, j, 0) - grid->Ez(i, j - 1, 0));
-                grid->By(i, j, 0) += coeffXY * (grid->Ez(i, j, 0) - grid->Ez(i - 1, j, 0));
-                grid->Bz(i, j, 0) += coeffYZ * (grid->Ex(i, j, 0) - grid->Ex(i, j - 1, 0)) -
-                    coeffXZ * (grid->Ey(i, j, 0) - grid->Ey(i - 1, j, 0));
-            }
+        for (int i = begin.x; i < end.x; i++)
+            updateRow(grid, i, begin.y, end.y, coeffs);
+    }
+
+    template <ScalarFieldLayout layout>
+    forceinline void FDTD::updateHalfBRow2D(YeeGrid* grid, int i, int beginJ, int endJ, const FP* coeffs)
+    {
+        const FP coeffYX = coeffs[0], coeffXY = coeffs[1], coeffYZ = coeffs[2], coeffXZ = coeffs[3];
+        OMP_SIMD()
+        for (int j = beginJ; j < endJ; j++)
+        {
+            grid->Bx.at<layout>(i, j, 0) += -coeffYX * (grid->Ez.at<layout>(i, j, 0) - grid->Ez.at<layout>(i, j - 1, 0));
+            grid->By.at<layout>(i, j, 0) += coeffXY * (grid->Ez.at<layout>(i, j, 0) - grid->Ez.at<layout>(i - 1, j, 0));
+            grid->Bz.at<layout>(i, j, 0) += coeffYZ * (grid->Ex.at<layout>(i, j, 0) - grid->Ex.at<layout>(i, j - 1, 0)) -
+                coeffXZ * (grid->Ey.at<layout>(i, j, 0) - grid->Ey.at<layout>(i - 1, j, 0));
         }
     }
 
@@ -263,8 +377,21 @@ namespace pfc {
         //     (e.y(i, j, k) - e.y(i-1, j, k)) / eps_x * dx),
         const Int3 begin = internalBAreaBegin;
         const Int3 end = internalBAreaEnd;
+        const FP coeffs[] = { coeffXY, coeffXZ };
+        const UpdateBlock1D updateBlock = selectKernel(&updateHalfBBlock1DGeneric,
+            &updateHalfBBlock1DAVX2, &updateHalfBBlock1DAVX512);
+        const int numBlocks = (end.x - begin.x + blockSize1D - 1) / blockSize1D;
         OMP_FOR()
-        for (int i = begin.x; i < end.x; i++) {
+        for (int b = 0; b < numBlocks; b++) {
+            const int blockBegin = begin.x + b * blockSize1D;
+            updateBlock(grid, blockBegin, std::min(end.x, blockBegin + blockSize1D), coeffs);
+        }
+    }
+
+    forceinline void FDTD::updateHalfBBlock1D(YeeGrid* grid, int beginI, int endI, const FP* coeffs)
+    {
+        const FP coeffXY = coeffs[0], coeffXZ = coeffs[1];
+        for (int i = beginI; i < endI; i++) {
             grid->By(i, 0, 0) += coeffXY * (grid->Ez(i, 0, 0) - grid->Ez(i - 1, 0, 0));
             grid->Bz(i, 0, 0) += -coeffXZ * (grid->Ey(i, 0, 0) - grid->Ey(i - 1, 0, 0));
         }
@@ -272,15 +399,36 @@ namespace pfc {
 
     // Update grid values of electric field in FDTD.
     inline void FDTD::updateE()
+    {
+        switch (grid->getLayout())
+        {
+        case ScalarFieldLayout_Bricks:
+            updateE<ScalarFieldLayout_Bricks>();
+            break;
+        case ScalarFieldLayout_Interleaved:
+            updateE<ScalarFieldLayout_Interleaved>();
+            break;
+        case ScalarFieldLayout_Padded:
+            updateE<ScalarFieldLayout_Padded>();
+            break;
+        default:
+            updateE<ScalarFieldLayout_RowMajor>();
+            break;
+        }
+    }
+
+    template <ScalarFieldLayout layout>
+    inline void FDTD::updateE()
     {
         if (grid->dimensionality == 3)
-            updateE3D();
+            updateE3D<layout>();
         else if (grid->dimensionality == 2)
-            updateE2D();
+            updateE2D<layout>();
         else if (grid->dimensionality == 1)
             updateE1D();
     }
 
+    template <ScalarFieldLayout layout>
     inline void FDTD::updateE3D()
     {
         updateEAreaBegin = Int3(0, 0, 0);
@@ -310,24 +458,13 @@ namespace pfc {
         //     b.y(i, j, k)) / eps_x * dx - (b.x(i, j+1, k) - b.x(i, j, k)) / eps_y * dy),
         const Int3 begin = internalEAreaBegin;
         const Int3 end = internalEAreaEnd;
+        const FP coeffs[] = { coeffCurrent, coeffYX, coeffZX, coeffZY, coeffXY, coeffXZ, coeffYZ };
+        const UpdateRow updateRow = selectKernel(&updateERowGeneric<layout>,
+            &updateERowAVX2<layout>, &updateERowAVX512<layout>);
         OMP_FOR_COLLAPSE()
         for (int i = begin.x; i < end.x; i++)
             for (int j = begin.y; j < end.y; j++)
-            {
-#pragma simd
-                for (int k = begin.z; k < end.z; k++)
-                {
-                    grid->Ex(i, j, k) += coeffCurrent * grid->Jx(i, j, k) +
-                        coeffYX * (grid->Bz(i, j + 1, k) - grid->Bz(i, j, k)) -
-                        coeffZX * (grid->By(i, j, k + 1) - grid->By(i, j, k));
-                    grid->Ey(i, j, k) += coeffCurrent * grid->Jy(i, j, k) +
-                        coeffZY * (grid->Bx(i, j, k + 1) - grid->Bx(i, j, k)) -
-                        coeffXY * (grid->Bz(i + 1, j, k) - grid->Bz(i, j, k));
-                    grid->Ez(i, j, k) += coeffCurrent * grid->Jz(i, j, k) +
-                        coeffXZ * (grid->By(i + 1, j, k) - grid->By(i, j, k)) -
-                        coeffYZ * (grid->Bx(i, j + 1, k) - grid->Bx(i, j, k));
-                }
-            }
+                updateRow(grid, i, j, begin.z, end.z, coeffs);
 
         // Process edge values
         if (updateEAreaEnd.x == grid->numCells.x - 1)
@@ -336,9 +473,9 @@ namespace pfc {
             OMP_FOR()
             for (int j = begin.y; j < end.y; j++)
                 for (int k = begin.z; k < end.z; k++)
-                    grid->Ex(i, j, k) += coeffCurrent * grid->Jx(i, j, k) +
-                    coeffYX * (grid->Bz(i, j + 1, k) - grid->Bz(i, j, k)) -
-                    coeffZX * (grid->By(i, j, k + 1) - grid->By(i, j, k));
+                    grid->Ex.at<layout>(i, j, k) += coeffCurrent * grid->Jx.at<layout>(i, j, k) +
+                    coeffYX * (grid->Bz.at<layout>(i, j + 1, k) - grid->Bz.at<layout>(i, j, k)) -
+                    coeffZX * (grid->By.at<layout>(i, j, k + 1) - grid->By.at<layout>(i, j, k));
         }
         if (updateEAreaEnd.y == grid->numCells.y - 1)
         {
@@ -346,9 +483,9 @@ namespace pfc {
             OMP_FOR()
             for (int i = begin.x; i < end.x; i++)
                 for (int k = begin.z; k < end.z; k++)
-                    grid->Ey(i, j, k) += coeffCurrent * grid->Jy(i, j, k) +
-                    coeffZY * (grid->Bx(i, j, k + 1) - grid->Bx(i, j, k)) -
-                    coeffXY * (grid->Bz(i + 1, j, k) - grid->Bz(i, j, k));
+                    grid->Ey.at<layout>(i, j, k) += coeffCurrent * grid->Jy.at<layout>(i, j, k) +
+                    coeffZY * (grid->Bx.at<layout>(i, j, k + 1) - grid->Bx.at<layout>(i, j, k)) -
+                    coeffXY * (grid->Bz.at<layout>(i + 1, j, k) - grid->Bz.at<layout>(i, j, k));
         }
         if (updateEAreaEnd.z == grid->numCells.z - 1)
         {
@@ -356,12 +493,33 @@ namespace pfc {
             OMP_FOR()
             for (int i = begin.x; i < end.x; i++)
                 for (int j = begin.y; j < end.y; j++)
-                    grid->Ez(i, j, k) += coeffCurrent * grid->Jz(i, j, k) +
-                    coeffXZ * (grid->By(i + 1, j, k) - grid->By(i, j, k)) -
-                    coeffYZ * (grid->Bx(i, j + 1, k) - grid->Bx(i, j, k));
+                    grid->Ez.at<layout>(i, j, k) += coeffCurrent * grid->Jz.at<layout>(i, j, k) +
+                    coeffXZ * (grid->By.at<layout>(i + 1, j, k) - grid->By.at<layout>(i, j, k)) -
+                    coeffYZ * (grid->Bx.at<layout>(i, j + 1, k) - grid->Bx.at<layout>(i, j, k));
         }
     }
 
+    template <ScalarFieldLayout layout>
+    forceinline void FDTD::updateERow(YeeGrid* grid, int i, int j, int beginK, int endK, const FP* coeffs)
+    {
+        const FP coeffCurrent = coeffs[0], coeffYX = coeffs[1], coeffZX = coeffs[2],
+            coeffZY = coeffs[3], coeffXY = coeffs[4], coeffXZ = coeffs[5], coeffYZ = coeffs[6];
+        OMP_SIMD()
+        for (int k = beginK; k < endK; k++)
+        {
+            grid->Ex.at<layout>(i, j, k) += coeffCurrent * grid->Jx.at<layout>(i, j, k) +
+                coeffYX * (grid->Bz.at<layout>(i, j + 1, k) - grid->Bz.at<layout>(i, j, k)) -
+                coeffZX * (grid->By.at<layout>(i, j, k + 1) - grid->By.at<layout>(i, j, k));
+            grid->Ey.at<layout>(i, j, k) += coeffCurrent * grid->Jy.at<layout>(i, j, k) +
+                coeffZY * (grid->Bx.at<layout>(i, j, k + 1) - grid->Bx.at<layout>(i, j, k)) -
+                coeffXY * (grid->Bz.at<layout>(i + 1, j, k) - grid->Bz.at<layout>(i, j, k));
+            grid->Ez.at<layout>(i, j, k) += coeffCurrent * grid->Jz.at<layout>(i, j, k) +
+                coeffXZ * (grid->By.at<layout>(i + 1, j, k) - grid->By.at<layout>(i, j, k)) -
+                coeffYZ * (grid->Bx.at<layout>(i, j + 1, k) - grid->Bx.at<layout>(i, j, k));
+        }
+    }
+
+    template <ScalarFieldLayout layout>
     inline void FDTD::updateE2D()
     {
         updateEAreaBegin = Int3(0, 0, 0);
@@ -389,19 +547,12 @@ namespace pfc {
         //     b.y(i, j, k)) / eps_x * dx - (b.x(i, j+1, k) - b.x(i, j, k)) / eps_y * dy),
         const Int3 begin = internalEAreaBegin;
         const Int3 end = internalEAreaEnd;
+        const FP coeffs[] = { coeffCurrent, coeffYX, coeffXY, coeffXZ, coeffYZ };
+        const UpdateRow2D updateRow = selectKernel(&updateERow2DGeneric<layout>,
+            &updateERow2DAVX2<layout>, &updateERow2DAVX512<layout>);
         OMP_FOR()
-        for (int i = begin.x; i < end.x; i++) {
-#pragma simd
-            for (int j = begin.y; j < end.y; j++) {
-                grid->Ex(i, j, 0) += coeffCurrent * grid->Jx(i, j, 0) +
-                    coeffYX * (grid->Bz(i, j + 1, 0) - grid->Bz(i, j, 0));
-                grid->Ey(i, j, 0) += coeffCurrent * grid->Jy(i, j, 0) -
-                    coeffXY * (grid->Bz(i + 1, j, 0) - grid->Bz(i, j, 0));
-                grid->Ez(i, j, 0) += coeffCurrent * grid->Jz(i, j, 0) +
-                    coeffXZ * (grid->By(i + 1, j, 0) - grid->By(i, j, 0)) -
-                    coeffYZ * (grid->Bx(i, j + 1, 0) - grid->Bx(i, j, 0));
-            }
-        }
+        for (int i = begin.x; i < end.x; i++)
+            updateRow(grid, i, begin.y, end.y, coeffs);
 
         // Process edge values
         if (updateEAreaEnd.x == grid->numCells.x - 1)
@@ -409,16 +560,33 @@ namespace pfc {
             int i = updateEAreaEnd.x;
             OMP_FOR()
             for (int j = begin.y; j < end.y; j++)
-                grid->Ex(i, j, 0) += coeffCurrent * grid->Jx(i, j, 0) +
-                coeffYX * (grid->Bz(i, j + 1, 0) - grid->Bz(i, j, 0));
+                grid->Ex.at<layout>(i, j, 0) += coeffCurrent * grid->Jx.at<layout>(i, j, 0) +
+                coeffYX * (grid->Bz.at<layout>(i, j + 1, 0) - grid->Bz.at<layout>(i, j, 0));
         }
         if (updateEAreaEnd.y == grid->numCells.y - 1)
         {
             int j = updateEAreaEnd.y;
             OMP_FOR()
             for (int i = begin.x; i < end.x; i++)
-                grid->Ey(i, j, 0) += coeffCurrent * grid->Jy(i, j, 0) -
-                coeffXY * (grid->Bz(i + 1, j, 0) - grid->Bz(i, j, 0));
+                grid->Ey.at<layout>(i, j, 0) += coeffCurrent * grid->Jy.at<layout>(i, j, 0) -
+                coeffXY * (grid->Bz.at<layout>(i + 1, j, 0) - grid->Bz.at<layout>(i, j, 0));
+        }
+    }
+
+    template <ScalarFieldLayout layout>
+    forceinline void FDTD::updateERow2D(YeeGrid* grid, int i, int beginJ, int endJ, const FP* coeffs)
+    {
+        const FP coeffCurrent = coeffs[0], coeffYX = coeffs[1], coeffXY = coeffs[2],
+            coeffXZ = coeffs[3], coeffYZ = coeffs[4];
+        OMP_SIMD()
+        for (int j = beginJ; j < endJ; j++) {
+            grid->Ex.at<layout>(i, j, 0) += coeffCurrent * grid->Jx.at<layout>(i, j, 0) +
+                coeffYX * (grid->Bz.at<layout>(i, j + 1, 0) - grid->Bz.at<layout>(i, j, 0));
+            grid->Ey.at<layout>(i, j, 0) += coeffCurrent * grid->Jy.at<layout>(i, j, 0) -
+                coeffXY * (grid->Bz.at<layout>(i + 1, j, 0) - grid->Bz.at<layout>(i, j, 0));
+            grid->Ez.at<layout>(i, j, 0) += coeffCurrent * grid->Jz.at<layout>(i, j, 0) +
+                coeffXZ * (grid->By.at<layout>(i + 1, j, 0) - grid->By.at<layout>(i, j, 0)) -
+                coeffYZ * (grid->Bx.at<layout>(i, j + 1, 0) - grid->Bx.at<layout>(i, j, 0));
         }
     }
 
@@ -447,8 +615,21 @@ namespace pfc {
         //     b.y(i, j, k)) / eps_x * dx - (b.x(i, j+1, k) - b.x(i, j, k)) / eps_y * dy),
         const Int3 begin = internalEAreaBegin;
         const Int3 end = internalEAreaEnd;
+        const FP coeffs[] = { coeffCurrent, coeffXY, coeffXZ };
+        const UpdateBlock1D updateBlock = selectKernel(&updateEBlock1DGeneric,
+            &updateEBlock1DAVX2, &updateEBlock1DAVX512);
+        const int numBlocks = (end.x - begin.x + blockSize1D - 1) / blockSize1D;
         OMP_FOR()
-        for (int i = begin.x; i < end.x; i++) {
+        for (int b = 0; b < numBlocks; b++) {
+            const int blockBegin = begin.x + b * blockSize1D;
+            updateBlock(grid, blockBegin, std::min(end.x, blockBegin + blockSize1D), coeffs);
+        }
+    }
+
+    forceinline void FDTD::updateEBlock1D(YeeGrid* grid, int beginI, int endI, const FP* coeffs)
+    {
+        const FP coeffCurrent = coeffs[0], coeffXY = coeffs[1], coeffXZ = coeffs[2];
+        for (int i = beginI; i < endI; i++) {
             grid->Ex(i, 0, 0) += coeffCurrent * grid->Jx(i, 0, 0);
             grid->Ey(i, 0, 0) += coeffCurrent * grid->Jy(i, 0, 0) -
                 coeffXY * (grid->Bz(i + 1, 0, 0) - grid->Bz(i, 0, 0));
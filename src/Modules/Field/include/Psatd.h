@@ -1,5 +1,6 @@
 #pragma once
 #include "Constants.h"
+#include "CpuDispatch.h"
 #include "FieldSolver.h"
 #include "Grid.h"
 #include "Vectors.h"
@@ -41,6 +42,27 @@ namespace pfc {
 
         void saveJ();
         void assignJ(ScalarField<complexFP>& J, ScalarField<complexFP>& tmpJ);
+
+        /* Updates of rows of modes along z, the variants for instruction sets
+        are selected by getCpuIsa() before the loops. */
+        typedef void(*UpdateRow)(PSATDTimeStraggeredT*, int, int, int, int, FP);
+
+        forceinline static void removeLongitudinalERow(PSATDTimeStraggeredT* solver, int i, int j,
+            int beginK, int endK, FP dt);
+        forceinline static void updateHalfBRow(PSATDTimeStraggeredT* solver, int i, int j,
+            int beginK, int endK, FP dt);
+        forceinline static void updateERow(PSATDTimeStraggeredT* solver, int i, int j,
+            int beginK, int endK, FP dt);
+
+        PFC_KERNEL_VARIANTS(, removeLongitudinalERow, removeLongitudinalERow,
+            (PSATDTimeStraggeredT* solver, int i, int j, int beginK, int endK, FP dt),
+            (solver, i, j, beginK, endK, dt))
+        PFC_KERNEL_VARIANTS(, updateHalfBRow, updateHalfBRow,
+            (PSATDTimeStraggeredT* solver, int i, int j, int beginK, int endK, FP dt),
+            (solver, i, j, beginK, endK, dt))
+        PFC_KERNEL_VARIANTS(, updateERow, updateERow,
+            (PSATDTimeStraggeredT* solver, int i, int j, int beginK, int endK, FP dt),
+            (solver, i, j, beginK, endK, dt))
     };
 
     template <bool ifPoisson>
@@ -117,68 +139,80 @@ namespace pfc {
         doFourierTransform(fourier_transform::Direction::RtoC);
         const Int3 begin = updateComplexBAreaBegin;
         const Int3 end = updateComplexBAreaEnd;
-        double dt = this->dt * 0.5;
+        const UpdateRow updateRow = selectKernel(&removeLongitudinalERowGeneric,
+            &removeLongitudinalERowAVX2, &removeLongitudinalERowAVX512);
+        const FP dt = this->dt;
         OMP_FOR_COLLAPSE()
         for (int i = begin.x; i < end.x; i++)
             for (int j = begin.y; j < end.y; j++)
-            {
-                //#pragma omp simd
-                for (int k = begin.z; k < end.z; k++)
-                {
-                    FP3 K = getWaveVector(Int3(i, j, k));
-                    FP normK = K.norm();
-
-                    if (normK == 0) {
-                        continue;
-                    }
-
-                    K = K / normK;
-
-                    ComplexFP3 E(complexGrid->Ex(i, j, k), complexGrid->Ey(i, j, k), complexGrid->Ez(i, j, k));
-                    ComplexFP3 El = (ComplexFP3)K * dot((ComplexFP3)K, E);
-
-                    complexGrid->Ex(i, j, k) -= El.x;
-                    complexGrid->Ey(i, j, k) -= El.y;
-                    complexGrid->Ez(i, j, k) -= El.z;
-                }
-            }
+                updateRow(this, i, j, begin.z, end.z, dt);
         doFourierTransform(fourier_transform::Direction::CtoR);
     }
 
+    template <bool ifPoisson>
+    forceinline void PSATDTimeStraggeredT<ifPoisson>::removeLongitudinalERow(PSATDTimeStraggeredT* solver, int i, int j,
+        int beginK, int endK, FP dt)
+    {
+        for (int k = beginK; k < endK; k++)
+        {
+            FP3 K = solver->getWaveVector(Int3(i, j, k));
+            FP normK = K.norm();
+
+            if (normK == 0) {
+                continue;
+            }
+
+            K = K / normK;
+
+            ComplexFP3 E(solver->complexGrid->Ex(i, j, k), solver->complexGrid->Ey(i, j, k), solver->complexGrid->Ez(i, j, k));
+            ComplexFP3 El = (ComplexFP3)K * dot((ComplexFP3)K, E);
+
+            solver->complexGrid->Ex(i, j, k) -= El.x;
+            solver->complexGrid->Ey(i, j, k) -= El.y;
+            solver->complexGrid->Ez(i, j, k) -= El.z;
+        }
+    }
+
     template <bool ifPoisson>
     inline void PSATDTimeStraggeredT<ifPoisson>::updateHalfB()
     {
         const Int3 begin = updateComplexBAreaBegin;
         const Int3 end = updateComplexBAreaEnd;
-        double dt = 0.5 * this->dt;
+        const UpdateRow updateRow = selectKernel(&updateHalfBRowGeneric,
+            &updateHalfBRowAVX2, &updateHalfBRowAVX512);
+        const FP dt = 0.5 * this->dt;
         OMP_FOR_COLLAPSE()
         for (int i = begin.x; i < end.x; i++)
             for (int j = begin.y; j < end.y; j++)
-            {
-                //#pragma omp simd
-                for (int k = begin.z; k < end.z; k++)
-                {
-                    FP3 K = getWaveVector(Int3(i, j, k));
-                    FP normK = K.norm();
-                    if (normK == 0) {
-                        continue;
-                    }
-                    K = K / normK;
-
-                    ComplexFP3 E(complexGrid->Ex(i, j, k), complexGrid->Ey(i, j, k), complexGrid->Ez(i, j, k));
-                    ComplexFP3 J(complexGrid->Jx(i, j, k), complexGrid->Jy(i, j, k), complexGrid->Jz(i, j, k)),
-                        prevJ(tmpJx(i, j, k), tmpJy(i, j, k), tmpJz(i, j, k));
-                    ComplexFP3 crossKE = cross((ComplexFP3)K, E);
-                    ComplexFP3 crossKJ = cross((ComplexFP3)K, J - prevJ);
-
-                    FP S = sin(normK*constants::c*dt*0.5), C = cos(normK*constants::c*dt*0.5);
-                    complexFP coeff1 = 2 * complexFP::i()*S, coeff2 = complexFP::i() * ((1 - C) / (normK*constants::c));
-
-                    complexGrid->Bx(i, j, k) += -coeff1 * crossKE.x + coeff2 * crossKJ.x;
-                    complexGrid->By(i, j, k) += -coeff1 * crossKE.y + coeff2 * crossKJ.y;
-                    complexGrid->Bz(i, j, k) += -coeff1 * crossKE.z + coeff2 * crossKJ.z;
-                }
+                updateRow(this, i, j, begin.z, end.z, dt);
+    }
+
+    template <bool ifPoisson>
+    forceinline void PSATDTimeStraggeredT<ifPoisson>::updateHalfBRow(PSATDTimeStraggeredT* solver, int i, int j,
+        int beginK, int endK, FP dt)
+    {
+        for (int k = beginK; k < endK; k++)
+        {
+            FP3 K = solver->getWaveVector(Int3(i, j, k));
+            FP normK = K.norm();
+            if (normK == 0) {
+                continue;
             }
+            K = K / normK;
+
+            ComplexFP3 E(solver->complexGrid->Ex(i, j, k), solver->complexGrid->Ey(i, j, k), solver->complexGrid->Ez(i, j, k));
+            ComplexFP3 J(solver->complexGrid->Jx(i, j, k), solver->complexGrid->Jy(i, j, k), solver->complexGrid->Jz(i, j, k)),
+                prevJ(solver->tmpJx(i, j, k), solver->tmpJy(i, j, k), solver->tmpJz(i, j, k));
+            ComplexFP3 crossKE = cross((ComplexFP3)K, E);
+            ComplexFP3 crossKJ = cross((ComplexFP3)K, J - prevJ);
+
+            FP S = sin(normK*constants::c*dt*0.5), C = cos(normK*constants::c*dt*0.5);
+            complexFP coeff1 = 2 * complexFP::i()*S, coeff2 = complexFP::i() * ((1 - C) / (normK*constants::c));
+
+            solver->complexGrid->Bx(i, j, k) += -coeff1 * crossKE.x + coeff2 * crossKJ.x;
+            solver->complexGrid->By(i, j, k) += -coeff1 * crossKE.y + coeff2 * crossKJ.y;
+            solver->complexGrid->Bz(i, j, k) += -coeff1 * crossKE.z + coeff2 * crossKJ.z;
+        }
     }
 
     template <bool ifPoisson>
@@ -186,77 +220,77 @@ namespace pfc {
     {
         const Int3 begin = updateComplexEAreaBegin;
         const Int3 end = updateComplexEAreaEnd;
+        const UpdateRow updateRow = selectKernel(&updateERowGeneric,
+            &updateERowAVX2, &updateERowAVX512);
+        const FP dt = this->dt;
         OMP_FOR_COLLAPSE()
         for (int i = begin.x; i < end.x; i++)
             for (int j = begin.y; j < end.y; j++)
-            {
-                //#pragma omp simd
-                for (int k = begin.z; k < end.z; k++)
-                {
-                    FP3 K = getWaveVector(Int3(i, j, k));
-                    FP normK = K.norm();
-                    if (normK == 0) {
-                        complexGrid->Ex(i, j, k) += dt * complexGrid->Jx(i, j, k);
-                        complexGrid->Ey(i, j, k) += dt * complexGrid->Jy(i, j, k);
-                        complexGrid->Ez(i, j, k) += dt * complexGrid->Jz(i, j, k);
-                        continue;
-                    }
-                    K = K / normK;
-
-                    ComplexFP3 B(complexGrid->Bx(i, j, k), complexGrid->By(i, j, k), complexGrid->Bz(i, j, k));
-                    ComplexFP3 J(complexGrid->Jx(i, j, k), complexGrid->Jy(i, j, k), complexGrid->Jz(i, j, k));
-                    ComplexFP3 crossKB = cross((ComplexFP3)K, B);
-                    ComplexFP3 Jl = (ComplexFP3)K * dot((ComplexFP3)K, J);
-
-                    FP S = sin(normK*constants::c*dt*0.5);
-                    complexFP coeff1 = 2 * complexFP::i()*S, coeff2 = 2 * S / (normK*constants::c),
-                        coeff3 = coeff2 - dt;
-
-                    complexGrid->Ex(i, j, k) += coeff1 * crossKB.x - coeff2 * J.x + coeff3 * Jl.x;
-                    complexGrid->Ey(i, j, k) += coeff1 * crossKB.y - coeff2 * J.y + coeff3 * Jl.y;
-                    complexGrid->Ez(i, j, k) += coeff1 * crossKB.z - coeff2 * J.z + coeff3 * Jl.z;
-                }
+                updateRow(this, i, j, begin.z, end.z, dt);
+    }
+
+    template <bool ifPoisson>
+    forceinline void PSATDTimeStraggeredT<ifPoisson>::updateERow(PSATDTimeStraggeredT* solver, int i, int j,
+        int beginK, int endK, FP dt)
+    {
+        for (int k = beginK; k < endK; k++)
+        {
+            FP3 K = solver->getWaveVector(Int3(i, j, k));
+            FP normK = K.norm();
+            if (normK == 0) {
+                solver->complexGrid->Ex(i, j, k) += dt * solver->complexGrid->Jx(i, j, k);
+                solver->complexGrid->Ey(i, j, k) += dt * solver->complexGrid->Jy(i, j, k);
+                solver->complexGrid->Ez(i, j, k) += dt * solver->complexGrid->Jz(i, j, k);
+                continue;
             }
+            K = K / normK;
+
+            ComplexFP3 B(solver->complexGrid->Bx(i, j, k), solver->complexGrid->By(i, j, k), solver->complexGrid->Bz(i, j, k));
+            ComplexFP3 J(solver->complexGrid->Jx(i, j, k), solver->complexGrid->Jy(i, j, k), solver->complexGrid->Jz(i, j, k));
+            ComplexFP3 crossKB = cross((ComplexFP3)K, B);
+            ComplexFP3 Jl = (ComplexFP3)K * dot((ComplexFP3)K, J);
+
+            FP S = sin(normK*constants::c*dt*0.5);
+            complexFP coeff1 = 2 * complexFP::i()*S, coeff2 = 2 * S / (normK*constants::c),
+                coeff3 = coeff2 - dt;
+
+            solver->complexGrid->Ex(i, j, k) += coeff1 * crossKB.x - coeff2 * J.x + coeff3 * Jl.x;
+            solver->complexGrid->Ey(i, j, k) += coeff1 * crossKB.y - coeff2 * J.y + coeff3 * Jl.y;
+            solver->complexGrid->Ez(i, j, k) += coeff1 * crossKB.z - coeff2 * J.z + coeff3 * Jl.z;
+        }
     }
 
     // provides k \cdot E = 0 always (k \cdot J = 0 too)
     template <>
-    inline void PSATDTimeStraggeredT<true>::updateE()
+    forceinline void PSATDTimeStraggeredT<true>::updateERow(PSATDTimeStraggeredT* solver, int i, int j,
+        int beginK, int endK, FP dt)
     {
-        const Int3 begin = updateComplexEAreaBegin;
-        const Int3 end = updateComplexEAreaEnd;
-        OMP_FOR_COLLAPSE()
-        for (int i = begin.x; i < end.x; i++)
-            for (int j = begin.y; j < end.y; j++)
-            {
-                //#pragma omp simd
-                for (int k = begin.z; k < end.z; k++)
-                {
-                    FP3 K = getWaveVector(Int3(i, j, k));
-                    FP normK = K.norm();
-                    if (normK == 0) {
-                        complexGrid->Ex(i, j, k) += dt * complexGrid->Jx(i, j, k);
-                        complexGrid->Ey(i, j, k) += dt * complexGrid->Jy(i, j, k);
-                        complexGrid->Ez(i, j, k) += dt * complexGrid->Jz(i, j, k);
-                        continue;
-                    }
-                    K = K / normK;
-
-                    ComplexFP3 E(complexGrid->Ex(i, j, k), complexGrid->Ey(i, j, k), complexGrid->Ez(i, j, k));
-                    ComplexFP3 B(complexGrid->Bx(i, j, k), complexGrid->By(i, j, k), complexGrid->Bz(i, j, k));
-                    ComplexFP3 J(complexGrid->Jx(i, j, k), complexGrid->Jy(i, j, k), complexGrid->Jz(i, j, k));
-                    ComplexFP3 crossKB = cross((ComplexFP3)K, B);
-                    ComplexFP3 El = (ComplexFP3)K * dot((ComplexFP3)K, E);
-                    ComplexFP3 Jl = (ComplexFP3)K * dot((ComplexFP3)K, J);
-
-                    FP S = sin(normK*constants::c*dt*0.5);
-                    complexFP coeff1 = 2 * complexFP::i()*S, coeff2 = 2 * S / (normK*constants::c),
-                        coeff3 = coeff2 - dt;
-                    complexGrid->Ex(i, j, k) += -El.x + coeff1 * crossKB.x - coeff2 * (J.x - Jl.x);
-                    complexGrid->Ey(i, j, k) += -El.y + coeff1 * crossKB.y - coeff2 * (J.y - Jl.y);
-                    complexGrid->Ez(i, j, k) += -El.z + coeff1 * crossKB.z - coeff2 * (J.z - Jl.z);
-                }
+        for (int k = beginK; k < endK; k++)
+        {
+            FP3 K = solver->getWaveVector(Int3(i, j, k));
+            FP normK = K.norm();
+            if (normK == 0) {
+                solver->complexGrid->Ex(i, j, k) += dt * solver->complexGrid->Jx(i, j, k);
+                solver->complexGrid->Ey(i, j, k) += dt * solver->complexGrid->Jy(i, j, k);
+                solver->complexGrid->Ez(i, j, k) += dt * solver->complexGrid->Jz(i, j, k);
+                continue;
             }
+            K = K / normK;
+
+            ComplexFP3 E(solver->complexGrid->Ex(i, j, k), solver->complexGrid->Ey(i, j, k), solver->complexGrid->Ez(i, j, k));
+            ComplexFP3 B(solver->complexGrid->Bx(i, j, k), solver->complexGrid->By(i, j, k), solver->complexGrid->Bz(i, j, k));
+            ComplexFP3 J(solver->complexGrid->Jx(i, j, k), solver->complexGrid->Jy(i, j, k), solver->complexGrid->Jz(i, j, k));
+            ComplexFP3 crossKB = cross((ComplexFP3)K, B);
+            ComplexFP3 El = (ComplexFP3)K * dot((ComplexFP3)K, E);
+            ComplexFP3 Jl = (ComplexFP3)K * dot((ComplexFP3)K, J);
+
+            FP S = sin(normK*constants::c*dt*0.5);
+            complexFP coeff1 = 2 * complexFP::i()*S, coeff2 = 2 * S / (normK*constants::c),
+                coeff3 = coeff2 - dt;
+            solver->complexGrid->Ex(i, j, k) += -El.x + coeff1 * crossKB.x - coeff2 * (J.x - Jl.x);
+            solver->complexGrid->Ey(i, j, k) += -El.y + coeff1 * crossKB.y - coeff2 * (J.y - Jl.y);
+            solver->complexGrid->Ez(i, j, k) += -El.z + coeff1 * crossKB.z - coeff2 * (J.z - Jl.z);
+        }
     }
 
     template <bool ifPoisson>
@@ -285,6 +319,22 @@ namespace pfc {
             return (PmlSpectralTimeStraggered<GridTypes::PSATDGridType>*)pml.get();
         }
 
+        /* Updates of rows of modes along z, the variants for instruction sets
+        are selected by getCpuIsa() before the loops. */
+        typedef void(*UpdateRow)(PSATDT*, int, int, int, int, FP);
+
+        forceinline static void removeLongitudinalERow(PSATDT* solver, int i, int j,
+            int beginK, int endK, FP dt);
+        forceinline static void updateEBRow(PSATDT* solver, int i, int j,
+            int beginK, int endK, FP dt);
+
+        PFC_KERNEL_VARIANTS(, removeLongitudinalERow, removeLongitudinalERow,
+            (PSATDT* solver, int i, int j, int beginK, int endK, FP dt),
+            (solver, i, j, beginK, endK, dt))
+        PFC_KERNEL_VARIANTS(, updateEBRow, updateEBRow,
+            (PSATDT* solver, int i, int j, int beginK, int endK, FP dt),
+            (solver, i, j, beginK, endK, dt))
+
     };
 
     template <bool ifPoisson>
@@ -346,137 +396,141 @@ namespace pfc {
         doFourierTransform(fourier_transform::Direction::RtoC);
         const Int3 begin = updateComplexBAreaBegin;
         const Int3 end = updateComplexBAreaEnd;
-        double dt = this->dt *0.5;
+        const UpdateRow updateRow = selectKernel(&removeLongitudinalERowGeneric,
+            &removeLongitudinalERowAVX2, &removeLongitudinalERowAVX512);
+        const FP dt = this->dt;
         OMP_FOR_COLLAPSE()
         for (int i = begin.x; i < end.x; i++)
             for (int j = begin.y; j < end.y; j++)
-            {
-                //#pragma omp simd
-                for (int k = begin.z; k < end.z; k++)
-                {
-                    FP3 K = getWaveVector(Int3(i, j, k));
-                    FP normK = K.norm();
-
-                    if (normK == 0) {
-                        continue;
-                    }
-
-                    K = K / normK;
-
-                    ComplexFP3 E(complexGrid->Ex(i, j, k), complexGrid->Ey(i, j, k), complexGrid->Ez(i, j, k));
-                    ComplexFP3 El = (ComplexFP3)K * dot((ComplexFP3)K, E);
-
-                    complexGrid->Ex(i, j, k) -= El.x;
-                    complexGrid->Ey(i, j, k) -= El.y;
-                    complexGrid->Ez(i, j, k) -= El.z;
-                }
-            }
+                updateRow(this, i, j, begin.z, end.z, dt);
         doFourierTransform(fourier_transform::Direction::CtoR);
     }
 
+    template <bool ifPoisson>
+    forceinline void PSATDT<ifPoisson>::removeLongitudinalERow(PSATDT* solver, int i, int j,
+        int beginK, int endK, FP dt)
+    {
+        for (int k = beginK; k < endK; k++)
+        {
+            FP3 K = solver->getWaveVector(Int3(i, j, k));
+            FP normK = K.norm();
+
+            if (normK == 0) {
+                continue;
+            }
+
+            K = K / normK;
+
+            ComplexFP3 E(solver->complexGrid->Ex(i, j, k), solver->complexGrid->Ey(i, j, k), solver->complexGrid->Ez(i, j, k));
+            ComplexFP3 El = (ComplexFP3)K * dot((ComplexFP3)K, E);
+
+            solver->complexGrid->Ex(i, j, k) -= El.x;
+            solver->complexGrid->Ey(i, j, k) -= El.y;
+            solver->complexGrid->Ez(i, j, k) -= El.z;
+        }
+    }
+
     template <bool ifPoisson>
     inline void PSATDT<ifPoisson>::updateEB()
     {
         const Int3 begin = updateComplexBAreaBegin;
         const Int3 end = updateComplexBAreaEnd;
-        double dt = 0.5 * this->dt;
+        const UpdateRow updateRow = selectKernel(&updateEBRowGeneric,
+            &updateEBRowAVX2, &updateEBRowAVX512);
+        const FP dt = 0.5 * this->dt;
         OMP_FOR_COLLAPSE()
         for (int i = begin.x; i < end.x; i++)
             for (int j = begin.y; j < end.y; j++)
-            {
-                //#pragma omp simd
-                for (int k = begin.z; k < end.z; k++)
-                {
-                    FP3 K = getWaveVector(Int3(i, j, k));
-                    FP normK = K.norm();
-
-                    ComplexFP3 E(complexGrid->Ex(i, j, k), complexGrid->Ey(i, j, k), complexGrid->Ez(i, j, k));
-                    ComplexFP3 B(complexGrid->Bx(i, j, k), complexGrid->By(i, j, k), complexGrid->Bz(i, j, k));
-                    ComplexFP3 J(complexGrid->Jx(i, j, k), complexGrid->Jy(i, j, k), complexGrid->Jz(i, j, k));
-                    J = complexFP(4 * constants::pi) * J;
-
-                    if (normK == 0) {
-                        complexGrid->Ex(i, j, k) += -J.x;
-                        complexGrid->Ey(i, j, k) += -J.y;
-                        complexGrid->Ez(i, j, k) += -J.z;
-                        continue;
-                    }
-
-                    K = K / normK;
-
-                    ComplexFP3 kEcross = cross((ComplexFP3)K, E), kBcross = cross((ComplexFP3)K, B),
-                        kJcross = cross((ComplexFP3)K, J);
-                    ComplexFP3 Jl = (ComplexFP3)K * dot((ComplexFP3)K, J), El = (ComplexFP3)K * dot((ComplexFP3)K, E);
-
-                    FP S = sin(normK*constants::c*dt), C = cos(normK*constants::c*dt);
-
-                    complexFP coef1E = S * complexFP::i(), coef2E = -S / (normK*constants::c),
-                        coef3E = S / (normK*constants::c) - dt;
-
-                    complexGrid->Ex(i, j, k) = C * E.x + coef1E * kBcross.x + (1 - C) * El.x + coef2E * J.x + coef3E * Jl.x;
-                    complexGrid->Ey(i, j, k) = C * E.y + coef1E * kBcross.y + (1 - C) * El.y + coef2E * J.y + coef3E * Jl.y;
-                    complexGrid->Ez(i, j, k) = C * E.z + coef1E * kBcross.z + (1 - C) * El.z + coef2E * J.z + coef3E * Jl.z;
-
-                    complexFP coef1B = -S * complexFP::i(), coef2B = ((1 - C) / (normK*constants::c))*complexFP::i();
-
-                    complexGrid->Bx(i, j, k) = C * B.x + coef1B * kEcross.x + coef2B * kJcross.x;
-                    complexGrid->By(i, j, k) = C * B.y + coef1B * kEcross.y + coef2B * kJcross.y;
-                    complexGrid->Bz(i, j, k) = C * B.z + coef1B * kEcross.z + coef2B * kJcross.z;
-                }
+                updateRow(this, i, j, begin.z, end.z, dt);
+    }
+
+    template <bool ifPoisson>
+    forceinline void PSATDT<ifPoisson>::updateEBRow(PSATDT* solver, int i, int j,
+        int beginK, int endK, FP dt)
+    {
+        for (int k = beginK; k < endK; k++)
+        {
+            FP3 K = solver->getWaveVector(Int3(i, j, k));
+            FP normK = K.norm();
+
+            ComplexFP3 E(solver->complexGrid->Ex(i, j, k), solver->complexGrid->Ey(i, j, k), solver->complexGrid->Ez(i, j, k));
+            ComplexFP3 B(solver->complexGrid->Bx(i, j, k), solver->complexGrid->By(i, j, k), solver->complexGrid->Bz(i, j, k));
+            ComplexFP3 J(solver->complexGrid->Jx(i, j, k), solver->complexGrid->Jy(i, j, k), solver->complexGrid->Jz(i, j, k));
+            J = complexFP(4 * constants::pi) * J;
+
+            if (normK == 0) {
+                solver->complexGrid->Ex(i, j, k) += -J.x;
+                solver->complexGrid->Ey(i, j, k) += -J.y;
+                solver->complexGrid->Ez(i, j, k) += -J.z;
+                continue;
             }
+
+            K = K / normK;
+
+            ComplexFP3 kEcross = cross((ComplexFP3)K, E), kBcross = cross((ComplexFP3)K, B),
+                kJcross = cross((ComplexFP3)K, J);
+            ComplexFP3 Jl = (ComplexFP3)K * dot((ComplexFP3)K, J), El = (ComplexFP3)K * dot((ComplexFP3)K, E);
+
+            FP S = sin(normK*constants::c*dt), C = cos(normK*constants::c*dt);
+
+            complexFP coef1E = S * complexFP::i(), coef2E = -S / (normK*constants::c),
+                coef3E = S / (normK*constants::c) - dt;
+
+            solver->complexGrid->Ex(i, j, k) = C * E.x + coef1E * kBcross.x + (1 - C) * El.x + coef2E * J.x + coef3E * Jl.x;
+            solver->complexGrid->Ey(i, j, k) = C * E.y + coef1E * kBcross.y + (1 - C) * El.y + coef2E * J.y + coef3E * Jl.y;
+            solver->complexGrid->Ez(i, j, k) = C * E.z + coef1E * kBcross.z + (1 - C) * El.z + coef2E * J.z + coef3E * Jl.z;
+
+            complexFP coef1B = -S * complexFP::i(), coef2B = ((1 - C) / (normK*constants::c))*complexFP::i();
+
+            solver->complexGrid->Bx(i, j, k) = C * B.x + coef1B * kEcross.x + coef2B * kJcross.x;
+            solver->complexGrid->By(i, j, k) = C * B.y + coef1B * kEcross.y + coef2B * kJcross.y;
+            solver->complexGrid->Bz(i, j, k) = C * B.z + coef1B * kEcross.z + coef2B * kJcross.z;
+        }
     }
 
     // provides k \cdot E = 0 always (k \cdot J = 0 too)
     template <>
-    inline void PSATDT<true>::updateEB()
+    forceinline void PSATDT<true>::updateEBRow(PSATDT* solver, int i, int j,
+        int beginK, int endK, FP dt)
     {
-        const Int3 begin = updateComplexBAreaBegin;
-        const Int3 end = updateComplexBAreaEnd;
-        double dt = 0.5 * this->dt;
-        OMP_FOR_COLLAPSE()
-        for (int i = begin.x; i < end.x; i++)
-            for (int j = begin.y; j < end.y; j++)
-            {
-                //#pragma omp simd
-                for (int k = begin.z; k < end.z; k++)
-                {
-                    FP3 K = getWaveVector(Int3(i, j, k));
-                    FP normK = K.norm();
-
-                    ComplexFP3 E(complexGrid->Ex(i, j, k), complexGrid->Ey(i, j, k), complexGrid->Ez(i, j, k));
-                    ComplexFP3 B(complexGrid->Bx(i, j, k), complexGrid->By(i, j, k), complexGrid->Bz(i, j, k));
-                    ComplexFP3 J(complexGrid->Jx(i, j, k), complexGrid->Jy(i, j, k), complexGrid->Jz(i, j, k));
-                    J = complexFP(4 * constants::pi) * J;
-
-                    if (normK == 0) {
-                        complexGrid->Ex(i, j, k) += -J.x;
-                        complexGrid->Ey(i, j, k) += -J.y;
-                        complexGrid->Ez(i, j, k) += -J.z;
-                        continue;
-                    }
-
-                    K = K / normK;
-
-                    ComplexFP3 kEcross = cross((ComplexFP3)K, E), kBcross = cross((ComplexFP3)K, B),
-                        kJcross = cross((ComplexFP3)K, J);
-                    ComplexFP3 Jl = (ComplexFP3)K * dot((ComplexFP3)K, J), El = (ComplexFP3)K * dot((ComplexFP3)K, E);
-
-                    FP S = sin(normK*constants::c*dt), C = cos(normK*constants::c*dt);
-
-                    complexFP coef1E = S * complexFP::i(), coef2E = -S / (normK*constants::c),
-                        coef3E = S / (normK*constants::c) - dt;
-
-                    complexGrid->Ex(i, j, k) = C * (E.x - El.x) + coef1E * kBcross.x + coef2E * (J.x - Jl.x);
-                    complexGrid->Ey(i, j, k) = C * (E.y - El.y) + coef1E * kBcross.y + coef2E * (J.y - Jl.y);
-                    complexGrid->Ez(i, j, k) = C * (E.z - El.z) + coef1E * kBcross.z + coef2E * (J.z - Jl.z);
-
-                    complexFP coef1B = -S * complexFP::i(), coef2B = ((1 - C) / (normK*constants::c))*complexFP::i();
-
-                    complexGrid->Bx(i, j, k) = C * B.x + coef1B * kEcross.x + coef2B * kJcross.x;
-                    complexGrid->By(i, j, k) = C * B.y + coef1B * kEcross.y + coef2B * kJcross.y;
-                    complexGrid->Bz(i, j, k) = C * B.z + coef1B * kEcross.z + coef2B * kJcross.z;
-                }
+        for (int k = beginK; k < endK; k++)
+        {
+            FP3 K = solver->getWaveVector(Int3(i, j, k));
+            FP normK = K.norm();
+
+            ComplexFP3 E(solver->complexGrid->Ex(i, j, k), solver->complexGrid->Ey(i, j, k), solver->complexGrid->Ez(i, j, k));
+            ComplexFP3 B(solver->complexGrid->Bx(i, j, k), solver->complexGrid->By(i, j, k), solver->complexGrid->Bz(i, j, k));
+            ComplexFP3 J(solver->complexGrid->Jx(i, j, k), solver->complexGrid->Jy(i, j, k), solver->complexGrid->Jz(i, j, k));
+            J = complexFP(4 * constants::pi) * J;
+
+            if (normK == 0) {
+                solver->complexGrid->Ex(i, j, k) += -J.x;
+                solver->complexGrid->Ey(i, j, k) += -J.y;
+                solver->complexGrid->Ez(i, j, k) += -J.z;
+                continue;
             }
+
+            K = K / normK;
+
+            ComplexFP3 kEcross = cross((ComplexFP3)K, E), kBcross = cross((ComplexFP3)K, B),
+                kJcross = cross((ComplexFP3)K, J);
+            ComplexFP3 Jl = (ComplexFP3)K * dot((ComplexFP3)K, J), El = (ComplexFP3)K * dot((ComplexFP3)K, E);
+
+            FP S = sin(normK*constants::c*dt), C = cos(normK*constants::c*dt);
+
+            complexFP coef1E = S * complexFP::i(), coef2E = -S / (normK*constants::c),
+                coef3E = S / (normK*constants::c) - dt;
+
+            solver->complexGrid->Ex(i, j, k) = C * (E.x - El.x) + coef1E * kBcross.x + coef2E * (J.x - Jl.x);
+            solver->complexGrid->Ey(i, j, k) = C * (E.y - El.y) + coef1E * kBcross.y + coef2E * (J.y - Jl.y);
+            solver->complexGrid->Ez(i, j, k) = C * (E.z - El.z) + coef1E * kBcross.z + coef2E * (J.z - Jl.z);
+
+            complexFP coef1B = -S * complexFP::i(), coef2B = ((1 - C) / (normK*constants::c))*complexFP::i();
+
+            solver->complexGrid->Bx(i, j, k) = C * B.x + coef1B * kEcross.x + coef2B * kJcross.x;
+            solver->complexGrid->By(i, j, k) = C * B.y + coef1B * kEcross.y + coef2B * kJcross.y;
+            solver->complexGrid->Bz(i, j, k) = C * B.z + coef1B * kEcross.z + coef2B * kJcross.z;
+        }
     }
 
     typedef PSATDT<true> PSATDPoisson;
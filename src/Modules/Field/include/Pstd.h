@@ -1,5 +1,6 @@
 #pragma once
 #include "Constants.h"
+#include "CpuDispatch.h"
 #include "FieldSolver.h"
 #include "Grid.h"
 #include "Vectors.h"
@@ -38,6 +39,22 @@ namespace pfc {
             return (PmlSpectral<GridTypes::PSTDGridType>*)pml.get();
         }
 
+        /* Updates of rows of modes along z, the variants for instruction sets
+        are selected by getCpuIsa() before the loops. */
+        typedef void(*UpdateRow)(PSTD*, int, int, int, int, FP);
+
+        forceinline static void updateHalfBRow(PSTD* solver, int i, int j,
+            int beginK, int endK, FP dt);
+        forceinline static void updateERow(PSTD* solver, int i, int j,
+            int beginK, int endK, FP dt);
+
+        PFC_KERNEL_VARIANTS(, updateHalfBRow, updateHalfBRow,
+            (PSTD* solver, int i, int j, int beginK, int endK, FP dt),
+            (solver, i, j, beginK, endK, dt))
+        PFC_KERNEL_VARIANTS(, updateERow, updateERow,
+            (PSTD* solver, int i, int j, int beginK, int endK, FP dt),
+            (solver, i, j, beginK, endK, dt))
+
     };
 
     inline PSTD::PSTD(PSTDGrid* grid, double dt) :
@@ -98,46 +115,55 @@ namespace pfc {
     {
         const Int3 begin = updateComplexBAreaBegin;
         const Int3 end = updateComplexBAreaEnd;
-        double dt = 0.5 * this->dt;
+        const UpdateRow updateRow = selectKernel(&updateHalfBRowGeneric,
+            &updateHalfBRowAVX2, &updateHalfBRowAVX512);
+        const FP dt = 0.5 * this->dt;
         OMP_FOR_COLLAPSE()
         for (int i = begin.x; i < end.x; i++)
             for (int j = begin.y; j < end.y; j++)
-            {
-//#pragma omp simd
-                for (int k = begin.z; k < end.z; k++)
-                {
-                    ComplexFP3 E(complexGrid->Ex(i, j, k), complexGrid->Ey(i, j, k), complexGrid->Ez(i, j, k));
-                    ComplexFP3 crossKE = cross((ComplexFP3)getWaveVector(Int3(i, j, k)), E);
-                    complexFP coeff = -complexFP::i() * constants::c * dt;
-
-                    complexGrid->Bx(i, j, k) += coeff * crossKE.x;
-                    complexGrid->By(i, j, k) += coeff * crossKE.y;
-                    complexGrid->Bz(i, j, k) += coeff * crossKE.z;
-                }
-            }
+                updateRow(this, i, j, begin.z, end.z, dt);
+    }
+
+    forceinline void PSTD::updateHalfBRow(PSTD* solver, int i, int j, int beginK, int endK, FP dt)
+    {
+        for (int k = beginK; k < endK; k++)
+        {
+            ComplexFP3 E(solver->complexGrid->Ex(i, j, k), solver->complexGrid->Ey(i, j, k), solver->complexGrid->Ez(i, j, k));
+            ComplexFP3 crossKE = cross((ComplexFP3)solver->getWaveVector(Int3(i, j, k)), E);
+            complexFP coeff = -complexFP::i() * constants::c * dt;
+
+            solver->complexGrid->Bx(i, j, k) += coeff * crossKE.x;
+            solver->complexGrid->By(i, j, k) += coeff * crossKE.y;
+            solver->complexGrid->Bz(i, j, k) += coeff * crossKE.z;
+        }
     }
 
     inline void PSTD::updateE()
     {
         const Int3 begin = updateComplexEAreaBegin;
         const Int3 end = updateComplexEAreaEnd;
+        const UpdateRow updateRow = selectKernel(&updateERowGeneric,
+            &updateERowAVX2, &updateERowAVX512);
+        const FP dt = this->dt;
         OMP_FOR_COLLAPSE()
         for (int i = begin.x; i < end.x; i++)
             for (int j = begin.y; j < end.y; j++)
-            {
-//#pragma omp simd
-                for (int k = begin.z; k < end.z; k++)
-                {
-                    ComplexFP3 B(complexGrid->Bx(i, j, k), complexGrid->By(i, j, k), complexGrid->Bz(i, j, k));
-                    ComplexFP3 J(complexGrid->Jx(i, j, k), complexGrid->Jy(i, j, k), complexGrid->Jz(i, j, k));
-                    ComplexFP3 crossKB = cross((ComplexFP3)getWaveVector(Int3(i, j, k)), B);
-                    complexFP coeff = complexFP::i() * constants::c * dt;
-
-                    complexGrid->Ex(i, j, k) += coeff * crossKB.x - 4 * constants::pi * dt * J.x;
-                    complexGrid->Ey(i, j, k) += coeff * crossKB.y - 4 * constants::pi * dt * J.y;
-                    complexGrid->Ez(i, j, k) += coeff * crossKB.z - 4 * constants::pi * dt * J.z;
-                }
-            }
+                updateRow(this, i, j, begin.z, end.z, dt);
+    }
+
+    forceinline void PSTD::updateERow(PSTD* solver, int i, int j, int beginK, int endK, FP dt)
+    {
+        for (int k = beginK; k < endK; k++)
+        {
+            ComplexFP3 B(solver->complexGrid->Bx(i, j, k), solver->complexGrid->By(i, j, k), solver->complexGrid->Bz(i, j, k));
+            ComplexFP3 J(solver->complexGrid->Jx(i, j, k), solver->complexGrid->Jy(i, j, k), solver->complexGrid->Jz(i, j, k));
+            ComplexFP3 crossKB = cross((ComplexFP3)solver->getWaveVector(Int3(i, j, k)), B);
+            complexFP coeff = complexFP::i() * constants::c * dt;
+
+            solver->complexGrid->Ex(i, j, k) += coeff * crossKB.x - 4 * constants::pi * dt * J.x;
+            solver->complexGrid->Ey(i, j, k) += coeff * crossKB.y - 4 * constants::pi * dt * J.y;
+            solver->complexGrid->Ez(i, j, k) += coeff * crossKB.z - 4 * constants::pi * dt * J.z;
+        }
     }
 
 }
@@ -0,0 +1,671 @@
+#pragma once
+#include "macros.h"
+#include "CpuDispatch.h"
+#include "FormFactor.h"
+#include "Grid.h"
+#include "TiledParticleArray.h"
+#include "Vectors.h"
+
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace pfc
+{
+    enum CurrentDepositionType {
+        CurrentDeposition_CIC, CurrentDeposition_TSC, CurrentDeposition_Esirkepov
+    };
+
+    /* Deposition of the current density of particles onto Jx, Jy, Jz of a grid.
+    CIC and TSC are direct schemes: q * w * v / V is spread from the particle
+    position with the corresponding form factor.
+    Esirkepov is the charge-conserving scheme (T.Zh. Esirkepov, Comput. Phys.
+    Commun. 135, 144 (2001)) with the linear form factor. It uses positions
+    before and after the push, so particles must not move more than a cell per
+    step. It needs a staggered grid: the charge density is at cell centers and
+    Jx, Jy, Jz are on the cell faces as for the Yee grid.
+    Each thread deposits into its own copy of J, the copies are summed into the
+    grid afterwards over the rows along x touched by the thread and are left
+    zeroed for the next call. The current is added to the grid values, call
+    grid->zeroizeJ() before the deposition of all species at a time step.
+    Spectral grids are periodic, for other grids values outside of the storage
+    are skipped.
+    Tiled particles are deposited tile by tile into a buffer of the tile with
+    guard cells that is added to the grid right away. Tiles are processed in
+    phases so that the tiles of a phase are at least a tile apart and their
+    buffers do not overlap, there is no per-thread copy of the whole grid. */
+    template <class TGrid>
+    class CurrentDeposition
+    {
+    public:
+
+        CurrentDeposition(TGrid* grid, CurrentDepositionType type = CurrentDeposition_CIC) :
+            grid(grid)
+        {
+            shifts[0] = grid->JxPosition(0, 0, 0) - grid->origin;
+            shifts[1] = grid->JyPosition(0, 0, 0) - grid->origin;
+            shifts[2] = grid->JzPosition(0, 0, 0) - grid->origin;
+            setType(type);
+        }
+
+        void setType(CurrentDepositionType _type)
+        {
+            if (_type == CurrentDeposition_Esirkepov && !TGrid::ifFieldsSpatialStraggered)
+                throw "Esirkepov current deposition requires a spatially straggered grid";
+            type = _type;
+        }
+
+        CurrentDepositionType getType() const
+        {
+            return type;
+        }
+
+        template<class T_ParticleArray>
+        static void savePositions(T_ParticleArray* particles, std::vector<FP3>& positions)
+        {
+            const int n = (int)particles->size();
+            positions.resize(n);
+            OMP_FOR()
+            for (int i = 0; i < n; i++)
+                positions[i] = (*particles)[i].getPosition();
+        }
+
+        /* Direct deposition from the current positions and velocities. */
+        template<class T_ParticleArray>
+        void operator()(T_ParticleArray* particles)
+        {
+            if (type == CurrentDeposition_Esirkepov)
+                throw "Esirkepov current deposition requires positions before the push";
+
+            typedef void(*DepositBlock)(const CurrentDeposition*, Target*, T_ParticleArray*, int, int);
+            const DepositBlock depositBlock = selectKernel(&depositDirectBlockGeneric<T_ParticleArray>,
+                &depositDirectBlockAVX2<T_ParticleArray>, &depositDirectBlockAVX512<T_ParticleArray>);
+            const int numParticles = (int)particles->size();
+            const int numBlocks = (numParticles + blockSize - 1) / blockSize;
+            prepareBuffers();
+#pragma omp parallel
+            {
+                Target j;
+                getThreadBuffers(j);
+#pragma omp for
+                for (int block = 0; block < numBlocks; block++)
+                    depositBlock(this, &j, particles, block * blockSize,
+                        std::min(numParticles, (block + 1) * blockSize));
+                releaseThreadBuffers(j);
+            }
+            reduceBuffers();
+        }
+
+        /* Deposition for the step from oldPositions to the current positions.
+        Direct schemes use the middle point and the mean velocity. */
+        template<class T_ParticleArray>
+        void operator()(T_ParticleArray* particles, const std::vector<FP3>& oldPositions, FP timeStep)
+        {
+            typedef void(*DepositBlock)(const CurrentDeposition*, Target*, T_ParticleArray*, const FP3*, int, int, FP);
+            const DepositBlock depositBlock = selectKernel(&depositStepBlockGeneric<T_ParticleArray>,
+                &depositStepBlockAVX2<T_ParticleArray>, &depositStepBlockAVX512<T_ParticleArray>);
+            const int numParticles = (int)particles->size();
+            const int numBlocks = (numParticles + blockSize - 1) / blockSize;
+            prepareBuffers();
+#pragma omp parallel
+            {
+                Target j;
+                getThreadBuffers(j);
+#pragma omp for
+                for (int block = 0; block < numBlocks; block++)
+                    depositBlock(this, &j, particles, oldPositions.data(), block * blockSize,
+                        std::min(numParticles, (block + 1) * blockSize), timeStep);
+                releaseThreadBuffers(j);
+            }
+            reduceBuffers();
+        }
+
+        /* Pushes and deposits tiled particles, push(tile) is called for each tile,
+        afterwards particles are moved to their new tiles. Particles must be in their
+        tiles before the call and move less than a cell. Tiles must be of at least
+        2 * guardCells cells along the dimensions with several tiles. */
+        template<Dimension dimension, class Push>
+        void operator()(TiledParticleArray<dimension>* particles, Push push, FP timeStep)
+        {
+            typedef typename TiledParticleArray<dimension>::TileType TileType;
+            typedef void(*DepositBlock)(const CurrentDeposition*, Target*, TileType*, const FP3*, int, int, FP);
+            const DepositBlock depositBlock = selectKernel(&depositStepBlockGeneric<TileType>,
+                &depositStepBlockAVX2<TileType>, &depositStepBlockAVX512<TileType>);
+            const Int3 numTiles = particles->getNumTilesPerDimension();
+            const Int3 tileSize = particles->getTileSize();
+            Int3 maxBufferSize;
+            for (int d = 0; d < 3; d++) {
+                if (particles->getNumCells()[d] != grid->numCells[d])
+                    throw "ERROR: tiles of particles do not match the grid";
+                if (numTiles[d] > 1 && tileSize[d] < 2 * guardCells)
+                    throw "ERROR: tiles are too small for the current deposition";
+                maxBufferSize[d] = (grid->numCells[d] == 1) ? 1 : tileSize[d] + 2 * guardCells;
+            }
+            const int maxBufferVolume = maxBufferSize.x * maxBufferSize.y * maxBufferSize.z;
+
+            const std::vector<std::vector<int>> phases = getTilePhases(particles);
+            for (int phase = 0; phase < (int)phases.size(); phase++)
+            {
+                const std::vector<int>& phaseTiles = phases[phase];
+#pragma omp parallel
+                {
+                    std::vector<FP> buffer(3 * maxBufferVolume);
+                    std::vector<FP3> oldPositions;
+                    Target j;
+#pragma omp for schedule(dynamic)
+                    for (int i = 0; i < (int)phaseTiles.size(); i++)
+                    {
+                        const int t = phaseTiles[i];
+                        TileType& tile = particles->getTile(t);
+                        if (tile.size() == 0)
+                            continue;
+                        getTileBuffer(particles, t, j.begin, j.size);
+                        const int bufferVolume = j.size.x * j.size.y * j.size.z;
+                        for (int c = 0; c < 3; c++)
+                            j.j[c] = buffer.data() + c * bufferVolume;
+                        std::fill(buffer.begin(), buffer.begin() + 3 * bufferVolume, (FP)0);
+                        oldPositions.resize(tile.size());
+                        for (int idx = 0; idx < tile.size(); idx++)
+                            oldPositions[idx] = tile[idx].getPosition();
+                        push(tile);
+                        depositBlock(this, &j, &tile, oldPositions.data(), 0, tile.size(), timeStep);
+                        addTileBuffer(j);
+                    }
+                }
+            }
+            particles->exchange();
+        }
+
+        /* Tiles of the phases of the tiled deposition, tiles of a phase are deposited
+        in parallel and their buffers do not overlap on the grid. */
+        template<Dimension dimension>
+        std::vector<std::vector<int>> getTilePhases(const TiledParticleArray<dimension>* particles) const
+        {
+            const Int3 numTiles = particles->getNumTilesPerDimension();
+            const Int3 lastTileCells = particles->getTileCells(particles->getNumTiles() - 1);
+            Int3 numColors;
+            for (int d = 0; d < 3; d++)
+                numColors[d] = getNumTileColors(numTiles[d], lastTileCells[d]);
+            std::vector<std::vector<int>> phases(numColors.x * numColors.y * numColors.z);
+            for (int t = 0; t < particles->getNumTiles(); t++) {
+                const Int3 tile = particles->getTileCoords(t);
+                Int3 color;
+                for (int d = 0; d < 3; d++)
+                    color[d] = getTileColor(tile[d], numTiles[d], lastTileCells[d]);
+                phases[(color.x * numColors.y + color.y) * numColors.z + color.z].push_back(t);
+            }
+            return phases;
+        }
+
+        /* The first node and the size of the buffer of a tile: the cells of the tile
+        with guard cells, on periodic grids the buffer wraps around the grid. */
+        template<Dimension dimension>
+        void getTileBuffer(const TiledParticleArray<dimension>* particles, int tileIdx,
+            Int3& begin, Int3& size) const
+        {
+            const Int3 tileBegin = particles->getTileBegin(tileIdx);
+            const Int3 tileCells = particles->getTileCells(tileIdx);
+            for (int d = 0; d < 3; d++) {
+                begin[d] = (grid->numCells[d] == 1) ? 0 : tileBegin[d] - guardCells;
+                size[d] = (grid->numCells[d] == 1) ? 1 : tileCells[d] + 2 * guardCells;
+            }
+        }
+
+        // guard cells of buffers of tiles, enough for the stencils of particles moving less than a cell
+        static const int guardCells = 3;
+
+    private:
+
+        /* Where the current goes: the grid or the buffer of a tile of the given size
+        that starts at the node begin of the grid and has the row-major layout.
+        A copy of J of a thread also keeps the rows [rowBegin, rowEnd) along x
+        that the thread touched. */
+        struct Target {
+            FP* j[3];
+            bool isGrid;
+            Int3 begin, size;
+            int rowBegin, rowEnd;
+
+            Target() : isGrid(false), rowBegin(0), rowEnd(0) {}
+        };
+
+        static const bool ifPeriodic = TGrid::gridType == GridTypes::PSTDGridType ||
+            TGrid::gridType == GridTypes::PSATDGridType ||
+            TGrid::gridType == GridTypes::PSATDTimeStraggeredGridType;
+
+        int getMaxThreads() const
+        {
+#ifdef __USE_OMP__
+            return omp_get_max_threads();
+#else
+            return 1;
+#endif
+        }
+
+        int getThreadId() const
+        {
+#ifdef __USE_OMP__
+            return omp_get_thread_num();
+#else
+            return 0;
+#endif
+        }
+
+        int getNumThreads() const
+        {
+#ifdef __USE_OMP__
+            return omp_get_num_threads();
+#else
+            return 1;
+#endif
+        }
+
+        void prepareBuffers()
+        {
+            const int numThreads = getMaxThreads();
+            if ((int)buffers.size() < numThreads) {
+                buffers.resize(numThreads);
+                bufferRanges.resize(numThreads);
+            }
+            numUsedBuffers = 0;
+        }
+
+        /* Must be called by each thread of the parallel region. With one thread in
+        the team the deposition goes directly to the grid. Copies of J are zero
+        between calls, so a copy is zeroed only once by its thread on the first touch. */
+        void getThreadBuffers(Target& j)
+        {
+            j.isGrid = true;
+            const int numThreads = getNumThreads();
+            if (numThreads == 1) {
+                j.j[0] = grid->Jx.getData();
+                j.j[1] = grid->Jy.getData();
+                j.j[2] = grid->Jz.getData();
+                return;
+            }
+            const int thread = getThreadId();
+            if (thread == 0)
+                numUsedBuffers = numThreads;
+            std::vector<FP>& buffer = buffers[thread];
+            const int volume = grid->Jx.getStorageSize();
+            if ((int)buffer.size() != 3 * volume)
+                buffer.assign(3 * volume, (FP)0);
+            for (int d = 0; d < 3; d++)
+                j.j[d] = buffer.data() + d * volume;
+            j.rowBegin = grid->numCells.x;
+            j.rowEnd = 0;
+        }
+
+        /* Extends the touched rows of a copy of J by the stencil of a particle at x,
+        stencils of particles moving less than a cell span [cell - 2, cell + 4). */
+        forceinline void touchRows(Target& j, FP x) const
+        {
+            const int n = grid->numCells.x;
+            const FP cell = std::floor((x - grid->origin.x) / grid->steps.x);
+            int rowBegin = 0, rowEnd = n;
+            // rows of periodic stencils wrapping around the grid are not tracked
+            if (n > 1 && !(ifPeriodic && (cell < 2 || cell + 4 > n))) {
+                rowBegin = (int)std::min(std::max(cell - 2, (FP)0), (FP)n);
+                rowEnd = (int)std::min(std::max(cell + 4, (FP)0), (FP)n);
+            }
+            j.rowBegin = std::min(j.rowBegin, rowBegin);
+            j.rowEnd = std::max(j.rowEnd, rowEnd);
+        }
+
+        /* Must be called by each thread after its deposition, saves the range of
+        storage indices of the touched rows. Indices of all layouts grow along each
+        dimension, so the range is from the first node of the first row to the last
+        node of the last row. */
+        void releaseThreadBuffers(const Target& j)
+        {
+            if (getNumThreads() == 1)
+                return;
+            std::pair<int, int>& range = bufferRanges[getThreadId()];
+            range = std::make_pair(0, 0);
+            if (j.rowBegin < j.rowEnd) {
+                const Int3 size = grid->Jx.getSize();
+                range.first = linearIndex(j.rowBegin, 0, 0);
+                range.second = linearIndex(j.rowEnd - 1, size.y - 1, size.z - 1) + 1;
+            }
+        }
+
+        /* Colors of tiles along a dimension alternate, so that tiles of a color are
+        separated by a tile of at least 2 * guardCells cells. Around periodic grids
+        the last of an odd number of tiles has color 2. The last tile of an even number
+        may be smaller, then it does not separate the tile before it from the first
+        one and the tile before it has color 2. */
+        static int getTileColor(int tile, int numTiles, int lastTileCells)
+        {
+            if (numTiles % 2)
+                return (numTiles > 1 && tile == numTiles - 1) ? 2 : tile % 2;
+            if (lastTileCells < 2 * guardCells && tile == numTiles - 2)
+                return 2;
+            return tile % 2;
+        }
+
+        static int getNumTileColors(int numTiles, int lastTileCells)
+        {
+            if (numTiles == 1)
+                return 1;
+            return (numTiles % 2 || lastTileCells < 2 * guardCells) ? 3 : 2;
+        }
+
+        // adds the buffer of a tile to the grid, must not overlap with buffers added concurrently
+        void addTileBuffer(const Target& j)
+        {
+            FP* gridJ[3] = { grid->Jx.getData(), grid->Jy.getData(), grid->Jz.getData() };
+            for (int i = 0; i < j.size.x; i++) {
+                const int gi = storageIndex(j.begin.x + i, 0);
+                if (gi < 0)
+                    continue;
+                for (int k = 0; k < j.size.y; k++) {
+                    const int gk = storageIndex(j.begin.y + k, 1);
+                    if (gk < 0)
+                        continue;
+                    for (int l = 0; l < j.size.z; l++) {
+                        const int gl = storageIndex(j.begin.z + l, 2);
+                        if (gl < 0)
+                            continue;
+                        const int bufferIdx = (i * j.size.y + k) * j.size.z + l;
+                        const int gridIdx = linearIndex(gi, gk, gl);
+                        for (int c = 0; c < 3; c++)
+                            gridJ[c][gridIdx] += j.j[c][bufferIdx];
+                    }
+                }
+            }
+        }
+
+        /* The layout of J is dispatched once per particle, nodes of the stencil
+        are indexed with the layout known at compile time. */
+        template<class ParticleProxyType>
+        forceinline void depositStep(const Target& j, ParticleProxyType particle, const FP3& oldPosition, FP timeStep) const
+        {
+            switch (grid->Jx.getLayout()) {
+            case ScalarFieldLayout_Bricks:
+                depositStepWithLayout<ScalarFieldLayout_Bricks>(j, particle, oldPosition, timeStep);
+                break;
+            case ScalarFieldLayout_Padded:
+                depositStepWithLayout<ScalarFieldLayout_Padded>(j, particle, oldPosition, timeStep);
+                break;
+            default:
+                depositStepWithLayout<ScalarFieldLayout_RowMajor>(j, particle, oldPosition, timeStep);
+            }
+        }
+
+        forceinline void depositDirect(const Target& j, const FP3& position, const FP3& velocity, FP chargeWeight) const
+        {
+            switch (grid->Jx.getLayout()) {
+            case ScalarFieldLayout_Bricks:
+                depositDirectWithLayout<ScalarFieldLayout_Bricks>(j, position, velocity, chargeWeight);
+                break;
+            case ScalarFieldLayout_Padded:
+                depositDirectWithLayout<ScalarFieldLayout_Padded>(j, position, velocity, chargeWeight);
+                break;
+            default:
+                depositDirectWithLayout<ScalarFieldLayout_RowMajor>(j, position, velocity, chargeWeight);
+            }
+        }
+
+        template<ScalarFieldLayout layout, class ParticleProxyType>
+        forceinline void depositStepWithLayout(const Target& j, ParticleProxyType particle, const FP3& oldPosition,
+            FP timeStep) const
+        {
+            FP3 newPosition = particle.getPosition();
+            FP chargeWeight = particle.getCharge() * particle.getWeight();
+            if (type == CurrentDeposition_Esirkepov)
+                depositEsirkepov<layout>(j, oldPosition, newPosition, particle.getVelocity(),
+                    chargeWeight, timeStep);
+            else
+                depositDirectWithLayout<layout>(j, (FP)0.5 * (oldPosition + newPosition),
+                    (newPosition - oldPosition) / timeStep, chargeWeight);
+        }
+
+        /* Adds the copies of J used in the call to the grid over their touched
+        ranges and zeroes them there. */
+        void reduceBuffers()
+        {
+            const int numBuffers = numUsedBuffers;
+            if (numBuffers == 0)
+                return;
+            const int volume = grid->Jx.getStorageSize();
+            int begin = volume, end = 0;
+            for (int t = 0; t < numBuffers; t++)
+                if (bufferRanges[t].first < bufferRanges[t].second) {
+                    begin = std::min(begin, bufferRanges[t].first);
+                    end = std::max(end, bufferRanges[t].second);
+                }
+            FP* jx = grid->Jx.getData();
+            FP* jy = grid->Jy.getData();
+            FP* jz = grid->Jz.getData();
+            OMP_FOR()
+            for (int idx = begin; idx < end; idx++)
+            {
+                FP sx = 0, sy = 0, sz = 0;
+                for (int t = 0; t < numBuffers; t++)
+                {
+                    if (idx < bufferRanges[t].first || idx >= bufferRanges[t].second)
+                        continue;
+                    FP* buffer = buffers[t].data();
+                    sx += buffer[idx];
+                    sy += buffer[volume + idx];
+                    sz += buffer[2 * volume + idx];
+                    buffer[idx] = 0;
+                    buffer[volume + idx] = 0;
+                    buffer[2 * volume + idx] = 0;
+                }
+                jx[idx] += sx;
+                jy[idx] += sy;
+                jz[idx] += sz;
+            }
+        }
+
+        // Storage index of node idx along dimension d, -1 if it is outside of the grid
+        forceinline int storageIndex(int idx, int d) const
+        {
+            const int n = grid->numCells[d];
+            if (ifPeriodic)
+                return ((idx % n) + n) % n;
+            return (idx >= 0 && idx < n) ? idx : -1;
+        }
+
+        forceinline int linearIndex(int i, int j, int k) const
+        {
+            return grid->Jx.index(i, j, k);
+        }
+
+        template<ScalarFieldLayout layout>
+        forceinline int linearIndex(int i, int j, int k) const
+        {
+            return grid->Jx.template index<layout>(i, j, k);
+        }
+
+        // the same for the target, nodes outside of the buffer of a tile are skipped
+        forceinline int storageIndex(const Target& target, int idx, int d) const
+        {
+            if (target.isGrid)
+                return storageIndex(idx, d);
+            idx -= target.begin[d];
+            return (idx >= 0 && idx < target.size[d]) ? idx : -1;
+        }
+
+        template<ScalarFieldLayout layout>
+        forceinline int linearIndex(const Target& target, int i, int j, int k) const
+        {
+            if (target.isGrid)
+                return linearIndex<layout>(i, j, k);
+            return (i * target.size.y + j) * target.size.z + k;
+        }
+
+        /* Nodes and weights of the form factor along dimension d,
+        returns the number of nodes. */
+        forceinline int getStencil(const Target& target, FP coord, int d, FP shift, int idx[3], FP w[3]) const
+        {
+            if (grid->numCells[d] == 1) {
+                idx[0] = 0;
+                w[0] = 1;
+                return 1;
+            }
+            FP x = (coord - grid->origin[d] - shift) / grid->steps[d];
+            if (type == CurrentDeposition_TSC) {
+                int base = (int)std::floor(x + (FP)0.5);
+                FP c = x - base;
+                for (int n = 0; n < 3; n++) {
+                    idx[n] = storageIndex(target, base + n - 1, d);
+                    w[n] = formfactorTSC(FP(n - 1) - c);
+                }
+                return 3;
+            }
+            int base = (int)std::floor(x);
+            FP c = x - base;
+            idx[0] = storageIndex(target, base, d);
+            w[0] = (FP)1 - c;
+            idx[1] = storageIndex(target, base + 1, d);
+            w[1] = c;
+            return 2;
+        }
+
+        template<ScalarFieldLayout layout>
+        forceinline void depositDirectWithLayout(const Target& j, const FP3& position, const FP3& velocity,
+            FP chargeWeight) const
+        {
+            const FP coeff = chargeWeight / (grid->steps.x * grid->steps.y * grid->steps.z);
+            for (int c = 0; c < 3; c++)
+            {
+                int idx[3][3];
+                FP w[3][3];
+                int n[3];
+                for (int d = 0; d < 3; d++)
+                    n[d] = getStencil(j, position[d], d, shifts[c][d], idx[d], w[d]);
+                const FP value = coeff * velocity[c];
+                for (int ii = 0; ii < n[0]; ii++)
+                    for (int jj = 0; jj < n[1]; jj++)
+                        for (int kk = 0; kk < n[2]; kk++)
+                            if (idx[0][ii] >= 0 && idx[1][jj] >= 0 && idx[2][kk] >= 0)
+                                j.j[c][linearIndex<layout>(j, idx[0][ii], idx[1][jj], idx[2][kk])] +=
+                                    value * w[0][ii] * w[1][jj] * w[2][kk];
+            }
+        }
+
+        template<ScalarFieldLayout layout>
+        forceinline void depositEsirkepov(const Target& j, const FP3& oldPosition, const FP3& newPosition,
+            const FP3& velocity, FP chargeWeight, FP timeStep) const
+        {
+            const FP coeff = chargeWeight / (grid->steps.x * grid->steps.y * grid->steps.z);
+            // s0 and ds are the form factor before the push and its change on 4 nodes
+            // from first[d], charge density nodes are shifted by half a cell
+            FP s0[3][4], ds[3][4];
+            int first[3], n[3];
+            for (int d = 0; d < 3; d++)
+            {
+                if (grid->numCells[d] == 1) {
+                    first[d] = 0;
+                    n[d] = 1;
+                    s0[d][0] = 1;
+                    ds[d][0] = 0;
+                    continue;
+                }
+                FP x0 = (oldPosition[d] - grid->origin[d]) / grid->steps[d] - (FP)0.5;
+                FP x1 = (newPosition[d] - grid->origin[d]) / grid->steps[d] - (FP)0.5;
+                first[d] = (int)std::floor(x0) - 1;
+                n[d] = 4;
+                for (int m = 0; m < 4; m++) {
+                    FP node = (FP)(first[d] + m);
+                    FP w0 = (FP)1 - std::fabs(x0 - node);
+                    FP w1 = (FP)1 - std::fabs(x1 - node);
+                    s0[d][m] = w0 > 0 ? w0 : 0;
+                    ds[d][m] = (w1 > 0 ? w1 : 0) - s0[d][m];
+                }
+            }
+
+            int idx[3][4];
+            for (int d = 0; d < 3; d++)
+                for (int m = 0; m < n[d]; m++)
+                    idx[d][m] = (n[d] == 1) ? 0 : storageIndex(j, first[d] + m, d);
+
+            for (int c = 0; c < 3; c++)
+            {
+                const int a = (c + 1) % 3, b = (c + 2) % 3;
+                // J on the face between nodes m and m + 1 has index m + 1 along c
+                int faceIdx[4];
+                for (int m = 0; m < n[c]; m++)
+                    faceIdx[m] = (n[c] == 1) ? 0 : storageIndex(j, first[c] + m + 1, c);
+                for (int ia = 0; ia < n[a]; ia++)
+                    for (int ib = 0; ib < n[b]; ib++)
+                    {
+                        if (idx[a][ia] < 0 || idx[b][ib] < 0)
+                            continue;
+                        const FP transverse = s0[a][ia] * s0[b][ib] +
+                            (FP)0.5 * (ds[a][ia] * s0[b][ib] + s0[a][ia] * ds[b][ib]) +
+                            ds[a][ia] * ds[b][ib] / (FP)3;
+                        Int3 node;
+                        node[a] = idx[a][ia];
+                        node[b] = idx[b][ib];
+                        if (n[c] == 1) {
+                            node[c] = 0;
+                            j.j[c][linearIndex<layout>(j, node.x, node.y, node.z)] += coeff * velocity[c] * transverse;
+                            continue;
+                        }
+                        const FP value = -coeff * grid->steps[c] / timeStep * transverse;
+                        FP sum = 0;
+                        for (int m = 0; m < 3; m++)
+                        {
+                            sum += ds[c][m];
+                            if (faceIdx[m] < 0)
+                                continue;
+                            node[c] = faceIdx[m];
+                            j.j[c][linearIndex<layout>(j, node.x, node.y, node.z)] += value * sum;
+                        }
+                    }
+            }
+        }
+
+        /* Deposition of the particles [begin, end) of an array by a thread, the stencils
+        also extend the touched rows of j. The variants for instruction sets are selected
+        by getCpuIsa() before the loops and are called for blocks of blockSize particles. */
+        static const int blockSize = 256;
+
+        template<class T_ParticleArray>
+        forceinline static void depositDirectBlock(const CurrentDeposition* deposition, Target* j,
+            T_ParticleArray* particles, int begin, int end)
+        {
+            typedef typename T_ParticleArray::ParticleProxyType ParticleProxyType;
+            for (int i = begin; i < end; i++)
+            {
+                ParticleProxyType particle = (*particles)[i];
+                const FP3 position = particle.getPosition();
+                deposition->touchRows(*j, position.x);
+                deposition->depositDirect(*j, position, particle.getVelocity(),
+                    particle.getCharge() * particle.getWeight());
+            }
+        }
+
+        template<class T_ParticleArray>
+        forceinline static void depositStepBlock(const CurrentDeposition* deposition, Target* j,
+            T_ParticleArray* particles, const FP3* oldPositions, int begin, int end, FP timeStep)
+        {
+            for (int i = begin; i < end; i++) {
+                deposition->touchRows(*j, oldPositions[i].x);
+                deposition->touchRows(*j, (*particles)[i].getPosition().x);
+                deposition->depositStep(*j, (*particles)[i], oldPositions[i], timeStep);
+            }
+        }
+
+        PFC_KERNEL_VARIANTS(template<class T_ParticleArray>, depositDirectBlock, depositDirectBlock<T_ParticleArray>,
+            (const CurrentDeposition* deposition, Target* j, T_ParticleArray* particles, int begin, int end),
+            (deposition, j, particles, begin, end))
+        PFC_KERNEL_VARIANTS(template<class T_ParticleArray>, depositStepBlock, depositStepBlock<T_ParticleArray>,
+            (const CurrentDeposition* deposition, Target* j, T_ParticleArray* particles, const FP3* oldPositions,
+                int begin, int end, FP timeStep),
+            (deposition, j, particles, oldPositions, begin, end, timeStep))
+
+        TGrid* grid;
+        CurrentDepositionType type;
+        FP3 shifts[3];
+        // copies of J of threads, the storage ranges touched in the call and the number of used copies
+        std::vector<std::vector<FP>> buffers;
+        std::vector<std::pair<int, int>> bufferRanges;
+        int numUsedBuffers = 0;
+    };
+}
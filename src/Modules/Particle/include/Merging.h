@@ -27,29 +27,31 @@ namespace pfc
             // k-means for getting cluster numbers
             vector<int> clusterDecomposition = kMeans(momentums, numClusters, iteration);
 
-            vector<vector<Particle3d>> clusters(numClusters);
+            vector<vector<int>> clusters(numClusters);
             for (int i = 0; i < particles.size(); i++)
-                clusters[clusterDecomposition[i]].push_back(Particle3d(particles[i]));
+                clusters[clusterDecomposition[i]].push_back(i);
 
             // Instead of each cluster, we create one particle with a total factor;
-            // the position ones from all, momentum are weighted averages, taking into account the factors
-            particles.clear();
+            // the position ones from all, momentum are weighted averages, taking into account the factors.
+            // The merged particle takes the place of the first one of the cluster, the rest are removed
             for (int j = 0; j < numClusters; j++) {
                 if (clusters[j].empty())
                     continue;
                 std::uniform_int_distribution<unsigned> uniform_dist(0, clusters[j].size() - 1);
-                FP3 position, momentum;
-                vector<FP3> positions;
+                FP3 momentum;
                 double weight = 0.0;
                 for (int k = 0; k < clusters[j].size(); k++) {
-                    positions.push_back(clusters[j][k].getPosition());
-                    momentum += clusters[j][k].getMomentum() * clusters[j][k].getWeight();
-                    weight += clusters[j][k].getWeight();
+                    momentum += particles[clusters[j][k]].getMomentum() * particles[clusters[j][k]].getWeight();
+                    weight += particles[clusters[j][k]].getWeight();
                 }
-                Particle3d mergedParticle(positions[uniform_dist(generator)], momentum / weight,
-                    weight, clusters[j][0].getType());
-                particles.pushBack(mergedParticle);
+                FP3 position = particles[clusters[j][uniform_dist(generator)]].getPosition();
+                Particle3d mergedParticle(position, momentum / weight,
+                    weight, particles[clusters[j][0]].getType());
+                particles.setParticle(clusters[j][0], mergedParticle);
+                for (int k = 1; k < clusters[j].size(); k++)
+                    particles.markRemoved(clusters[j][k]);
             }
+            particles.compact();
         }
 
     private:
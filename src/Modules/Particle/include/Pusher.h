@@ -1,9 +1,12 @@
 #pragma once
 #include "Constants.h"
+#include "CpuDispatch.h"
 #include "Species.h"
 #include "FieldValue.h"
+#include "ParticleArray.h"
 
 
+#include <algorithm>
 #include <array>
 #include <vector>
 
@@ -18,24 +21,33 @@ namespace pfc
 
         template<class T_ParticleArray>
         inline void operator()(T_ParticleArray* particleArray, std::vector<ValueField>& fields, FP timeStep) { };
+
+        // TGrid may be AnalyticalField or any Grid type, fields are computed at particle positions
+        template<class T_ParticleArray, class TGrid>
+        inline void operator()(T_ParticleArray* particleArray, const TGrid* grid, FP timeStep) { };
     };
 
-    class BorisPusher : public ParticlePusher
+    /* The base of pushers given by the change of the momentum of a particle over a step,
+    Derived::pushMomentum(px, py, pz, ex, ey, ez, bx, by, bz, eCoeff, rCoeff) with the momentum
+    in units of mc and eCoeff = timeStep * charge / (2 * mass * c). rCoeff is the coefficient of
+    the radiation friction given by Derived::getRadiationCoeff(type, timeStep), it is zero for
+    pushers without the friction. After the momentum the position is changed with the new
+    velocity. Pushers of arrays call the pusher of a particle of Derived, particles of an
+    SoA array are pushed by a vectorized loop over its columns. */
+    template<class Derived>
+    class ColumnPusher : public ParticlePusher
     {
     public:
 
         template<class T_Particle>
         inline void operator()(T_Particle* particle, ValueField& field, FP timeStep)
         {
-            FP3 e = field.getE();
-            FP3 b = field.getB();
-            FP eCoeff = timeStep * particle->getCharge() / (2 * particle->getMass() * Constants<FP>::lightVelocity());
-            FP3 eMomentum = e * eCoeff;
-            FP3 um = particle->getP() + eMomentum;
-            FP3 t = b * eCoeff / sqrt((FP)1 + um.norm2());
-            FP3 uprime = um + cross(um, t);
-            FP3 s = t * (FP)2 / ((FP)1 + t.norm2());
-            particle->setP(eMomentum + um + cross(uprime, s));
+            FP3 p = particle->getP();
+            const FP3 e = field.E, b = field.B;
+            Derived::pushMomentum(p.x, p.y, p.z, e.x, e.y, e.z, b.x, b.y, b.z,
+                timeStep * particle->getCharge() / (2 * particle->getMass() * Constants<FP>::lightVelocity()),
+                Derived::getRadiationCoeff(particle->getType(), timeStep));
+            particle->setP(p);
             particle->setPosition(particle->getPosition() + timeStep * particle->getVelocity());
         }
 
@@ -49,9 +61,271 @@ namespace pfc
             for (int i = 0; i < particleArray->size(); i++)
             {
                 ParticleProxyType particle = (*particleArray)[i];
-                operator()(&particle, fields[i], timeStep);
+                derived()(&particle, fields[i], timeStep);
             }
         };
+
+        template<class T_ParticleArray, class TGrid>
+        inline void operator()(T_ParticleArray* particleArray, const TGrid* grid, FP timeStep)
+        {
+            typedef typename T_ParticleArray::ParticleProxyType ParticleProxyType;
+
+            OMP_FOR()
+            for (int i = 0; i < particleArray->size(); i++)
+            {
+                ParticleProxyType particle = (*particleArray)[i];
+                ValueField field;
+                grid->getFields(particle.getPosition(), field.E, field.B);
+                derived()(&particle, field, timeStep);
+            }
+        };
+
+        /* Particles of an SoA array have the same charge and mass. They are pushed by
+        blocks: fields of a block are gathered, then the block is pushed by a loop over
+        the columns of the array without proxies, the loop is vectorized. */
+        template<Dimension dimension>
+        inline void operator()(ParticleArraySoA<dimension>* particleArray, std::vector<ValueField>& fields, FP timeStep)
+        {
+            const ValueField* f = fields.data();
+            pushBlocks(particleArray, [f](int idx, const FP3&, FP3& e, FP3& b) {
+                e = f[idx].E;
+                b = f[idx].B;
+            }, timeStep);
+        }
+
+        template<Dimension dimension, class TGrid>
+        inline void operator()(ParticleArraySoA<dimension>* particleArray, const TGrid* grid, FP timeStep)
+        {
+            pushBlocks(particleArray, [grid](int, const FP3& position, FP3& e, FP3& b) {
+                grid->getFields(position, e, b);
+            }, timeStep);
+        }
+
+    protected:
+
+        static FP getRadiationCoeff(ParticleTypes, FP)
+        {
+            return 0;
+        }
+
+        /* The gamma at the end of the step of the rotation of the momentum u by tau = eCoeff * B
+        in the Vay and Higuera-Cary pushers, the root of
+        gamma^2 = 1 + u^2 - tau^2 + (u * tau)^2 / gamma^2. */
+        forceinline static FP getRotationGamma(FP ux, FP uy, FP uz, FP taux, FP tauy, FP tauz)
+        {
+            const FP tau2 = taux * taux + tauy * tauy + tauz * tauz;
+            const FP ut = ux * taux + uy * tauy + uz * tauz;
+            const FP sigma = (FP)1 + ux * ux + uy * uy + uz * uz - tau2;
+            return sqrt((FP)0.5 * (sigma + sqrt(sigma * sigma + 4 * (tau2 + ut * ut))));
+        }
+
+        // u = (u + (u * t) t + u x t) / (1 + t^2)
+        forceinline static void rotate(FP& ux, FP& uy, FP& uz, FP tx, FP ty, FP tz)
+        {
+            const FP sCoeff = (FP)1 / ((FP)1 + tx * tx + ty * ty + tz * tz);
+            const FP ut = ux * tx + uy * ty + uz * tz;
+            const FP rx = sCoeff * (ux + ut * tx + (uy * tz - uz * ty));
+            const FP ry = sCoeff * (uy + ut * ty + (uz * tx - ux * tz));
+            const FP rz = sCoeff * (uz + ut * tz + (ux * ty - uy * tx));
+            ux = rx;
+            uy = ry;
+            uz = rz;
+        }
+
+    private:
+
+        static const int blockSize = 256;
+
+        Derived& derived() { return *static_cast<Derived*>(this); }
+
+        // the coefficient of the field in the change of the momentum in units of mc over half a step
+        static FP getFieldCoeff(ParticleTypes type, FP timeStep)
+        {
+            return timeStep * ParticleInfo::types[type].charge /
+                (2 * ParticleInfo::types[type].mass * Constants<FP>::lightVelocity());
+        }
+
+        // getFields(idx, position, e, b) gives the fields of the idx-th particle
+        template<Dimension dimension, class GetFields>
+        static void pushBlocks(ParticleArraySoA<dimension>* particleArray, GetFields getFields, FP timeStep)
+        {
+            const int positionDimension = ParticleArraySoA<dimension>::positionDimension;
+            FP* x[3];
+            getPositionColumns(particleArray, x);
+            FP* px = particleArray->getPData(0), *py = particleArray->getPData(1), *pz = particleArray->getPData(2);
+            FP* gammas = particleArray->getGammaData();
+            const FP eCoeff = getFieldCoeff(particleArray->getType(), timeStep);
+            const FP rCoeff = Derived::getRadiationCoeff(particleArray->getType(), timeStep);
+            const FP vCoeff = timeStep * Constants<FP>::lightVelocity();
+            const int n = particleArray->size();
+            const int numBlocks = (n + blockSize - 1) / blockSize;
+            const PushBlock pushBlock = selectKernel(&pushBlockGeneric<positionDimension>,
+                &pushBlockAVX2<positionDimension>, &pushBlockAVX512<positionDimension>);
+            typedef void(*GatherBlock)(const GetFields*, int, const FP*, const FP*, const FP*, int, int,
+                FP(*)[blockSize], FP(*)[blockSize]);
+            const GatherBlock gatherBlock = selectKernel(&gatherBlockGeneric<GetFields>,
+                &gatherBlockAVX2<GetFields>, &gatherBlockAVX512<GetFields>);
+            OMP_FOR()
+            for (int block = 0; block < numBlocks; block++)
+            {
+                const int begin = block * blockSize, size = std::min(n - begin, (int)blockSize);
+                FP* x0 = x[0] + begin, *x1 = x[1] + begin, *x2 = x[2] + begin;
+                FP* bpx = px + begin, *bpy = py + begin, *bpz = pz + begin, *bgammas = gammas + begin;
+                FP e[3][blockSize], b[3][blockSize];
+                gatherBlock(&getFields, positionDimension, x0, x1, x2, begin, size, e, b);
+                pushBlock(x0, x1, x2, bpx, bpy, bpz, bgammas, e, b, size, eCoeff, rCoeff, vCoeff);
+            }
+        }
+
+        // gathers fields of the particles [begin, begin + size) with coordinates x0, x1, x2 of the block
+        template<class GetFields>
+        forceinline static void gatherBlockKernel(const GetFields* getFields, int positionDimension,
+            const FP* x0, const FP* x1, const FP* x2, int begin, int size, FP(*e)[blockSize], FP(*b)[blockSize])
+        {
+            for (int i = 0; i < size; i++)
+            {
+                FP3 position(x0[i], x1[i], x2[i]), E, B;
+                for (int d = positionDimension; d < 3; d++)
+                    position[d] = 0;
+                (*getFields)(begin + i, position, E, B);
+                for (int d = 0; d < 3; d++) {
+                    e[d][i] = E[d];
+                    b[d][i] = B[d];
+                }
+            }
+        }
+
+        PFC_KERNEL_VARIANTS(template<class GetFields>, gatherBlock, gatherBlockKernel<GetFields>,
+            (const GetFields* getFields, int positionDimension, const FP* x0, const FP* x1, const FP* x2,
+                int begin, int size, FP(*e)[blockSize], FP(*b)[blockSize]),
+            (getFields, positionDimension, x0, x1, x2, begin, size, e, b))
+
+        typedef void(*PushBlock)(FP*, FP*, FP*, FP*, FP*, FP*, FP*,
+            const FP(*)[blockSize], const FP(*)[blockSize], int, FP, FP, FP);
+
+        template<int positionDimension>
+        forceinline static void pushBlockKernel(FP* x0, FP* x1, FP* x2, FP* px, FP* py, FP* pz, FP* gammas,
+            const FP(*e)[blockSize], const FP(*b)[blockSize], int size, FP eCoeff, FP rCoeff, FP vCoeff)
+        {
+            OMP_SIMD()
+            for (int i = 0; i < size; i++)
+                pushParticle<positionDimension>(x0[i], x1[i], x2[i], px[i], py[i], pz[i], gammas[i],
+                    e[0][i], e[1][i], e[2][i], b[0][i], b[1][i], b[2][i], eCoeff, rCoeff, vCoeff);
+        }
+
+        PFC_KERNEL_VARIANTS(template<int positionDimension>, pushBlock, pushBlockKernel<positionDimension>,
+            (FP* x0, FP* x1, FP* x2, FP* px, FP* py, FP* pz, FP* gammas,
+                const FP(*e)[blockSize], const FP(*b)[blockSize], int size, FP eCoeff, FP rCoeff, FP vCoeff),
+            (x0, x1, x2, px, py, pz, gammas, e, b, size, eCoeff, rCoeff, vCoeff))
+
+        // coordinates above the dimension are the first one, they are neither used nor changed
+        template<Dimension dimension>
+        static void getPositionColumns(ParticleArraySoA<dimension>* particleArray, FP* x[3])
+        {
+            for (int d = 0; d < 3; d++)
+                x[d] = particleArray->getPositionData(
+                    d < ParticleArraySoA<dimension>::positionDimension ? d : 0);
+        }
+
+        // the step of a particle given by the values of its columns, the same as for a particle
+        template<int positionDimension>
+        forceinline static void pushParticle(FP& x, FP& y, FP& z, FP& px, FP& py, FP& pz, FP& gamma,
+            FP ex, FP ey, FP ez, FP bx, FP by, FP bz, FP eCoeff, FP rCoeff, FP vCoeff)
+        {
+            Derived::pushMomentum(px, py, pz, ex, ey, ez, bx, by, bz, eCoeff, rCoeff);
+            gamma = sqrt((FP)1 + px * px + py * py + pz * pz);
+            const FP pCoeff = vCoeff / gamma;
+            x += px * pCoeff;
+            if (positionDimension > 1)
+                y += py * pCoeff;
+            if (positionDimension > 2)
+                z += pz * pCoeff;
+        }
+    };
+
+    /* The Boris pusher: the momentum is rotated by the magnetic field between two
+    halves of the acceleration by the electric field. */
+    class BorisPusher : public ColumnPusher<BorisPusher>
+    {
+    public:
+
+        using ColumnPusher<BorisPusher>::operator();
+
+        template<class T_Particle>
+        inline void operator()(T_Particle* particle, ValueField& field, FP timeStep)
+        {
+            FP3 e = field.getE();
+            FP3 b = field.getB();
+            FP eCoeff = timeStep * particle->getCharge() / (2 * particle->getMass() * Constants<FP>::lightVelocity());
+            FP3 eMomentum = e * eCoeff;
+            FP3 um = particle->getP() + eMomentum;
+            FP3 t = b * eCoeff / sqrt((FP)1 + um.norm2());
+            FP3 uprime = um + cross(um, t);
+            FP3 s = t * (FP)2 / ((FP)1 + t.norm2());
+            particle->setP(eMomentum + um + cross(uprime, s));
+            particle->setPosition(particle->getPosition() + timeStep * particle->getVelocity());
+        }
+
+        // the same step as for a particle by components
+        forceinline static void pushMomentum(FP& px, FP& py, FP& pz,
+            FP ex, FP ey, FP ez, FP bx, FP by, FP bz, FP eCoeff, FP)
+        {
+            const FP emx = ex * eCoeff, emy = ey * eCoeff, emz = ez * eCoeff;
+            const FP umx = px + emx, umy = py + emy, umz = pz + emz;
+            const FP tCoeff = eCoeff / sqrt((FP)1 + umx * umx + umy * umy + umz * umz);
+            const FP tx = bx * tCoeff, ty = by * tCoeff, tz = bz * tCoeff;
+            const FP upx = umx + (umy * tz - umz * ty);
+            const FP upy = umy + (umz * tx - umx * tz);
+            const FP upz = umz + (umx * ty - umy * tx);
+            const FP sCoeff = (FP)2 / ((FP)1 + tx * tx + ty * ty + tz * tz);
+            const FP sx = tx * sCoeff, sy = ty * sCoeff, sz = tz * sCoeff;
+            px = emx + umx + (upy * sz - upz * sy);
+            py = emy + umy + (upz * sx - upx * sz);
+            pz = emz + umz + (upx * sy - upy * sx);
+        }
+    };
+
+    /* The pusher of J.-L. Vay, Phys. Plasmas 15, 056701 (2008). The rotation uses the
+    velocity at the end of the step, so that a particle in crossed fields with E < B
+    drifts with the right velocity at any time step. */
+    class VayPusher : public ColumnPusher<VayPusher>
+    {
+    public:
+
+        forceinline static void pushMomentum(FP& px, FP& py, FP& pz,
+            FP ex, FP ey, FP ez, FP bx, FP by, FP bz, FP eCoeff, FP)
+        {
+            const FP vCoeff = eCoeff / sqrt((FP)1 + px * px + py * py + pz * pz);
+            const FP vx = px * vCoeff, vy = py * vCoeff, vz = pz * vCoeff;
+            px += 2 * ex * eCoeff + (vy * bz - vz * by);
+            py += 2 * ey * eCoeff + (vz * bx - vx * bz);
+            pz += 2 * ez * eCoeff + (vx * by - vy * bx);
+            const FP taux = bx * eCoeff, tauy = by * eCoeff, tauz = bz * eCoeff;
+            const FP tCoeff = (FP)1 / getRotationGamma(px, py, pz, taux, tauy, tauz);
+            rotate(px, py, pz, taux * tCoeff, tauy * tCoeff, tauz * tCoeff);
+        }
+    };
+
+    /* The pusher of A. V. Higuera and J. R. Cary, Phys. Plasmas 24, 052104 (2017).
+    It is the Boris pusher with the gamma of the rotation found as in the Vay pusher,
+    so it conserves the phase space volume and gives the right drift in crossed fields. */
+    class HigueraCaryPusher : public ColumnPusher<HigueraCaryPusher>
+    {
+    public:
+
+        forceinline static void pushMomentum(FP& px, FP& py, FP& pz,
+            FP ex, FP ey, FP ez, FP bx, FP by, FP bz, FP eCoeff, FP)
+        {
+            const FP emx = ex * eCoeff, emy = ey * eCoeff, emz = ez * eCoeff;
+            FP ux = px + emx, uy = py + emy, uz = pz + emz;
+            const FP taux = bx * eCoeff, tauy = by * eCoeff, tauz = bz * eCoeff;
+            const FP tCoeff = (FP)1 / getRotationGamma(ux, uy, uz, taux, tauy, tauz);
+            const FP tx = taux * tCoeff, ty = tauy * tCoeff, tz = tauz * tCoeff;
+            rotate(ux, uy, uz, tx, ty, tz);
+            px = ux + emx + (uy * tz - uz * ty);
+            py = uy + emy + (uz * tx - ux * tz);
+            pz = uz + emz + (ux * ty - uy * tx);
+        }
     };
 
     class RadiationReaction : public ParticlePusher
@@ -92,5 +366,60 @@ namespace pfc
                 operator()(&particle, fields[i], timeStep);
             }
         };
+
+        template<class T_ParticleArray, class TGrid>
+        inline void operator()(T_ParticleArray* particleArray, const TGrid* grid, FP timeStep)
+        {
+            typedef typename T_ParticleArray::ParticleProxyType ParticleProxyType;
+
+            OMP_FOR()
+            for (int i = 0; i < particleArray->size(); i++)
+            {
+                ParticleProxyType particle = (*particleArray)[i];
+                ValueField field;
+                grid->getFields(particle.getPosition(), field.E, field.B);
+                operator()(&particle, field, timeStep);
+            }
+        };
+    };
+
+    /* BorisPusher followed by RadiationReaction in one pass: the momentum after the Boris
+    step is changed by the Landau-Lifshitz friction with the same fields, then the position
+    is changed with the velocity after the friction. The friction acts on electrons and
+    positrons only. */
+    class BorisPusherWithRadiationReaction : public ColumnPusher<BorisPusherWithRadiationReaction>
+    {
+    public:
+
+        // timeStep * (2/3) * r_e^2 / (mc), the friction changes the momentum in units of mc
+        static FP getRadiationCoeff(ParticleTypes type, FP timeStep)
+        {
+            if (type != Electron && type != Positron)
+                return 0;
+            FP c = Constants<FP>::lightVelocity();
+            FP electronMass = Constants<FP>::electronMass();
+            return timeStep * (2.0 / 3.0) * sqr(sqr(Constants<FP>::electronCharge()) / (electronMass * sqr(c))) /
+                (electronMass * c);
+        }
+
+        forceinline static void pushMomentum(FP& px, FP& py, FP& pz,
+            FP ex, FP ey, FP ez, FP bx, FP by, FP bz, FP eCoeff, FP rCoeff)
+        {
+            BorisPusher::pushMomentum(px, py, pz, ex, ey, ez, bx, by, bz, eCoeff, rCoeff);
+            // the force of RadiationReaction with v = c * beta
+            const FP gamma2 = (FP)1 + px * px + py * py + pz * pz;
+            const FP betaCoeff = (FP)1 / sqrt(gamma2);
+            const FP betax = px * betaCoeff, betay = py * betaCoeff, betaz = pz * betaCoeff;
+            const FP eBeta = ex * betax + ey * betay + ez * betaz;
+            const FP bBeta = bx * betax + by * betay + bz * betaz;
+            const FP b2 = bx * bx + by * by + bz * bz;
+            const FP fx = ex + (betay * bz - betaz * by);
+            const FP fy = ey + (betaz * bx - betax * bz);
+            const FP fz = ez + (betax * by - betay * bx);
+            const FP betaFactor = b2 + gamma2 * (fx * fx + fy * fy + fz * fz - eBeta * eBeta);
+            px += rCoeff * ((ey * bz - ez * by) + bx * bBeta + ex * eBeta - betax * betaFactor);
+            py += rCoeff * ((ez * bx - ex * bz) + by * bBeta + ey * eBeta - betay * betaFactor);
+            pz += rCoeff * ((ex * by - ey * bx) + bz * bBeta + ez * eBeta - betaz * betaFactor);
+        }
     };
 }
\ No newline at end of file
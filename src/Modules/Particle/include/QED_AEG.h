@@ -4,10 +4,12 @@
 #include "Grid.h"
 #include "AnalyticalField.h"
 #include "Pusher.h"
-#include "synchrotron.h"
+#include "Random.h"
+#include "SynchrotronTables.h"
 
 #include <omp.h>
-#include <random>
+#include <algorithm>
+#include <cstdint>
 
 using namespace constants;
 namespace pfc
@@ -31,7 +33,8 @@ namespace pfc
             coeffPhoton_probability = 1.0;
             coeffPair_probability = 0.0;
 
-            distribution = std::uniform_real_distribution<FP>(0.0, 1.0);
+            seed = 0;
+            step = 0;
             int max_threads;
 
 #ifdef __USE_OMP__
@@ -41,9 +44,36 @@ namespace pfc
 #endif
             AvalanchePhotons.resize(max_threads);
             AvalancheParticles.resize(max_threads);
-            afterAvalanchePhotons.resize(max_threads);
-            afterAvalancheParticles.resize(max_threads);
+            randomStreams.resize(max_threads);
+            numChunks = 0;
+        }
+
+        /* Random numbers for a particle are given by the seed, the number of the
+        call of processParticles, the type and the index of the particle, so the
+        result does not depend on the number of threads. The counter of calls is reset. */
+        void setSeed(uint64_t _seed)
+        {
+            seed = _seed;
+            step = 0;
+        }
+
+        // the probabilities of photon emission and of pair production are multiplied by the coefficients, 0 disables a process
+        void setProcessCoefficients(FP photonEmission, FP pairProduction)
+        {
+            coeffPhoton_probability = photonEmission;
+            coeffPair_probability = pairProduction;
+        }
+
+        /* Energy fractions of photons and pairs are sampled from the tables for chi in
+        [chiMin, chiMax] and by the rejection method outside. */
+        void setTablesResolution(int numChi, int numFractions, FP chiMin = 1e-3, FP chiMax = 1e3)
+        {
+            tables = SynchrotronTables(numChi, numFractions, chiMin, chiMax);
+        }
 
+        const SynchrotronTables& getTables() const
+        {
+            return tables;
         }
 
         void processParticles(Ensemble3d* particles, TGrid* grid, FP timeStep)
@@ -59,9 +89,10 @@ namespace pfc
             {
                 AvalanchePhotons[th].clear();
                 AvalancheParticles[th].clear();
-                afterAvalanchePhotons[th].clear();
-                afterAvalancheParticles[th].clear();
             }
+            for (int chunk = 0; chunk < numChunks; chunk++)
+                afterAvalanche[chunk].clear();
+            numChunks = 0;
 
             if ((*particles)[Photon].size() && coeffPair_probability != 0)
                 HandlePhotons((*particles)[Photon], grid, timeStep);
@@ -70,17 +101,11 @@ namespace pfc
             if ((*particles)[Positron].size() && coeffPhoton_probability != 0)
                 HandleParticles((*particles)[Positron], grid, timeStep);
 
-            for (int th = 0; th < max_threads; th++)
-            {
-                for (int ind = 0; ind < afterAvalanchePhotons[th].size(); ind++)
-                {
-                    particles->addParticle(afterAvalanchePhotons[th][ind]);
-                }
-                for (int ind = 0; ind < afterAvalancheParticles[th].size(); ind++)
-                {
-                    particles->addParticle(afterAvalancheParticles[th][ind]);
-                }
-            }
+            // decayed photons are removed once per step
+            (*particles)[Photon].compact();
+            // chunks are in the order of their sources, so the result is the same for any number of threads
+            particles->addParticles(afterAvalanche);
+            step++;
         }
 
         void Boris(Particle3d&& particle, const FP3& e, const FP3& b, FP timeStep)
@@ -110,8 +135,9 @@ namespace pfc
         void HandlePhotons(ParticleArray3d& particles, TGrid* grid, FP timeStep)
         {
             FP dt = timeStep;
+            const int firstChunk = addChunks(particles.size());
 #pragma omp parallel for schedule(dynamic, 1)
-            for (int i = 0; i < particles.size(); i++)
+            for (int chunk = firstChunk; chunk < numChunks; chunk++)
             {
                 int thread_id;
 #ifdef __USE_OMP__
@@ -119,70 +145,77 @@ namespace pfc
 #else
                 thread_id = 0;
 #endif
-                FP3 pPos = particles[i].getPosition();
-                FP3 k = particles[i].getVelocity();
-                FP3 e, b;
+                vector<Particle3d>& newParticles = afterAvalanche[chunk];
+                const int end = std::min(particles.size(), (chunk - firstChunk + 1) * chunkSize);
+                for (int i = (chunk - firstChunk) * chunkSize; i < end; i++)
+                {
+                    setRandomStream(thread_id, Photon, i);
+                    FP3 pPos = particles[i].getPosition();
+                    FP3 k = particles[i].getVelocity();
+                    FP3 e, b;
 
-                e = grid->getE(pPos);
-                b = grid->getB(pPos);
+                    e = grid->getE(pPos);
+                    b = grid->getB(pPos);
 
-                k = (1 / k.norm()) * k; // normalized wave vector
-                particles[i].setPosition(pPos + dt * Constants<FP>::lightVelocity() * k);
+                    k = (1 / k.norm()) * k; // normalized wave vector
+                    particles[i].setPosition(pPos + dt * Constants<FP>::lightVelocity() * k);
 
-                FP H_eff = sqrt(sqr(e + VP(k, b)) - sqr(SP(e, k)));
+                    FP H_eff = sqrt(sqr(e + VP(k, b)) - sqr(SP(e, k)));
 
-                FP HE = H_eff / SchwingerField;
-                FP pGamma = particles[i].getMomentum().norm() / (Constants<FP>::electronMass() * Constants<FP>::lightVelocity());
-                FP EstimatedProbability = dt * estimatedPhotons(HE, pGamma);
+                    FP HE = H_eff / SchwingerField;
+                    FP pGamma = particles[i].getMomentum().norm() / (Constants<FP>::electronMass() * Constants<FP>::lightVelocity());
+                    FP EstimatedProbability = dt * estimatedPhotons(HE, pGamma);
 
-                FP Factor = 1;
-                if (EstimatedProbability < MinProbability)
-                {
-                    FP r0 = random_number_omp();
-                    if (r0 > EstimatedProbability / MinProbability)
-                        continue;
-                    else
-                        Factor = MinProbability / EstimatedProbability;
-                }
-                if (EstimatedProbability < MaxProbability)
-                {
-                    //=======handle single event========
-                    double gamma = pGamma;
-                    double chi = gamma * H_eff / SchwingerField;
-                    double delta = Pair_Generator(Factor, chi, gamma, dt);
-                    if (delta != 0)
+                    FP Factor = 1;
+                    if (EstimatedProbability < MinProbability)
                     {
-                        Particle3d NewParticle;
-                        NewParticle.setType(Electron);
-                        NewParticle.setWeight(particles[i].getWeight());
-                        NewParticle.setPosition(particles[i].getPosition());
-                        NewParticle.setMomentum(delta * particles[i].getMomentum());
-
-                        afterAvalancheParticles[thread_id].push_back(NewParticle);
-
-                        NewParticle.setType(Positron);
-                        NewParticle.setMomentum((1 - delta) * particles[i].getMomentum());
-
-                        afterAvalancheParticles[thread_id].push_back(NewParticle);
-
-                        //deletePhoton
+                        FP r0 = random_number_omp();
+                        if (r0 > EstimatedProbability / MinProbability)
+                            continue;
+                        else
+                            Factor = MinProbability / EstimatedProbability;
+                    }
+                    if (EstimatedProbability < MaxProbability)
+                    {
+                        //=======handle single event========
+                        double gamma = pGamma;
+                        double chi = gamma * H_eff / SchwingerField;
+                        double delta = Pair_Generator(Factor, chi, gamma, dt);
+                        if (delta != 0)
+                        {
+                            Particle3d NewParticle;
+                            NewParticle.setType(Electron);
+                            NewParticle.setWeight(particles[i].getWeight());
+                            NewParticle.setPosition(particles[i].getPosition());
+                            NewParticle.setMomentum(delta * particles[i].getMomentum());
+
+                            newParticles.push_back(NewParticle);
+
+                            NewParticle.setType(Positron);
+                            NewParticle.setMomentum((1 - delta) * particles[i].getMomentum());
+
+                            newParticles.push_back(NewParticle);
+
+                            particles.markRemoved(i);
+                        }
+                    }
+                    else {
+                        //=======handle avalanche========
+                        AvalancheParticles[thread_id].clear();
+                        AvalanchePhotons[thread_id].clear();
+                        AvalanchePhotons[thread_id].push_back(particles[i]);
+                        particles[i].setPosition(particles[i].getPosition() - dt * Constants<FP>::lightVelocity() * k); // go back
+
+                        RunAvalanche(H_eff, e, b, Photon, pGamma, dt);
+
+                        // the photon is either decayed or among the new photons
+                        particles.markRemoved(i);
+
+                        for (int k = 0; k != AvalanchePhotons[thread_id].size(); k++)
+                            newParticles.push_back(AvalanchePhotons[thread_id][k]);
+                        for (int k = 0; k != AvalancheParticles[thread_id].size(); k++)
+                            newParticles.push_back(AvalancheParticles[thread_id][k]);
                     }
-                }
-                else {
-                    //=======handle avalanche========
-                    AvalancheParticles[thread_id].clear();
-                    AvalanchePhotons[thread_id].clear();
-                    AvalanchePhotons[thread_id].push_back(particles[i]);
-                    particles[i].setPosition(particles[i].getPosition() - dt * Constants<FP>::lightVelocity() * k); // go back
-
-                    RunAvalanche(H_eff, e, b, Photon, pGamma, dt);
-
-                    //deletePhoton
-
-                    for (int k = 0; k != AvalanchePhotons[thread_id].size(); k++)
-                        afterAvalanchePhotons[thread_id].push_back(AvalanchePhotons[thread_id][k]);
-                    for (int k = 0; k != AvalancheParticles[thread_id].size(); k++)
-                        afterAvalancheParticles[thread_id].push_back(AvalancheParticles[thread_id][k]);
                 }
             }
         }
@@ -190,8 +223,9 @@ namespace pfc
         void HandleParticles(ParticleArray3d& particles, TGrid* grid, FP timeStep)
         {
             FP dt = timeStep;
+            const int firstChunk = addChunks(particles.size());
 #pragma omp parallel for schedule(dynamic, 1)
-            for (int i = 0; i < particles.size(); i++)
+            for (int chunk = firstChunk; chunk < numChunks; chunk++)
             {
                 int thread_id;
 #ifdef __USE_OMP__
@@ -199,72 +233,78 @@ namespace pfc
 #else
                 thread_id = 0;
 #endif
-                FP3 pPos = particles[i].getPosition();
-                FP3 v = particles[i].getVelocity();
-                FP3 e, b;
-
-                e = grid->getE(pPos);
-                b = grid->getB(pPos);
-
-                FP H_eff = sqr(e + (1 / Constants<FP>::lightVelocity()) * VP(v, b))
-                    - sqr(SP(e, v) / Constants<FP>::lightVelocity());
-                if (H_eff < 0)
-                    H_eff = 0;
-                H_eff = sqrt(H_eff);
+                vector<Particle3d>& newParticles = afterAvalanche[chunk];
+                const int end = std::min(particles.size(), (chunk - firstChunk + 1) * chunkSize);
+                for (int i = (chunk - firstChunk) * chunkSize; i < end; i++)
+                {
+                    setRandomStream(thread_id, particles[i].getType(), i);
+                    FP3 pPos = particles[i].getPosition();
+                    FP3 v = particles[i].getVelocity();
+                    FP3 e, b;
+
+                    e = grid->getE(pPos);
+                    b = grid->getB(pPos);
+
+                    FP H_eff = sqr(e + (1 / Constants<FP>::lightVelocity()) * VP(v, b))
+                        - sqr(SP(e, v) / Constants<FP>::lightVelocity());
+                    if (H_eff < 0)
+                        H_eff = 0;
+                    H_eff = sqrt(H_eff);
 
-                FP pGamma = particles[i].getGamma();
-                FP HE = H_eff / SchwingerField;
-                FP EstimatedProbability = dt * estimatedParticles(HE, pGamma);
+                    FP pGamma = particles[i].getGamma();
+                    FP HE = H_eff / SchwingerField;
+                    FP EstimatedProbability = dt * estimatedParticles(HE, pGamma);
 
-                FP Factor = 1;
+                    FP Factor = 1;
 
-                if (EstimatedProbability < MinProbability)
-                {
-                    FP r0 = random_number_omp();
-                    if (r0 > EstimatedProbability / MinProbability)
+                    if (EstimatedProbability < MinProbability)
+                    {
+                        FP r0 = random_number_omp();
+                        if (r0 > EstimatedProbability / MinProbability)
+                        {
+                            Boris(particles[i], e, b, dt);
+                            continue;
+                        }
+                        else
+                            Factor = MinProbability / EstimatedProbability;
+                    }
+                    if (EstimatedProbability < MaxProbability)
                     {
+                        //=======handle single event========
+                        double gamma = pGamma;
+                        double chi = gamma * H_eff / SchwingerField;
+                        double delta = Photon_MGenerator(Factor, chi, gamma, dt);
+                        if (delta != 0)
+                        {
+                            Particle3d NewParticle;
+                            NewParticle.setType(Photon);
+                            NewParticle.setWeight(particles[i].getWeight());
+                            NewParticle.setPosition(particles[i].getPosition());
+                            NewParticle.setMomentum(delta * particles[i].getMomentum());
+
+                            newParticles.push_back(NewParticle);
+
+                            particles[i].setMomentum((1 - delta) * particles[i].getMomentum());
+                        }
                         Boris(particles[i], e, b, dt);
-                        continue;
                     }
                     else
-                        Factor = MinProbability / EstimatedProbability;
-                }
-                if (EstimatedProbability < MaxProbability)
-                {
-                    //=======handle single event========
-                    double gamma = pGamma;
-                    double chi = gamma * H_eff / SchwingerField;
-                    double delta = Photon_MGenerator(Factor, chi, gamma, dt);
-                    if (delta != 0)
                     {
-                        Particle3d NewParticle;
-                        NewParticle.setType(Photon);
-                        NewParticle.setWeight(particles[i].getWeight());
-                        NewParticle.setPosition(particles[i].getPosition());
-                        NewParticle.setMomentum(delta * particles[i].getMomentum());
+                        //=======handle avalanche========
+                        AvalancheParticles[thread_id].clear();
+                        AvalanchePhotons[thread_id].clear();
+                        AvalancheParticles[thread_id].push_back(particles[i]);
+                        RunAvalanche(H_eff, e, b, particles[i].getType(), pGamma, dt);
 
-                        afterAvalanchePhotons[thread_id].push_back(NewParticle);
+                        for (int k = 0; k != AvalanchePhotons[thread_id].size(); k++)
+                            newParticles.push_back(AvalanchePhotons[thread_id][k]);
 
-                        particles[i].setMomentum((1 - delta) * particles[i].getMomentum());
-                    }
-                    Boris(particles[i], e, b, dt);
-                }
-                else
-                {
-                    //=======handle avalanche========
-                    AvalancheParticles[thread_id].clear();
-                    AvalanchePhotons[thread_id].clear();
-                    AvalancheParticles[thread_id].push_back(particles[i]);
-                    RunAvalanche(H_eff, e, b, particles[i].getType(), pGamma, dt);
-
-                    for (int k = 0; k != AvalanchePhotons[thread_id].size(); k++)
-                        afterAvalanchePhotons[thread_id].push_back(AvalanchePhotons[thread_id][k]);
+                        particles[i].setMomentum(AvalancheParticles[thread_id][0].getMomentum());
+                        particles[i].setPosition(AvalancheParticles[thread_id][0].getPosition());
 
-                    particles[i].setMomentum(AvalancheParticles[thread_id][0].getMomentum());
-                    particles[i].setPosition(AvalancheParticles[thread_id][0].getPosition());
-
-                    for (int k = 1; k != AvalancheParticles[thread_id].size(); k++)
-                        afterAvalancheParticles[thread_id].push_back(AvalancheParticles[thread_id][k]);
+                        for (int k = 1; k != AvalancheParticles[thread_id].size(); k++)
+                            newParticles.push_back(AvalancheParticles[thread_id][k]);
+                    }
                 }
             }
         }
@@ -375,27 +415,25 @@ namespace pfc
 
         FP Photon_probability(FP chi, FP gamma, FP d)
         {
-            FP z = (2 / 3.0) * (1 / chi) * d / (1 - d);
-            FP coeff = (sqrt(3.0) / (2.0 * pi)) * coeffPhoton_probability;
-            if ((z < 700) && (z > 0))
-                return coeff * (chi / gamma) * ((1 - d) / d) * (synchrotron_1(z) + (3 / 2.0) * d * chi * z * synchrotron_2(z));
-            else
-                return 0;
+            return coeffPhoton_probability / gamma * SynchrotronTables::photonSpectrum(chi, d);
         }
 
         FP Pair_probability(FP chi, FP gamma, FP d)
         {
-            FP z_p = (2 / 3.0) / (chi * (1 - d) * d);
-            FP coeff = (sqrt(3.0) / (2.0 * pi)) * coeffPair_probability;
-            if ((z_p < 700) && (z_p > 0))
-                return coeff * (chi / gamma) * (d - 1) * d * (synchrotron_1(z_p) - (3 / 2.0) * chi * z_p * synchrotron_2(z_p));
-            else
-                return 0;
+            return coeffPair_probability / gamma * SynchrotronTables::pairSpectrum(chi, d);
         }
 
         FP Pair_Generator(FP Factor, FP chi, FP gamma, FP dt) //returns photon energy in mc2gamma in case of generation.
         {
             FP factor = Factor * dt * preFactor;
+            if (tables.contains(chi))
+            {
+                FP r = random_number_omp();
+                if (r < factor * coeffPair_probability / gamma * tables.pairRate(chi))
+                    return tables.pairFraction(chi, random_number_omp());
+                else
+                    return 0;
+            }
             FP r1 = random_number_omp();
             FP r2 = random_number_omp();
             if (r2 < factor * Pair_probability(chi, gamma, r1))
@@ -405,6 +443,14 @@ namespace pfc
         }
         FP Photon_MGenerator(FP Factor, FP chi, FP gamma, FP dt) //Modified event generator: returns photon energy in mc2gamma in case of generation, !doesn't change gamma
         {
+            if (tables.contains(chi))
+            {
+                FP r = random_number_omp();
+                if (r < Factor * dt * preFactor * coeffPhoton_probability / gamma * tables.photonRate(chi))
+                    return tables.photonFraction(chi, random_number_omp());
+                else
+                    return 0;
+            }
             double r0 = random_number_omp();
             double r1 = r0 * r0 * r0;
             double r2 = random_number_omp();
@@ -427,12 +473,31 @@ namespace pfc
     private:
 
 
+        // the stream of the thread is given by the particle being handled
+        void setRandomStream(int thread_id, int particleType, int particleIdx)
+        {
+            randomStreams[thread_id] = RandomStream(seed, step, (uint32_t)particleType, (uint32_t)particleIdx);
+        }
+
         FP random_number_omp()
         {
-            FP rand_n;
-#pragma omp critical
-            rand_n = distribution(rand_generator);
-            return rand_n;
+            int thread_id;
+#ifdef __USE_OMP__
+            thread_id = omp_get_thread_num();
+#else
+            thread_id = 0;
+#endif
+            return randomStreams[thread_id].next();
+        }
+
+        // adds chunks of new particles for the given number of sources, returns the first one
+        int addChunks(int numSources)
+        {
+            int firstChunk = numChunks;
+            numChunks += (numSources + chunkSize - 1) / chunkSize;
+            if (afterAvalanche.size() < numChunks)
+                afterAvalanche.resize(numChunks);
+            return firstChunk;
         }
 
         FP MinProbability, MaxProbability;
@@ -440,12 +505,18 @@ namespace pfc
         FP preFactor;
         FP coeffPhoton_probability, coeffPair_probability;
 
-        std::default_random_engine rand_generator;
-        std::uniform_real_distribution<FP> distribution;
+        SynchrotronTables tables;
+
+        uint64_t seed;
+        uint32_t step;
+        vector<RandomStream> randomStreams;
 
 
         vector<vector<Particle3d>> AvalanchePhotons, AvalancheParticles;
-        vector<vector<Particle3d>> afterAvalanchePhotons, afterAvalancheParticles;
+        // new particles of chunks of chunkSize sources, a chunk is handled by a single thread
+        static const int chunkSize = 16;
+        vector<vector<Particle3d>> afterAvalanche;
+        int numChunks;
     };
 
     typedef ScalarQED_AEG_only_electron<YeeGrid> ScalarQED_AEG_only_electron_Yee;
@@ -0,0 +1,183 @@
+#pragma once
+#include "Constants.h"
+#include "FP.h"
+#include "macros.h"
+#include "synchrotron.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+
+namespace pfc
+{
+    /* Tables of the photon emission and of the pair production probabilities
+    as functions of the quantum parameter chi. For each chi from a logarithmic
+    grid in [chiMin, chiMax] the rate integrated over the energy fraction and
+    the inverse cumulative distribution of the fraction are stored, so that
+    the fraction is sampled from a uniform number without rejection.
+    The rates are given without the factor preFactor / gamma. */
+    class SynchrotronTables
+    {
+    public:
+
+        SynchrotronTables(int numChi = 128, int numFractions = 256, FP chiMin = 1e-3, FP chiMax = 1e3)
+        {
+            if (numChi < 3 || numFractions < 2 || chiMin <= 0 || chiMax <= chiMin)
+                throw "ERROR: wrong parameters of synchrotron tables";
+            this->numChi = numChi;
+            this->numFractions = numFractions;
+            this->chiMin = chiMin;
+            this->chiMax = chiMax;
+            logChiMin = log(chiMin);
+            logChiStep = (log(chiMax) - logChiMin) / (numChi - 1);
+            photonLogRate.resize(numChi);
+            pairLogRate.resize(numChi);
+            photonInverseDistribution.resize(numChi * numFractions);
+            pairInverseDistribution.resize(numChi * numFractions);
+            for (int i = 0; i < numChi; i++) {
+                FP chi = exp(logChiMin + i * logChiStep);
+                photonLogRate[i] = tabulate(&photonSpectrum, chi, &photonInverseDistribution[i * numFractions]);
+                pairLogRate[i] = tabulate(&pairSpectrum, chi, &pairInverseDistribution[i * numFractions]);
+            }
+        }
+
+        int getNumChi() const { return numChi; }
+        int getNumFractions() const { return numFractions; }
+        FP getChiMin() const { return chiMin; }
+        FP getChiMax() const { return chiMax; }
+
+        bool contains(FP chi) const
+        {
+            return (chi >= chiMin) && (chi <= chiMax);
+        }
+
+        // chi must be in [chiMin, chiMax] in the following functions
+
+        FP photonRate(FP chi) const
+        {
+            return rate(photonLogRate, chi);
+        }
+
+        FP pairRate(FP chi) const
+        {
+            return rate(pairLogRate, chi);
+        }
+
+        // energy fraction of the photon, r is uniform in [0, 1)
+        FP photonFraction(FP chi, FP r) const
+        {
+            return fraction(photonInverseDistribution, chi, r);
+        }
+
+        // energy fraction of the electron, r is uniform in [0, 1)
+        FP pairFraction(FP chi, FP r) const
+        {
+            return fraction(pairInverseDistribution, chi, r);
+        }
+
+        // probability density of emission of a photon with the energy fraction d
+        static FP photonSpectrum(FP chi, FP d)
+        {
+            FP z = (2 / 3.0) * (1 / chi) * d / (1 - d);
+            FP coeff = sqrt(3.0) / (2.0 * constants::pi);
+            if ((z < 700) && (z > 0))
+                return coeff * chi * ((1 - d) / d) * (synchrotron_1(z) + (3 / 2.0) * d * chi * z * synchrotron_2(z));
+            else
+                return 0;
+        }
+
+        // probability density of creation of a pair with the electron energy fraction d
+        static FP pairSpectrum(FP chi, FP d)
+        {
+            FP z_p = (2 / 3.0) / (chi * (1 - d) * d);
+            FP coeff = sqrt(3.0) / (2.0 * constants::pi);
+            if ((z_p < 700) && (z_p > 0))
+                return coeff * chi * (d - 1) * d * (synchrotron_1(z_p) - (3 / 2.0) * chi * z_p * synchrotron_2(z_p));
+            else
+                return 0;
+        }
+
+    private:
+
+        // the fraction is d(s) = s^3 / (s^3 + (1 - s)^3), the grid of s resolves both ends
+        static FP fractionOf(FP s)
+        {
+            FP s3 = s * s * s, t3 = (1 - s) * (1 - s) * (1 - s);
+            return s3 / (s3 + t3);
+        }
+
+        static FP fractionDerivative(FP s)
+        {
+            FP s3 = s * s * s, t3 = (1 - s) * (1 - s) * (1 - s);
+            return 3 * s * s * (1 - s) * (1 - s) / sqr(s3 + t3);
+        }
+
+        // fills the inverse cumulative distribution, returns the log of the rate
+        FP tabulate(FP(*spectrum)(FP, FP), FP chi, FP* inverseDistribution) const
+        {
+            const int numIntervals = 16 * numFractions;
+            std::vector<FP> distribution(numIntervals + 1);
+            distribution[0] = 0;
+            FP previous = 0;
+            for (int i = 1; i <= numIntervals; i++) {
+                FP s = (FP)i / numIntervals;
+                FP current = (i < numIntervals) ? spectrum(chi, fractionOf(s)) * fractionDerivative(s) : 0;
+                distribution[i] = distribution[i - 1] + (FP)0.5 * (previous + current) / numIntervals;
+                previous = current;
+            }
+            FP total = distribution[numIntervals];
+            if (total <= 0) {
+                for (int j = 0; j < numFractions; j++)
+                    inverseDistribution[j] = (FP)0.5;
+                return log(DBL_MIN);
+            }
+            int i = 0;
+            for (int j = 0; j < numFractions; j++) {
+                FP v = (FP)j / (numFractions - 1);
+                FP value = total * (1 - (1 - v) * (1 - v));
+                while (i < numIntervals - 1 && distribution[i + 1] < value)
+                    i++;
+                FP width = distribution[i + 1] - distribution[i];
+                FP w = (width > 0) ? std::min((FP)1, std::max((FP)0, (value - distribution[i]) / width)) : 0;
+                inverseDistribution[j] = fractionOf((i + w) / numIntervals);
+            }
+            return log(std::max(total, (FP)DBL_MIN));
+        }
+
+        forceinline void chiPosition(FP chi, int& idx, FP& w) const
+        {
+            FP x = (log(chi) - logChiMin) / logChiStep;
+            idx = std::min(std::max((int)x, 0), numChi - 2);
+            w = x - idx;
+        }
+
+        FP rate(const std::vector<FP>& logRate, FP chi) const
+        {
+            // quadratic interpolation of the log of the rate, the pair rate is exponential in 1 / chi
+            FP x = (log(chi) - logChiMin) / logChiStep;
+            int idx = std::min(std::max((int)(x + (FP)0.5), 1), numChi - 2);
+            FP w = x - idx;
+            return exp((FP)0.5 * w * (w - 1) * logRate[idx - 1] + (1 - w * w) * logRate[idx] +
+                (FP)0.5 * w * (w + 1) * logRate[idx + 1]);
+        }
+
+        FP fraction(const std::vector<FP>& table, FP chi, FP r) const
+        {
+            int idx;
+            FP w;
+            chiPosition(chi, idx, w);
+            // the grid of the distribution is uniform in v = 1 - sqrt(1 - r) to resolve the tail
+            FP x = (1 - sqrt(1 - r)) * (numFractions - 1);
+            int j = std::min((int)x, numFractions - 2);
+            FP u = x - j;
+            const FP* row0 = &table[idx * numFractions + j];
+            const FP* row1 = row0 + numFractions;
+            return (1 - w) * ((1 - u) * row0[0] + u * row0[1]) + w * ((1 - u) * row1[0] + u * row1[1]);
+        }
+
+        int numChi, numFractions;
+        FP chiMin, chiMax, logChiMin, logChiStep;
+        std::vector<FP> photonLogRate, pairLogRate;
+        std::vector<FP> photonInverseDistribution, pairInverseDistribution;
+    };
+}
@@ -19,12 +19,18 @@ namespace pfc
             std::mt19937 generator(rd());
             int sizeArray = particles.size();
 
+            // a random subset of sizeArray - m particles is removed at once
+            std::vector<int> indices(sizeArray);
+            for (int i = 0; i < sizeArray; i++)
+                indices[i] = i;
+            std::vector<char> mask(sizeArray, 0);
             for (int i = 0; i < sizeArray - m; i++)
             {
-                std::uniform_int_distribution<int> dist(0, sizeArray - i - 1);
-                int deleteIdx = dist(generator);
-                particles.deleteParticle(deleteIdx);
+                std::uniform_int_distribution<int> dist(i, sizeArray - 1);
+                std::swap(indices[i], indices[dist(generator)]);
+                mask[indices[i]] = 1;
             }
+            particles.removeIf(mask);
             FP newCoeff = static_cast<FP>(sizeArray) / (static_cast<FP>(m));
             for (int idx = 0; idx < particles.size(); idx++)
             {
@@ -53,7 +59,7 @@ namespace pfc
                     FP randNumber = dist(generator);
                     if (randNumber > particles[idx].getWeight() / threshold)
                     {
-                        particles.deleteParticle(idx);
+                        particles.markRemoved(idx);
                     }
                     else
                     {
@@ -61,6 +67,7 @@ namespace pfc
                     }
                 }
             }
+            particles.compact();
         }
 
         static void numberConservative(ParticleArray& particles, int m)
@@ -96,7 +103,7 @@ namespace pfc
                 }
                 if (ki == 0)
                 {
-                    particles.deleteParticle(idx);
+                    particles.markRemoved(idx);
                 }
                 else
                 {
@@ -104,6 +111,7 @@ namespace pfc
                     particles[idx].setWeight(newCoeff * weightSum);
                 }
             }
+            particles.compact();
         }
 
         static void energyConservative(ParticleArray& particles, int m)
@@ -145,7 +153,7 @@ namespace pfc
                 }
                 if (ki == 0)
                 {
-                    particles.deleteParticle(idx);
+                    particles.markRemoved(idx);
                 }
                 else
                 {
@@ -153,6 +161,7 @@ namespace pfc
                     particles[idx].setWeight(newCoeff * energySum / energys[idx]);
                 }
             }
+            particles.compact();
         }
     };
 }
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "TestingUtility.h"
+
+#include "ParticleArray.h"
+#include "CurrentDeposition.h"
+#include "TiledParticleArray.h"
+
+template <class ParticleArrayType>
+class CurrentDepositionTest : public ParticleArrayFixture<ParticleArrayType> {
+public:
+    typedef ParticleArrayType ParticleArray;
+
+    virtual void SetUp(const ::benchmark::State& st)
+    {
+        ParticleArrayFixture<ParticleArray>::SetUp(st);
+        // particles of the fixture are in [-10, 10)
+        Int3 numCells(64, 64, 64);
+        FP3 minCoords(-10, -10, -10);
+        FP3 steps(20.0 / numCells.x, 20.0 / numCells.y, 20.0 / numCells.z);
+        grid = new YeeGrid(numCells, minCoords, steps, numCells);
+        dt = 0.5 * steps.x / Constants<FP>::lightVelocity();
+
+        ParticleArray& particles = *this->particles;
+        oldPositions.resize(particles.size());
+        for (int i = 0; i < particles.size(); i++)
+            oldPositions[i] = particles[i].getPosition() - dt * particles[i].getVelocity();
+    }
+
+    virtual void TearDown(const ::benchmark::State& st)
+    {
+        delete grid;
+        oldPositions.clear();
+        ParticleArrayFixture<ParticleArray>::TearDown(st);
+    }
+
+    YeeGrid * grid;
+    std::vector<FP3> oldPositions;
+    FP dt;
+};
+
+static void CustomArguments(benchmark::internal::Benchmark* b) {
+    b->Args({ 1000000, 10 });
+    b->Iterations(1);
+}
+
+using currentDepositionSoA = CurrentDepositionTest<ParticleArray3d>;
+BENCHMARK_DEFINE_F(currentDepositionSoA, CIC)(benchmark::State& state) {
+    CurrentDeposition<YeeGrid> deposition(grid, CurrentDeposition_CIC);
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++) {
+            grid->zeroizeJ();
+            deposition(particles);
+        }
+    }
+}
+BENCHMARK_REGISTER_F(currentDepositionSoA, CIC)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+BENCHMARK_DEFINE_F(currentDepositionSoA, TSC)(benchmark::State& state) {
+    CurrentDeposition<YeeGrid> deposition(grid, CurrentDeposition_TSC);
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++) {
+            grid->zeroizeJ();
+            deposition(particles);
+        }
+    }
+}
+BENCHMARK_REGISTER_F(currentDepositionSoA, TSC)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+BENCHMARK_DEFINE_F(currentDepositionSoA, Esirkepov)(benchmark::State& state) {
+    CurrentDeposition<YeeGrid> deposition(grid, CurrentDeposition_Esirkepov);
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++) {
+            grid->zeroizeJ();
+            deposition(particles, oldPositions, dt);
+        }
+    }
+}
+BENCHMARK_REGISTER_F(currentDepositionSoA, Esirkepov)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+// particles go forth and back by dt * v over a step, tiles are processed as tasks
+BENCHMARK_DEFINE_F(currentDepositionSoA, TiledEsirkepov)(benchmark::State& state) {
+    TiledParticleArray<Three> tiles(Electron, grid);
+    for (int i = 0; i < particles->size(); i++)
+        tiles.pushBack(Particle3d((*particles)[i]));
+    CurrentDeposition<YeeGrid> deposition(grid, CurrentDeposition_Esirkepov);
+    FP shift = dt;
+    auto push = [&shift](TiledParticleArray<Three>::TileType& tile) {
+        for (int i = 0; i < tile.size(); i++)
+            tile[i].setPosition(tile[i].getPosition() + shift * tile[i].getVelocity());
+    };
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++) {
+            grid->zeroizeJ();
+            deposition(&tiles, push, dt);
+            shift = -shift;
+        }
+    }
+}
+BENCHMARK_REGISTER_F(currentDepositionSoA, TiledEsirkepov)->Apply(CustomArguments)->Unit(benchmark::kSecond);
@@ -0,0 +1,73 @@
+#include "TestingUtility.h"
+
+#include "Grid.h"
+
+#include <vector>
+
+class GatherTest : public BaseFixture {
+public:
+    virtual void SetUp(const ::benchmark::State& st)
+    {
+        BaseFixture::SetUp(st);
+        Int3 numCells(128, 128, 128);
+        FP3 minCoords(-10, -10, -10), maxCoords(10, 10, 10);
+        FP3 steps = (maxCoords - minCoords) / FP3(numCells.x, numCells.y, numCells.z);
+        grid = new YeeGrid(numCells, minCoords, steps, numCells);
+        for (int i = 0; i < grid->numCells.x; i++)
+            for (int j = 0; j < grid->numCells.y; j++)
+                for (int k = 0; k < grid->numCells.z; k++) {
+                    grid->Ex(i, j, k) = urand(-1, 1);
+                    grid->Ey(i, j, k) = urand(-1, 1);
+                    grid->Ez(i, j, k) = urand(-1, 1);
+                    grid->Bx(i, j, k) = urand(-1, 1);
+                    grid->By(i, j, k) = urand(-1, 1);
+                    grid->Bz(i, j, k) = urand(-1, 1);
+                }
+        points.resize(st.range_x());
+        for (size_t idx = 0; idx < points.size(); idx++)
+            points[idx] = urandFP3(minCoords, maxCoords);
+        e.resize(points.size());
+        b.resize(points.size());
+    }
+
+    virtual void TearDown(const ::benchmark::State& st)
+    {
+        delete grid;
+        points.clear();
+        e.clear();
+        b.clear();
+    }
+
+    void gather()
+    {
+        const int n = (int)points.size();
+        OMP_FOR()
+        for (int idx = 0; idx < n; idx++)
+            grid->getFields(points[idx], e[idx], b[idx]);
+    }
+
+    YeeGrid * grid;
+    std::vector<FP3> points, e, b;
+};
+
+static void CustomArguments(benchmark::internal::Benchmark* b) {
+    b->Args({ 1000000, 10 });
+    b->Iterations(1);
+}
+
+BENCHMARK_DEFINE_F(GatherTest, separateArrays)(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++)
+            gather();
+    }
+}
+BENCHMARK_REGISTER_F(GatherTest, separateArrays)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+BENCHMARK_DEFINE_F(GatherTest, interleaved)(benchmark::State& state) {
+    grid->setLayout(ScalarFieldLayout_Interleaved);
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++)
+            gather();
+    }
+}
+BENCHMARK_REGISTER_F(GatherTest, interleaved)->Apply(CustomArguments)->Unit(benchmark::kSecond);
@@ -2,6 +2,7 @@
 
 #include "ParticleArray.h"
 #include "Pusher.h"
+#include "Interpolator.h"
 
 #include <chrono>
 
@@ -29,3 +30,113 @@ BENCHMARK_DEFINE_F(particleArraySoA, pusher)(benchmark::State& state) {
     }
 }
 BENCHMARK_REGISTER_F(particleArraySoA, pusher)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+// the loop over proxies of particles that the pusher of an SoA array replaces
+BENCHMARK_DEFINE_F(particleArraySoA, proxyPusher)(benchmark::State& state) {
+    BorisPusher pusher;
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++) {
+            OMP_FOR()
+            for (int i = 0; i < particles->size(); i++) {
+                ParticleProxy3d particle = (*particles)[i];
+                pusher(&particle, fields[i], dt);
+            }
+        }
+    }
+}
+BENCHMARK_REGISTER_F(particleArraySoA, proxyPusher)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+BENCHMARK_DEFINE_F(particleArraySoA, vayPusher)(benchmark::State& state) {
+    VayPusher pusher;
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++)
+            pusher(particles, fields, dt);
+    }
+}
+BENCHMARK_REGISTER_F(particleArraySoA, vayPusher)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+BENCHMARK_DEFINE_F(particleArraySoA, higueraCaryPusher)(benchmark::State& state) {
+    HigueraCaryPusher pusher;
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++)
+            pusher(particles, fields, dt);
+    }
+}
+BENCHMARK_REGISTER_F(particleArraySoA, higueraCaryPusher)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+// the Boris pusher and the radiation reaction as two passes over the particles and the fields
+BENCHMARK_DEFINE_F(particleArraySoA, radiationReactionTwoPasses)(benchmark::State& state) {
+    BorisPusher pusher;
+    RadiationReaction radiationReaction;
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++) {
+            pusher(particles, fields, dt);
+            radiationReaction(particles, fields, dt);
+        }
+    }
+}
+BENCHMARK_REGISTER_F(particleArraySoA, radiationReactionTwoPasses)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+BENCHMARK_DEFINE_F(particleArraySoA, radiationReactionFused)(benchmark::State& state) {
+    BorisPusherWithRadiationReaction pusher;
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++)
+            pusher(particles, fields, dt);
+    }
+}
+BENCHMARK_REGISTER_F(particleArraySoA, radiationReactionFused)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+template <class ParticleArrayType>
+class PusherGridTest : public PusherTest<ParticleArrayType> {
+public:
+    virtual void SetUp(const ::benchmark::State& st)
+    {
+        PusherTest<ParticleArrayType>::SetUp(st);
+        // particles of the fixture are in [-10, 10)
+        Int3 numCells(64, 64, 64);
+        FP3 steps(20.0 / numCells.x, 20.0 / numCells.y, 20.0 / numCells.z);
+        grid = new YeeGrid(numCells, FP3(-10, -10, -10), steps, numCells);
+    }
+
+    virtual void TearDown(const ::benchmark::State& st)
+    {
+        delete grid;
+        PusherTest<ParticleArrayType>::TearDown(st);
+    }
+
+    YeeGrid * grid;
+};
+
+using particleArraySoAGrid = PusherGridTest<ParticleArray3d>;
+BENCHMARK_DEFINE_F(particleArraySoAGrid, pusherWithInterpolation)(benchmark::State& state) {
+    BorisPusher pusher;
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++) {
+            for (int i = 0; i < particles->size(); i++) {
+                auto particle = (*particles)[i];
+                grid->getFields(particle.getPosition(), fields[i].E, fields[i].B);
+            }
+            pusher(particles, fields, dt);
+        }
+    }
+}
+BENCHMARK_REGISTER_F(particleArraySoAGrid, pusherWithInterpolation)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+BENCHMARK_DEFINE_F(particleArraySoAGrid, fusedPusher)(benchmark::State& state) {
+    BorisPusher pusher;
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++)
+            pusher(particles, grid, dt);
+    }
+}
+BENCHMARK_REGISTER_F(particleArraySoAGrid, fusedPusher)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+BENCHMARK_DEFINE_F(particleArraySoAGrid, fusedPusherCompileTimeInterpolation)(benchmark::State& state) {
+    BorisPusher pusher;
+    Interpolator<Interpolation_CIC, YeeGridType> interpolator(grid);
+    while (state.KeepRunning()) {
+        for (size_t iter = 0; iter < state.range_y(); iter++)
+            pusher(particles, &interpolator, dt);
+    }
+}
+BENCHMARK_REGISTER_F(particleArraySoAGrid, fusedPusherCompileTimeInterpolation)->Apply(CustomArguments)->Unit(benchmark::kSecond);
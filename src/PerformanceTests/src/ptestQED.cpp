@@ -0,0 +1,63 @@
+#include "TestingUtility.h"
+
+#include "QED_AEG.h"
+
+#include <vector>
+
+class PhotonGeneratorTest : public BaseFixture {
+public:
+    virtual void SetUp(const ::benchmark::State& st)
+    {
+        BaseFixture::SetUp(st);
+        FP preFactor = sqr(Constants<FP>::electronCharge()) * Constants<FP>::electronMass()
+            * Constants<FP>::lightVelocity() / sqr(Constants<FP>::planck());
+        gamma = 1000;
+        chi.resize(st.range_x());
+        dt.resize(st.range_x());
+        SynchrotronTables tables;
+        for (size_t idx = 0; idx < chi.size(); idx++) {
+            chi[idx] = exp(urand(log(0.01), log(100.0)));
+            // an emission in about every tenth call
+            dt[idx] = (FP)0.1 * gamma / (preFactor * tables.photonRate(chi[idx]));
+        }
+    }
+
+    virtual void TearDown(const ::benchmark::State& st)
+    {
+        chi.clear();
+        dt.clear();
+    }
+
+    void run(ScalarQED_AEG_only_electron_Yee& qed, benchmark::State& state)
+    {
+        FP sum = 0;
+        while (state.KeepRunning()) {
+            for (size_t iter = 0; iter < state.range_y(); iter++)
+                for (size_t idx = 0; idx < chi.size(); idx++)
+                    sum += qed.Photon_MGenerator(1, chi[idx], gamma, dt[idx]);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+
+    FP gamma;
+    std::vector<FP> chi, dt;
+};
+
+static void CustomArguments(benchmark::internal::Benchmark* b) {
+    b->Args({ 1000000, 10 });
+    b->Iterations(1);
+}
+
+BENCHMARK_DEFINE_F(PhotonGeneratorTest, rejection)(benchmark::State& state) {
+    ScalarQED_AEG_only_electron_Yee qed;
+    // the used chi are out of the tables, so Photon_probability is sampled by rejection
+    qed.setTablesResolution(3, 2, 1e-6, 1e-5);
+    run(qed, state);
+}
+BENCHMARK_REGISTER_F(PhotonGeneratorTest, rejection)->Apply(CustomArguments)->Unit(benchmark::kSecond);
+
+BENCHMARK_DEFINE_F(PhotonGeneratorTest, tables)(benchmark::State& state) {
+    ScalarQED_AEG_only_electron_Yee qed;
+    run(qed, state);
+}
+BENCHMARK_REGISTER_F(PhotonGeneratorTest, tables)->Apply(CustomArguments)->Unit(benchmark::kSecond);
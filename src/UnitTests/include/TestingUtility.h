@@ -118,7 +118,8 @@ public:
 
         ParticleInfo::typesVector = { {constants::electronMass, constants::electronCharge},
                                     {constants::electronMass, -constants::electronCharge},
-                                    {constants::protonMass, -constants::electronCharge} };
+                                    {constants::protonMass, -constants::electronCharge},
+                                    {constants::electronMass, 0.0} };
         ParticleInfo::types = &ParticleInfo::typesVector[0];
         ParticleInfo::numTypes = sizeParticleTypes;
     }
@@ -311,6 +312,24 @@ protected:
         return urandFP3(minCoords, maxCoords);
     }
 
+    // fills E, B and J of the grid with random values in [-1, 1]
+    void fillRandomFields() {
+        for (int i = 0; i < grid->numCells.x; i++)
+            for (int j = 0; j < grid->numCells.y; j++)
+                for (int k = 0; k < grid->numCells.z; k++)
+                {
+                    grid->Ex(i, j, k) = urand(-1, 1);
+                    grid->Ey(i, j, k) = urand(-1, 1);
+                    grid->Ez(i, j, k) = urand(-1, 1);
+                    grid->Bx(i, j, k) = urand(-1, 1);
+                    grid->By(i, j, k) = urand(-1, 1);
+                    grid->Bz(i, j, k) = urand(-1, 1);
+                    grid->Jx(i, j, k) = urand(-1, 1);
+                    grid->Jy(i, j, k) = urand(-1, 1);
+                    grid->Jz(i, j, k) = urand(-1, 1);
+                }
+    }
+
     ~BaseGridFixture()
     {
         delete(grid);
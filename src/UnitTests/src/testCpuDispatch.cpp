@@ -0,0 +1,147 @@
+#include "TestingUtility.h"
+
+#include "CpuDispatch.h"
+#include "CurrentDeposition.h"
+#include "Fdtd.h"
+#include "Pusher.h"
+
+using namespace pfc;
+
+
+class CpuDispatchTest : public BaseParticleFixture<Particle3d> {
+public:
+    CpuIsa isa;
+
+    virtual void SetUp() {
+        BaseParticleFixture<Particle3d>::SetUp();
+        isa = getCpuIsa();
+    }
+
+    virtual void TearDown() {
+        setCpuIsa(isa);
+    }
+
+    void randomize(ScalarField<FP>& field) {
+        for (int i = 0; i < field.getSize().x; i++)
+            for (int j = 0; j < field.getSize().y; j++)
+                for (int k = 0; k < field.getSize().z; k++)
+                    field(i, j, k) = urand(-1, 1);
+    }
+};
+
+TEST_F(CpuDispatchTest, UnsupportedIsaIsReplaced) {
+    ASSERT_LE(setCpuIsa(CpuIsa_AVX512), detectCpuIsa());
+    ASSERT_EQ(CpuIsa_Generic, setCpuIsa(CpuIsa_Generic));
+    ASSERT_EQ(CpuIsa_Generic, getCpuIsa());
+}
+
+TEST_F(CpuDispatchTest, PusherGivesSameParticlesForAllIsas) {
+    ParticleArray3d expectedParticles;
+    std::vector<ValueField> fields;
+    for (int i = 0; i < 1003; i++) {
+        expectedParticles.pushBack(randomParticle(Electron));
+        fields.push_back(ValueField(urandFP3(FP3(-1, -1, -1), FP3(1, 1, 1)),
+            urandFP3(FP3(-1, -1, -1), FP3(1, 1, 1))));
+    }
+    ParticleArray3d initialParticles = expectedParticles;
+    BorisPusher pusher;
+    FP timeStep = 0.01;
+    setCpuIsa(CpuIsa_Generic);
+    pusher(&expectedParticles, fields, timeStep);
+
+    for (int i = CpuIsa_AVX2; i <= detectCpuIsa(); i++) {
+        ParticleArray3d particles = initialParticles;
+        setCpuIsa((CpuIsa)i);
+        pusher(&particles, fields, timeStep);
+        for (int idx = 0; idx < particles.size(); idx++) {
+            ASSERT_NEAR_FP3(expectedParticles[idx].getP(), particles[idx].getP());
+            ASSERT_NEAR_FP3(expectedParticles[idx].getPosition(), particles[idx].getPosition());
+        }
+    }
+}
+
+TEST_F(CpuDispatchTest, FdtdGivesSameFieldsForAllIsas) {
+    // 3d, 2d and 1d grids go through different updates
+    const Int3 gridSizes[] = { Int3(12, 10, 21), Int3(12, 10, 1), Int3(21, 1, 1) };
+    for (int g = 0; g < 3; g++) {
+        Int3 numCells = gridSizes[g];
+        FP3 steps(0.1, 0.12, 0.08);
+        YeeGrid grid(numCells, FP3(0, 0, 0), steps, numCells);
+        ScalarField<FP>* fields[] = { &grid.Ex, &grid.Ey, &grid.Ez, &grid.Bx, &grid.By, &grid.Bz,
+            &grid.Jx, &grid.Jy, &grid.Jz };
+        for (int f = 0; f < 9; f++)
+            randomize(*fields[f]);
+        FP timeStep = 0.5 * steps.z / constants::c;
+
+        YeeGrid expectedGrid(grid);
+        setCpuIsa(CpuIsa_Generic);
+        FDTD expectedFdtd(&expectedGrid, timeStep);
+        for (int step = 0; step < 3; step++)
+            expectedFdtd.updateFields();
+
+        for (int isa = CpuIsa_AVX2; isa <= detectCpuIsa(); isa++) {
+            YeeGrid isaGrid(grid);
+            setCpuIsa((CpuIsa)isa);
+            FDTD fdtd(&isaGrid, timeStep);
+            for (int step = 0; step < 3; step++)
+                fdtd.updateFields();
+            for (int i = 0; i < isaGrid.numCells.x; i++)
+                for (int j = 0; j < isaGrid.numCells.y; j++)
+                    for (int k = 0; k < isaGrid.numCells.z; k++) {
+                        ASSERT_NEAR_FP(expectedGrid.Ex(i, j, k), isaGrid.Ex(i, j, k));
+                        ASSERT_NEAR_FP(expectedGrid.Ey(i, j, k), isaGrid.Ey(i, j, k));
+                        ASSERT_NEAR_FP(expectedGrid.By(i, j, k), isaGrid.By(i, j, k));
+                        ASSERT_NEAR_FP(expectedGrid.Bz(i, j, k), isaGrid.Bz(i, j, k));
+                    }
+        }
+    }
+}
+
+TEST_F(CpuDispatchTest, GridBatchAndDepositionGiveSameValuesForAllIsas) {
+    Int3 numCells(12, 10, 8);
+    FP3 steps(0.1, 0.12, 0.08);
+    YeeGrid grid(numCells, FP3(0, 0, 0), steps, numCells);
+    ScalarField<FP>* fields[] = { &grid.Ex, &grid.Ey, &grid.Ez, &grid.Bx, &grid.By, &grid.Bz };
+    for (int f = 0; f < 6; f++)
+        randomize(*fields[f]);
+    grid.setInterpolationType(Interpolation_TSC);
+    ParticleArray3d particles;
+    const int n = 300;
+    std::vector<FP> x(n), y(n), z(n);
+    for (int i = 0; i < n; i++) {
+        particles.pushBack(randomParticle(grid.origin + steps * (FP)2, grid.origin + steps * (numCells - Int3(2, 2, 2)),
+            Electron));
+        x[i] = particles[i].getPosition().x;
+        y[i] = particles[i].getPosition().y;
+        z[i] = particles[i].getPosition().z;
+    }
+
+    std::vector<FP> expected[6], values[6];
+    YeeGrid expectedJ(grid);
+    setCpuIsa(CpuIsa_Generic);
+    for (int c = 0; c < 6; c++)
+        expected[c].resize(n);
+    grid.getFieldsBatch(x.data(), y.data(), z.data(), n, expected[0].data(), expected[1].data(),
+        expected[2].data(), expected[3].data(), expected[4].data(), expected[5].data());
+    CurrentDeposition<YeeGrid>(&expectedJ, CurrentDeposition_TSC)(&particles);
+
+    for (int isa = CpuIsa_AVX2; isa <= detectCpuIsa(); isa++) {
+        setCpuIsa((CpuIsa)isa);
+        for (int c = 0; c < 6; c++)
+            values[c].assign(n, 0);
+        grid.getFieldsBatch(x.data(), y.data(), z.data(), n, values[0].data(), values[1].data(),
+            values[2].data(), values[3].data(), values[4].data(), values[5].data());
+        for (int c = 0; c < 6; c++)
+            for (int i = 0; i < n; i++)
+                ASSERT_NEAR_FP(expected[c][i], values[c][i]);
+
+        YeeGrid isaJ(grid);
+        CurrentDeposition<YeeGrid>(&isaJ, CurrentDeposition_TSC)(&particles);
+        for (int i = 0; i < numCells.x; i++)
+            for (int j = 0; j < numCells.y; j++)
+                for (int k = 0; k < numCells.z; k++) {
+                    ASSERT_NEAR_FP(expectedJ.Jx(i, j, k), isaJ.Jx(i, j, k));
+                    ASSERT_NEAR_FP(expectedJ.Jz(i, j, k), isaJ.Jz(i, j, k));
+                }
+    }
+}
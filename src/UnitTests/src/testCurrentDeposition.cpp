@@ -0,0 +1,312 @@
+#include "TestingUtility.h"
+
+#include "CurrentDeposition.h"
+#include "Grid.h"
+#include "ParticleArray.h"
+#include "TiledParticleArray.h"
+
+template <class TGrid>
+class CurrentDepositionTest : public BaseParticleFixture<Particle3d> {
+public:
+    TGrid * grid;
+    FP3 minCoords, maxCoords, steps;
+    FP timeStep;
+    ParticleArray3d particles;
+    std::vector<FP3> oldPositions;
+protected:
+    virtual void SetUp() {
+        BaseParticleFixture<Particle3d>::SetUp();
+        maxAbsoluteError = (FP)1e-10;
+        maxRelativeError = (FP)1e-8;
+
+        Int3 gridSize(8, 6, 5);
+        minCoords = FP3(-0.4, 0.0, 0.1);
+        steps = FP3(0.1, 0.2, 0.15);
+        maxCoords = minCoords + steps * gridSize;
+        // particles pass less than a third of a cell per step
+        timeStep = (FP)0.3 * steps.x / Constants<FP>::lightVelocity();
+        grid = new TGrid(gridSize, minCoords, steps, gridSize);
+    }
+
+    // Place particles in the internal area leaving a cell near the borders
+    void createParticles(int numParticles) {
+        for (int i = 0; i < numParticles; i++) {
+            FP3 position = urandFP3(minCoords + steps, maxCoords - steps);
+            FP3 momentum = urandFP3(FP3(-1, -1, -1), FP3(1, 1, 1)) *
+                Constants<FP>::electronMass() * Constants<FP>::lightVelocity();
+            particles.pushBack(Particle3d(position, momentum, urand(1, 10), Electron));
+        }
+    }
+
+    // Move particles with their velocities, remembering the previous positions
+    void moveParticles() {
+        CurrentDeposition<TGrid>::savePositions(&particles, oldPositions);
+        for (int i = 0; i < particles.size(); i++)
+            particles[i].setPosition(oldPositions[i] + timeStep * particles[i].getVelocity());
+    }
+
+    FP3 getTotalCurrent() {
+        FP3 result;
+        for (int i = 0; i < grid->numCells.x; i++)
+            for (int j = 0; j < grid->numCells.y; j++)
+                for (int k = 0; k < grid->numCells.z; k++)
+                    result += FP3(grid->Jx(i, j, k), grid->Jy(i, j, k), grid->Jz(i, j, k));
+        return result * (steps.x * steps.y * steps.z);
+    }
+
+    // Charge density with the linear form factor at cell centers
+    FP getRho(const FP3 * positions, int i, int j, int k) {
+        FP result = 0;
+        FP3 node = grid->origin + (FP3(i, j, k) + FP3(0.5, 0.5, 0.5)) * steps;
+        for (int idx = 0; idx < particles.size(); idx++) {
+            FP3 distance = (positions[idx] - node) / steps;
+            FP w = 1;
+            for (int d = 0; d < 3; d++)
+                w *= std::max((FP)0, (FP)1 - fabs(distance[d]));
+            result += particles[idx].getCharge() * particles[idx].getWeight() * w;
+        }
+        return result / (steps.x * steps.y * steps.z);
+    }
+
+    ~CurrentDepositionTest()
+    {
+        delete(grid);
+    }
+};
+
+typedef ::testing::Types<YeeGrid, PSATDGrid> types;
+TYPED_TEST_CASE(CurrentDepositionTest, types);
+
+TYPED_TEST(CurrentDepositionTest, ZeroizeJ)
+{
+    this->createParticles(10);
+    CurrentDeposition<TypeParam> deposition(this->grid);
+    deposition(&this->particles);
+    this->grid->zeroizeJ();
+    ASSERT_EQ_FP3(FP3(0, 0, 0), this->getTotalCurrent());
+}
+
+TYPED_TEST(CurrentDepositionTest, CICDepositsTotalCurrent)
+{
+    this->createParticles(20);
+    FP3 expected;
+    for (int i = 0; i < this->particles.size(); i++)
+        expected += this->particles[i].getCharge() * this->particles[i].getWeight() * this->particles[i].getVelocity();
+
+    CurrentDeposition<TypeParam> deposition(this->grid, CurrentDeposition_CIC);
+    deposition(&this->particles);
+    ASSERT_NEAR_FP3(expected / Constants<FP>::lightVelocity(), this->getTotalCurrent() / Constants<FP>::lightVelocity());
+}
+
+TYPED_TEST(CurrentDepositionTest, TSCDepositsTotalCurrent)
+{
+    this->createParticles(20);
+    FP3 expected;
+    for (int i = 0; i < this->particles.size(); i++)
+        expected += this->particles[i].getCharge() * this->particles[i].getWeight() * this->particles[i].getVelocity();
+
+    CurrentDeposition<TypeParam> deposition(this->grid, CurrentDeposition_TSC);
+    deposition(&this->particles);
+    ASSERT_NEAR_FP3(expected / Constants<FP>::lightVelocity(), this->getTotalCurrent() / Constants<FP>::lightVelocity());
+}
+
+TYPED_TEST(CurrentDepositionTest, DepositionIsAdditive)
+{
+    this->createParticles(20);
+    CurrentDeposition<TypeParam> deposition(this->grid, CurrentDeposition_TSC);
+    deposition(&this->particles);
+    FP3 single = this->getTotalCurrent();
+    deposition(&this->particles);
+    ASSERT_NEAR_FP3((FP)2 * single / Constants<FP>::lightVelocity(), this->getTotalCurrent() / Constants<FP>::lightVelocity());
+}
+
+TYPED_TEST(CurrentDepositionTest, SmallerTeamDoesNotAddPreviousCurrent)
+{
+    this->createParticles(200);
+    CurrentDeposition<TypeParam> deposition(this->grid, CurrentDeposition_TSC);
+#ifdef __USE_OMP__
+    int maxThreads = omp_get_max_threads(), maxActiveLevels = omp_get_max_active_levels();
+    omp_set_num_threads(4);
+    omp_set_max_active_levels(1);
+#endif
+    deposition(&this->particles);
+    FP3 single = this->getTotalCurrent();
+    this->grid->zeroizeJ();
+    // the region nested in an active one has a team of one thread
+#pragma omp parallel num_threads(2)
+    {
+#pragma omp single
+        deposition(&this->particles);
+    }
+#ifdef __USE_OMP__
+    omp_set_num_threads(maxThreads);
+    omp_set_max_active_levels(maxActiveLevels);
+#endif
+    ASSERT_NEAR_FP3(single / Constants<FP>::lightVelocity(), this->getTotalCurrent() / Constants<FP>::lightVelocity());
+}
+
+TYPED_TEST(CurrentDepositionTest, PeriodicForSpectralGrids)
+{
+    if (TypeParam::gridType != GridTypes::PSATDGridType)
+        return;
+    FP3 position = this->minCoords + FP3(0.1, 0.5, 0.5) * this->steps;
+    FP3 momentum(Constants<FP>::electronMass() * Constants<FP>::lightVelocity(), 0, 0);
+    this->particles.pushBack(Particle3d(position, momentum, 1, Electron));
+    FP3 expected = this->particles[0].getCharge() * this->particles[0].getVelocity();
+
+    CurrentDeposition<TypeParam> deposition(this->grid, CurrentDeposition_TSC);
+    deposition(&this->particles);
+    ASSERT_NEAR_FP3(expected / Constants<FP>::lightVelocity(), this->getTotalCurrent() / Constants<FP>::lightVelocity());
+    ASSERT_NE(0, this->grid->Jx(this->grid->numCells.x - 1, 0, 0));
+}
+
+TYPED_TEST(CurrentDepositionTest, TiledDepositionGivesSameCurrent)
+{
+    Int3 gridSize(20, 13, 7);
+    TypeParam grid(gridSize, this->minCoords, this->steps, gridSize);
+    TypeParam tiledGrid(gridSize, this->minCoords, this->steps, gridSize);
+    TiledParticleArray<Three> tiles(Electron, &tiledGrid, Int3(6, 6, 6));
+    CurrentDepositionType type = TypeParam::ifFieldsSpatialStraggered ?
+        CurrentDeposition_Esirkepov : CurrentDeposition_TSC;
+    for (int i = 0; i < 300; i++) {
+        FP3 position = this->urandFP3(this->minCoords + this->steps,
+            this->minCoords + this->steps * (gridSize - Int3(1, 1, 1)));
+        FP3 momentum = this->urandFP3(FP3(-1, -1, -1), FP3(1, 1, 1)) *
+            Constants<FP>::electronMass() * Constants<FP>::lightVelocity();
+        Particle3d particle(position, momentum, this->urand(1, 10), Electron);
+        this->particles.pushBack(particle);
+        tiles.pushBack(particle);
+    }
+
+    this->moveParticles();
+    CurrentDeposition<TypeParam> deposition(&grid, type);
+    deposition(&this->particles, this->oldPositions, this->timeStep);
+
+    FP timeStep = this->timeStep;
+    CurrentDeposition<TypeParam> tiledDeposition(&tiledGrid, type);
+    tiledDeposition(&tiles, [timeStep](TiledParticleArray<Three>::TileType& tile) {
+        for (int i = 0; i < tile.size(); i++)
+            tile[i].setPosition(tile[i].getPosition() + timeStep * tile[i].getVelocity());
+    }, timeStep);
+
+    ASSERT_EQ(this->particles.size(), tiles.size());
+    FP scale = fabs(Constants<FP>::electronCharge()) * Constants<FP>::lightVelocity() /
+        (this->steps.x * this->steps.y * this->steps.z);
+    for (int i = 0; i < gridSize.x; i++)
+        for (int j = 0; j < gridSize.y; j++)
+            for (int k = 0; k < gridSize.z; k++) {
+                ASSERT_NEAR_FP(grid.Jx(i, j, k) / scale, tiledGrid.Jx(i, j, k) / scale);
+                ASSERT_NEAR_FP(grid.Jy(i, j, k) / scale, tiledGrid.Jy(i, j, k) / scale);
+                ASSERT_NEAR_FP(grid.Jz(i, j, k) / scale, tiledGrid.Jz(i, j, k) / scale);
+            }
+}
+
+TYPED_TEST(CurrentDepositionTest, BuffersOfTilesOfPhaseDoNotOverlap)
+{
+    if (TypeParam::gridType != GridTypes::PSATDGridType)
+        return;
+    // the numbers of cells are not multiples of the tile sizes, buffers wrap around the grid
+    Int3 gridSize(20, 13, 30);
+    TypeParam grid(gridSize, this->minCoords, this->steps, gridSize);
+    TiledParticleArray<Three> tiles(Electron, &grid, Int3(6, 6, 8));
+    CurrentDeposition<TypeParam> deposition(&grid);
+    std::vector<std::vector<int>> phases = deposition.getTilePhases(&tiles);
+
+    std::vector<int> numPhaseTiles(tiles.getNumTiles(), 0);
+    for (int phase = 0; phase < (int)phases.size(); phase++) {
+        std::vector<int> numBuffers(gridSize.volume(), 0);
+        for (int i = 0; i < (int)phases[phase].size(); i++) {
+            const int t = phases[phase][i];
+            numPhaseTiles[t]++;
+            Int3 begin, size;
+            deposition.getTileBuffer(&tiles, t, begin, size);
+            for (int x = begin.x; x < begin.x + size.x; x++)
+                for (int y = begin.y; y < begin.y + size.y; y++)
+                    for (int z = begin.z; z < begin.z + size.z; z++) {
+                        Int3 node((x + gridSize.x) % gridSize.x, (y + gridSize.y) % gridSize.y,
+                            (z + gridSize.z) % gridSize.z);
+                        int& n = numBuffers[(node.x * gridSize.y + node.y) * gridSize.z + node.z];
+                        ASSERT_EQ(0, n);
+                        n++;
+                    }
+        }
+    }
+    for (int t = 0; t < tiles.getNumTiles(); t++)
+        ASSERT_EQ(1, numPhaseTiles[t]);
+}
+
+TYPED_TEST(CurrentDepositionTest, TooSmallTilesThrow)
+{
+    TiledParticleArray<Three> tiles(Electron, this->grid, Int3(4, 4, 4));
+    CurrentDeposition<TypeParam> deposition(this->grid);
+    ASSERT_ANY_THROW(deposition(&tiles, [](TiledParticleArray<Three>::TileType&) {}, this->timeStep));
+}
+
+TYPED_TEST(CurrentDepositionTest, EsirkepovRequiresStraggeredGrid)
+{
+    if (TypeParam::ifFieldsSpatialStraggered)
+        ASSERT_NO_THROW(CurrentDeposition<TypeParam>(this->grid, CurrentDeposition_Esirkepov));
+    else
+        ASSERT_ANY_THROW(CurrentDeposition<TypeParam>(this->grid, CurrentDeposition_Esirkepov));
+}
+
+class EsirkepovDepositionTest : public CurrentDepositionTest<YeeGrid> {
+};
+
+TEST_F(EsirkepovDepositionTest, DepositsTotalCurrent)
+{
+    createParticles(20);
+    moveParticles();
+    FP3 expected;
+    for (int i = 0; i < particles.size(); i++)
+        expected += particles[i].getCharge() * particles[i].getWeight() *
+            (particles[i].getPosition() - oldPositions[i]) / timeStep;
+
+    CurrentDeposition<YeeGrid> deposition(grid, CurrentDeposition_Esirkepov);
+    deposition(&particles, oldPositions, timeStep);
+    ASSERT_NEAR_FP3(expected / Constants<FP>::lightVelocity(), getTotalCurrent() / Constants<FP>::lightVelocity());
+}
+
+TEST_F(EsirkepovDepositionTest, ConservesCharge)
+{
+    createParticles(20);
+    moveParticles();
+    std::vector<FP3> newPositions;
+    CurrentDeposition<YeeGrid>::savePositions(&particles, newPositions);
+
+    CurrentDeposition<YeeGrid> deposition(grid, CurrentDeposition_Esirkepov);
+    deposition(&particles, oldPositions, timeStep);
+
+    // the continuity equation in the cells that have both faces inside the grid
+    FP scale = fabs(Constants<FP>::electronCharge()) / (steps.x * steps.y * steps.z * timeStep);
+    for (int i = 0; i < grid->numCells.x - 1; i++)
+        for (int j = 0; j < grid->numCells.y - 1; j++)
+            for (int k = 0; k < grid->numCells.z - 1; k++) {
+                FP dRho = (getRho(newPositions.data(), i, j, k) - getRho(oldPositions.data(), i, j, k)) / timeStep;
+                FP divJ = (grid->Jx(i + 1, j, k) - grid->Jx(i, j, k)) / steps.x +
+                    (grid->Jy(i, j + 1, k) - grid->Jy(i, j, k)) / steps.y +
+                    (grid->Jz(i, j, k + 1) - grid->Jz(i, j, k)) / steps.z;
+                ASSERT_NEAR_FP(0, (dRho + divJ) / scale);
+            }
+}
+
+TEST_F(EsirkepovDepositionTest, BrickLayoutGivesSameCurrent)
+{
+    createParticles(20);
+    moveParticles();
+    CurrentDeposition<YeeGrid> deposition(grid, CurrentDeposition_Esirkepov);
+    deposition(&particles, oldPositions, timeStep);
+    YeeGrid expected(*grid);
+
+    grid->setLayout(ScalarFieldLayout_Bricks);
+    grid->zeroizeJ();
+    CurrentDeposition<YeeGrid> brickDeposition(grid, CurrentDeposition_Esirkepov);
+    brickDeposition(&particles, oldPositions, timeStep);
+    for (int i = 0; i < grid->numCells.x; i++)
+        for (int j = 0; j < grid->numCells.y; j++)
+            for (int k = 0; k < grid->numCells.z; k++) {
+                ASSERT_EQ(expected.Jx(i, j, k), grid->Jx(i, j, k));
+                ASSERT_EQ(expected.Jy(i, j, k), grid->Jy(i, j, k));
+                ASSERT_EQ(expected.Jz(i, j, k), grid->Jz(i, j, k));
+            }
+}
@@ -1,6 +1,7 @@
 #include "TestingUtility.h"
 
 #include "Ensemble.h"
+#include "Grid.h"
 
 #include "Particle.h"
 #include "ParticleArray.h"
@@ -88,3 +89,63 @@ TYPED_TEST(ParticleArrayTest, EnsembleAccess)
         EXPECT_TRUE(this->eqParticles_(proxyParticleFromArray, proxyParticle));
     }
 }
+
+TYPED_TEST(ParticleArrayTest, EnsembleAddParticles)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+    typedef typename ParticleArrayTest<TypeParam>::Particle ParticleType;
+
+    Ensemble<ParticleArray> particles, expected;
+    for (int i = 0; i < 5; i++) {
+        ParticleType particle = this->randomParticle(Positron);
+        particles.addParticle(particle);
+        expected.addParticle(particle);
+    }
+    std::vector<std::vector<ParticleType>> blocks(13);
+    for (int b = 0; b < (int)blocks.size(); b++)
+        for (int i = 0; i < b % 4; i++) {
+            ParticleType particle = this->randomParticle((i + b) % 2 ? Electron : Positron);
+            blocks[b].push_back(particle);
+            expected.addParticle(particle);
+        }
+    particles.addParticles(blocks);
+    ASSERT_EQ(expected.size(), particles.size());
+    for (int t = 0; t < sizeParticleTypes; t++)
+        ASSERT_TRUE(this->eqParticleArrays(expected[t], particles[t]));
+}
+
+TYPED_TEST(ParticleArrayTest, EnsembleCompact)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+
+    Ensemble<ParticleArray> particles;
+    for (int i = 0; i < 10; i++) {
+        particles.addParticle(this->randomParticle(Electron));
+        particles.addParticle(this->randomParticle(Positron));
+    }
+    particles[Electron].markRemoved(3);
+    particles[Positron].markRemoved(0);
+    particles[Positron].markRemoved(9);
+    particles.compact();
+    ASSERT_EQ(9, particles[Electron].size());
+    ASSERT_EQ(8, particles[Positron].size());
+}
+
+class EnsembleSoATest : public ParticleArrayTest<ParticleArray3d> {
+};
+
+TEST_F(EnsembleSoATest, SortByCellPeriodically)
+{
+    YeeGrid grid(Int3(2, 2, 2), FP3(0, 0, 0), FP3(1, 1, 1), Int3(2, 2, 2));
+    Ensemble3d particles;
+    for (int i = 0; i < 20; i++)
+        particles.addParticle(randomParticle(grid.origin, grid.origin + grid.steps * grid.numCells,
+            (ParticleTypes)(i % sizeParticleTypes)));
+    particles.setSortPeriod(2);
+    particles.sortByCellPeriodically(&grid);
+    for (int t = 0; t < sizeParticleTypes; t++)
+        ASSERT_TRUE(particles[t].getCellOffsets().empty());
+    particles.sortByCellPeriodically(&grid);
+    for (int t = 0; t < sizeParticleTypes; t++)
+        ASSERT_EQ(particles[t].size(), particles[t].getCellOffsets().back());
+}
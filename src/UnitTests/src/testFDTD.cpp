@@ -35,6 +35,9 @@ public:
 
     FP3 eTest(FP x, FP y, FP z, FP t);
     FP3 bTest(FP x, FP y, FP z, FP t);
+
+    // FDTD on a copy of the grid with the given layout gives the same fields
+    void checkLayoutGivesSameFields(ScalarFieldLayout layout);
 };
 
 template<>
@@ -167,4 +170,63 @@ TYPED_TEST(GridFDTDTest, FDTD_periodical)
                 actualB.z = this->grid->Bz(i, j, k);
                 ASSERT_NEAR_FP3(expectedB, actualB);
             }
-}
\ No newline at end of file
+}
+
+template <class axis>
+void GridFDTDTest<axis>::checkLayoutGivesSameFields(ScalarFieldLayout layout)
+{
+    for (int i = 0; i < this->grid->numCells.x; ++i)
+        for (int j = 0; j < this->grid->numCells.y; ++j)
+            for (int k = 0; k < this->grid->numCells.z; ++k)
+            {
+                FP3 coords = this->grid->ExPosition(i, j, k);
+                this->grid->Ex(i, j, k) = this->eTest(coords.x, coords.y, coords.z, 0).x;
+                coords = this->grid->EyPosition(i, j, k);
+                this->grid->Ey(i, j, k) = this->eTest(coords.x, coords.y, coords.z, 0).y;
+                coords = this->grid->EzPosition(i, j, k);
+                this->grid->Ez(i, j, k) = this->eTest(coords.x, coords.y, coords.z, 0).z;
+                coords = this->grid->BxPosition(i, j, k);
+                this->grid->Bx(i, j, k) = this->bTest(coords.x, coords.y, coords.z, 0).x;
+                coords = this->grid->ByPosition(i, j, k);
+                this->grid->By(i, j, k) = this->bTest(coords.x, coords.y, coords.z, 0).y;
+                coords = this->grid->BzPosition(i, j, k);
+                this->grid->Bz(i, j, k) = this->bTest(coords.x, coords.y, coords.z, 0).z;
+            }
+    YeeGrid layoutGrid(*this->grid);
+    layoutGrid.setLayout(layout);
+    FDTD layoutFdtd(&layoutGrid, fdtd->dt);
+    if (layout != ScalarFieldLayout_Bricks)
+        layoutFdtd.placeGridMemory();
+
+    const int numSteps = 8;
+    for (int step = 0; step < numSteps; ++step)
+    {
+        this->fdtd->updateFields();
+        layoutFdtd.updateFields();
+    }
+
+    for (int i = 0; i < this->grid->numCells.x; ++i)
+        for (int j = 0; j < this->grid->numCells.y; ++j)
+            for (int k = 0; k < this->grid->numCells.z; ++k)
+            {
+                ASSERT_EQ_FP3(FP3(this->grid->Ex(i, j, k), this->grid->Ey(i, j, k), this->grid->Ez(i, j, k)),
+                    FP3(layoutGrid.Ex(i, j, k), layoutGrid.Ey(i, j, k), layoutGrid.Ez(i, j, k)));
+                ASSERT_EQ_FP3(FP3(this->grid->Bx(i, j, k), this->grid->By(i, j, k), this->grid->Bz(i, j, k)),
+                    FP3(layoutGrid.Bx(i, j, k), layoutGrid.By(i, j, k), layoutGrid.Bz(i, j, k)));
+            }
+}
+
+TYPED_TEST(GridFDTDTest, BrickLayoutGivesSameFields)
+{
+    this->checkLayoutGivesSameFields(ScalarFieldLayout_Bricks);
+}
+
+TYPED_TEST(GridFDTDTest, InterleavedLayoutGivesSameFields)
+{
+    this->checkLayoutGivesSameFields(ScalarFieldLayout_Interleaved);
+}
+
+TYPED_TEST(GridFDTDTest, PaddedLayoutGivesSameFields)
+{
+    this->checkLayoutGivesSameFields(ScalarFieldLayout_Padded);
+}
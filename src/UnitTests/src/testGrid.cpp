@@ -1,5 +1,7 @@
 #include "TestingUtility.h"
 
+#include "Interpolator.h"
+
 template <class gridType>
 class GridTest : public BaseGridFixture<gridType> {
 };
@@ -108,3 +110,151 @@ TYPED_TEST(GridTest, InterpolateJ)
     }
 }
 
+
+TYPED_TEST(GridTest, GetFieldsBatchMatchesGetFields)
+{
+    this->maxAbsoluteError = (FP)1e-10;
+    this->maxRelativeError = (FP)1e-10;
+    auto grid = this->grid;
+    this->fillRandomFields();
+    const int n = 100;
+    std::vector<FP> x(n), y(n), z(n);
+    for (int idx = 0; idx < n; ++idx)
+    {
+        FP3 coords = this->internalPoint();
+        x[idx] = coords.x;
+        y[idx] = coords.y;
+        z[idx] = coords.z;
+    }
+
+    InterpolationType types[] = { Interpolation_CIC, Interpolation_TSC,
+        Interpolation_SecondOrder, Interpolation_FourthOrder, Interpolation_PCS };
+    for (int t = 0; t < 5; t++)
+    {
+        grid->setInterpolationType(types[t]);
+        std::vector<FP> ex(n), ey(n), ez(n), bx(n), by(n), bz(n);
+        grid->getFieldsBatch(x.data(), y.data(), z.data(), n,
+            ex.data(), ey.data(), ez.data(), bx.data(), by.data(), bz.data());
+        for (int idx = 0; idx < n; ++idx)
+        {
+            FP3 expectedE, expectedB;
+            grid->getFields(FP3(x[idx], y[idx], z[idx]), expectedE, expectedB);
+            ASSERT_NEAR_FP3(expectedE, FP3(ex[idx], ey[idx], ez[idx]));
+            ASSERT_NEAR_FP3(expectedB, FP3(bx[idx], by[idx], bz[idx]));
+        }
+    }
+}
+
+template <InterpolationType interpolationType, class gridType>
+void checkInterpolator(gridType* grid, const std::vector<FP3>& points, FP eps)
+{
+    Interpolator<interpolationType, gridType::gridType> interpolator(grid);
+    grid->setInterpolationType(interpolationType);
+    for (size_t idx = 0; idx < points.size(); ++idx)
+    {
+        FP3 expectedE, expectedB, e, b;
+        grid->getFields(points[idx], expectedE, expectedB);
+        interpolator.getFields(points[idx], e, b);
+        ASSERT_LE(dist(expectedE, e), eps);
+        ASSERT_LE(dist(expectedB, b), eps);
+        ASSERT_LE(dist(expectedE, interpolator.getE(points[idx])), eps);
+        ASSERT_LE(dist(expectedB, interpolator.getB(points[idx])), eps);
+    }
+}
+
+TYPED_TEST(GridTest, InterpolatorMatchesRuntimeInterpolationType)
+{
+    auto grid = this->grid;
+    this->fillRandomFields();
+    std::vector<FP3> points(100);
+    for (size_t idx = 0; idx < points.size(); ++idx)
+        points[idx] = this->internalPoint();
+
+    const FP eps = (FP)1e-12;
+    checkInterpolator<Interpolation_CIC>(grid, points, eps);
+    checkInterpolator<Interpolation_TSC>(grid, points, eps);
+    checkInterpolator<Interpolation_SecondOrder>(grid, points, eps);
+    checkInterpolator<Interpolation_FourthOrder>(grid, points, eps);
+    checkInterpolator<Interpolation_PCS>(grid, points, eps);
+}
+
+TYPED_TEST(GridTest, BrickLayoutKeepsFields)
+{
+    auto grid = this->grid;
+    this->fillRandomFields();
+    std::vector<FP3> points(100), expectedE(100), expectedB(100);
+    for (size_t idx = 0; idx < points.size(); ++idx)
+    {
+        points[idx] = this->internalPoint();
+        grid->getFields(points[idx], expectedE[idx], expectedB[idx]);
+    }
+    FP3 expectedJ = grid->getJ(points[0]);
+
+    grid->setLayout(ScalarFieldLayout_Bricks);
+    for (size_t idx = 0; idx < points.size(); ++idx)
+    {
+        FP3 e, b;
+        grid->getFields(points[idx], e, b);
+        ASSERT_EQ_FP3(expectedE[idx], e);
+        ASSERT_EQ_FP3(expectedB[idx], b);
+    }
+    ASSERT_EQ_FP3(expectedJ, grid->getJ(points[0]));
+}
+
+TYPED_TEST(GridTest, InterleavedLayoutKeepsFields)
+{
+    auto grid = this->grid;
+    this->fillRandomFields();
+    std::vector<FP3> points(100), expectedE(100), expectedB(100);
+    for (size_t idx = 0; idx < points.size(); ++idx)
+    {
+        points[idx] = this->internalPoint();
+        grid->getFields(points[idx], expectedE[idx], expectedB[idx]);
+    }
+
+    grid->setLayout(ScalarFieldLayout_Interleaved);
+    ASSERT_EQ(ScalarFieldLayout_Interleaved, grid->getLayout());
+    TypeParam copy(*grid);
+    grid->Ex.zeroize();
+    for (size_t idx = 0; idx < points.size(); ++idx)
+    {
+        FP3 e, b;
+        copy.getFields(points[idx], e, b);
+        ASSERT_EQ_FP3(expectedE[idx], e);
+        ASSERT_EQ_FP3(expectedB[idx], b);
+        grid->getFields(points[idx], e, b);
+        ASSERT_EQ(0, e.x);
+        ASSERT_EQ_FP3(expectedB[idx], b);
+    }
+
+    copy.setLayout(ScalarFieldLayout_RowMajor);
+    ASSERT_EQ(ScalarFieldLayout_RowMajor, copy.getLayout());
+    for (size_t idx = 0; idx < points.size(); ++idx)
+    {
+        FP3 e, b;
+        copy.getFields(points[idx], e, b);
+        ASSERT_EQ_FP3(expectedE[idx], e);
+        ASSERT_EQ_FP3(expectedB[idx], b);
+    }
+}
+
+TYPED_TEST(GridTest, PlaceRowsKeepsFields)
+{
+    auto grid = this->grid;
+    this->fillRandomFields();
+    TypeParam expected(*grid);
+    ScalarFieldLayout layouts[] = { ScalarFieldLayout_RowMajor, ScalarFieldLayout_Interleaved };
+    for (int l = 0; l < 2; l++) {
+        grid->setLayout(layouts[l]);
+        grid->placeRows(Int3(1, 2, 0), grid->numCells - Int3(2, 1, 0));
+        ASSERT_EQ(layouts[l], grid->getLayout());
+        for (int i = 0; i < grid->numCells.x; i++)
+            for (int j = 0; j < grid->numCells.y; j++)
+                for (int k = 0; k < grid->numCells.z; k++)
+                {
+                    ASSERT_EQ(expected.Ex(i, j, k), grid->Ex(i, j, k));
+                    ASSERT_EQ(expected.Bz(i, j, k), grid->Bz(i, j, k));
+                    ASSERT_EQ(expected.Jy(i, j, k), grid->Jy(i, j, k));
+                }
+    }
+}
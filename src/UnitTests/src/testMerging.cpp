@@ -28,3 +28,22 @@ TYPED_TEST(ThinningTest, kmeansMerging)
     ASSERT_NEAR_FP(originalTotalWeight, modifiedTotalWeight);
     ASSERT_TRUE(particles.size() <= numberParticles / 2);
 }
+
+TYPED_TEST(ThinningTest, kmeansMergingConservesMomentum)
+{
+    typedef typename ThinningTest<TypeParam>::ParticleArray ParticleArray;
+
+    ParticleArray particles;
+    int numberParticles = 100;
+    this->addRandomParticles(particles, numberParticles);
+    FP3 originalMomentum;
+    for (int i = 0; i < particles.size(); i++)
+        originalMomentum += particles[i].getMomentum() * particles[i].getWeight();
+
+    Merging<ParticleArray>::merge_with_kmeans(particles, numberParticles / 4, 30);
+
+    FP3 modifiedMomentum;
+    for (int i = 0; i < particles.size(); i++)
+        modifiedMomentum += particles[i].getMomentum() * particles[i].getWeight();
+    ASSERT_NEAR_FP3(originalMomentum / Constants<FP>::lightVelocity(), modifiedMomentum / Constants<FP>::lightVelocity());
+}
@@ -1,5 +1,6 @@
 #include "TestingUtility.h"
 
+#include "Grid.h"
 #include "Particle.h"
 #include "ParticleArray.h"
 
@@ -141,4 +142,277 @@ TYPED_TEST(ParticleArrayTest, PopBack)
             EXPECT_TRUE(this->eqParticles_(particle, particleCopy));
         }
     }
-}
\ No newline at end of file
+}
+
+TYPED_TEST(ParticleArrayTest, ResizeAndSetParticle)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+    typedef typename ParticleArrayTest<TypeParam>::Particle ParticleType;
+
+    ParticleArray particles, expected;
+    for (int i = 0; i < 7; i++) {
+        ParticleType particle = this->randomParticle();
+        particles.pushBack(particle);
+        expected.pushBack(particle);
+    }
+    particles.resize(19);
+    ASSERT_EQ(19, particles.size());
+    for (int i = 7; i < 19; i++) {
+        ParticleType particle = this->randomParticle();
+        particles.setParticle(i, particle);
+        expected.pushBack(particle);
+    }
+    ASSERT_TRUE(this->eqParticleArrays(expected, particles));
+}
+
+TYPED_TEST(ParticleArrayTest, CompactRemovesMarkedParticles)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+    typedef typename ParticleArrayTest<TypeParam>::Particle ParticleType;
+
+    // more particles than in a block of the compaction
+    const int numParticles = 3 * compactionBlockSize + 17;
+    ParticleArray particles, expected;
+    for (int i = 0; i < numParticles; i++) {
+        ParticleType particle = this->randomParticle();
+        particles.pushBack(particle);
+        if (i % 3 != 1)
+            expected.pushBack(particle);
+    }
+    for (int i = 1; i < numParticles; i += 3)
+        particles.markRemoved(i);
+    ASSERT_TRUE(particles.isRemoved(1));
+    ASSERT_FALSE(particles.isRemoved(2));
+    ASSERT_EQ(numParticles, particles.size());
+
+    particles.compact();
+    ASSERT_EQ(expected.size(), particles.size());
+    ASSERT_TRUE(this->eqParticleArrays(expected, particles));
+    for (int i = 0; i < (int)particles.size(); i++)
+        ASSERT_FALSE(particles.isRemoved(i));
+}
+
+TYPED_TEST(ParticleArrayTest, DeleteParticleKeepsMarks)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+
+    ParticleArray particles;
+    for (int i = 0; i < 5; i++)
+        particles.pushBack(this->randomParticle());
+    particles.markRemoved(4);
+    particles.deleteParticle(1);
+    ASSERT_TRUE(particles.isRemoved(1));
+    particles.compact();
+    ASSERT_EQ(3, particles.size());
+}
+
+TYPED_TEST(ParticleArrayTest, RemoveIf)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+    typedef typename ParticleArrayTest<TypeParam>::Particle ParticleType;
+
+    const int numParticles = 2 * compactionBlockSize + 5;
+    ParticleArray particles, expected;
+    std::vector<bool> mask(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        ParticleType particle = this->randomParticle();
+        particles.pushBack(particle);
+        mask[i] = (i % 5 == 0) || (i > compactionBlockSize && i < compactionBlockSize + 100);
+        if (!mask[i])
+            expected.pushBack(particle);
+    }
+    particles.removeIf(mask);
+    ASSERT_TRUE(this->eqParticleArrays(expected, particles));
+}
+
+TYPED_TEST(ParticleArrayTest, UnstableCompactKeepsParticles)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+    typedef typename ParticleArrayTest<TypeParam>::Particle ParticleType;
+
+    const int numParticles = 2 * compactionBlockSize + 5;
+    ParticleArray particles;
+    std::vector<char> mask(numParticles);
+    std::vector<FP> expectedWeights;
+    for (int i = 0; i < numParticles; i++) {
+        ParticleType particle = this->randomParticle();
+        particle.setWeight(i + 1);
+        particles.pushBack(particle);
+        mask[i] = (i % 3 == 0) || (i > numParticles - 50);
+        if (!mask[i])
+            expectedWeights.push_back(i + 1);
+    }
+    particles.removeIf(mask, false);
+    ASSERT_EQ(expectedWeights.size(), particles.size());
+    std::vector<FP> weights(particles.size());
+    for (int i = 0; i < (int)particles.size(); i++)
+        weights[i] = particles[i].getWeight();
+    std::sort(weights.begin(), weights.end());
+    for (int i = 0; i < (int)weights.size(); i++)
+        ASSERT_EQ(expectedWeights[i], weights[i]);
+}
+
+TYPED_TEST(ParticleArrayTest, Append)
+{
+    typedef typename ParticleArrayTest<TypeParam>::ParticleArray ParticleArray;
+    typedef typename ParticleArrayTest<TypeParam>::Particle ParticleType;
+
+    ParticleArray particles, expected;
+    ParticleType first = this->randomParticle();
+    particles.pushBack(first);
+    expected.pushBack(first);
+
+    const int numParticles = 23;
+    std::vector<FP> coords[3], momenta[3], weights;
+    for (int d = 0; d < 3; d++) {
+        coords[d].resize(numParticles);
+        momenta[d].resize(numParticles);
+    }
+    for (int i = 0; i < numParticles; i++) {
+        ParticleType particle = this->randomParticle();
+        for (int d = 0; d < this->dimension; d++)
+            coords[d][i] = particle.getPosition()[d];
+        for (int d = 0; d < 3; d++)
+            momenta[d][i] = particle.getMomentum()[d];
+        weights.push_back(particle.getWeight());
+        expected.pushBack(particle);
+    }
+    particles.append(coords[0].data(), coords[1].data(), coords[2].data(),
+        momenta[0].data(), momenta[1].data(), momenta[2].data(), weights.data(), numParticles);
+    ASSERT_EQ(expected.size(), particles.size());
+    for (int i = 0; i < (int)particles.size(); i++) {
+        ASSERT_TRUE(expected[i].getPosition() == particles[i].getPosition());
+        ASSERT_NEAR_FP3(expected[i].getP(), particles[i].getP());
+        ASSERT_NEAR_FP(expected[i].getGamma(), particles[i].getGamma());
+        ASSERT_EQ(expected[i].getWeight(), particles[i].getWeight());
+    }
+
+    particles.append(coords[0].data(), coords[1].data(), coords[2].data(),
+        momenta[0].data(), momenta[1].data(), momenta[2].data(), 0, 1);
+    ASSERT_EQ(numParticles + 2, particles.size());
+    ASSERT_EQ(1, particles.back().getWeight());
+}
+
+class ParticleArraySoATest : public ParticleArrayTest<ParticleArray3d> {
+};
+
+TEST_F(ParticleArraySoATest, ColumnsGiveParticleData)
+{
+    ParticleArray3d particles;
+    for (int i = 0; i < 9; i++)
+        particles.pushBack(randomParticle());
+    for (int i = 0; i < particles.size(); i++) {
+        ASSERT_EQ(particles[i].getPosition(), FP3(particles.getPositionData(0)[i],
+            particles.getPositionData(1)[i], particles.getPositionData(2)[i]));
+        ASSERT_EQ(particles[i].getP(), FP3(particles.getPData(0)[i],
+            particles.getPData(1)[i], particles.getPData(2)[i]));
+        ASSERT_EQ(particles[i].getWeight(), particles.getWeightData()[i]);
+        ASSERT_EQ(particles[i].getGamma(), particles.getGammaData()[i]);
+    }
+}
+
+TEST_F(ParticleArraySoATest, UpdateGammasAfterWritingColumns)
+{
+    ParticleArray3d particles;
+    for (int i = 0; i < 9; i++)
+        particles.pushBack(randomParticle());
+    for (int i = 0; i < particles.size(); i++)
+        particles.getPData(0)[i] *= 2;
+    particles.updateGammas();
+    for (int i = 0; i < particles.size(); i++)
+        ASSERT_NEAR_FP(sqrt(1 + particles[i].getP().norm2()), particles[i].getGamma());
+}
+
+TEST_F(ParticleArraySoATest, SortByCellOfGrid)
+{
+    YeeGrid grid(Int3(4, 3, 5), FP3(-1, 0, 1), FP3(0.5, 1, 0.25), Int3(4, 3, 5));
+    // cells of the grid include the external ones
+    const Int3 numCells = grid.numCells;
+    const FP3 origin = grid.origin, steps = grid.steps;
+    ParticleArray3d particles;
+    // particles outside of the grid go to its boundary cells, weights identify particles
+    std::vector<Particle3d> initial;
+    for (int i = 0; i < 300; i++) {
+        initial.push_back(randomParticle(origin - steps, origin + steps * (numCells + Int3(1, 1, 1)), Electron));
+        initial.back().setWeight(i + 1);
+        particles.pushBack(initial.back());
+    }
+    particles.sortByCell(&grid);
+
+    const std::vector<int>& offsets = particles.getCellOffsets();
+    ASSERT_EQ(numCells.volume() + 1, (int)offsets.size());
+    ASSERT_EQ(0, offsets.front());
+    ASSERT_EQ(particles.size(), offsets.back());
+    for (int c = 0; c < numCells.volume(); c++)
+        for (int idx = offsets[c]; idx < offsets[c + 1]; idx++) {
+            const Particle3d& particle = initial[(int)particles[idx].getWeight() - 1];
+            ASSERT_EQ(particle.getPosition(), particles[idx].getPosition());
+            ASSERT_EQ(particle.getP(), particles[idx].getP());
+            ASSERT_EQ(particle.getGamma(), particles[idx].getGamma());
+            Int3 cell(c / (numCells.y * numCells.z), (c / numCells.z) % numCells.y, c % numCells.z);
+            for (int d = 0; d < 3; d++) {
+                int expected = (int)floor((particle.getPosition()[d] - origin[d]) / steps[d]);
+                ASSERT_EQ(std::min(std::max(expected, 0), numCells[d] - 1), cell[d]);
+            }
+        }
+}
+
+TEST_F(ParticleArraySoATest, ParallelSortByCellIsStable)
+{
+    YeeGrid grid(Int3(2, 2, 2), FP3(0, 0, 0), FP3(1, 1, 1), Int3(2, 2, 2));
+    const Int3 numCells = grid.numCells;
+    ParticleArray3d particles;
+    // many particles per cell so that the sort goes in several chunks
+    for (int i = 0; i < 20 * numCells.volume(); i++) {
+        Particle3d particle = randomParticle(grid.origin, grid.origin + grid.steps * numCells, Electron);
+        particle.setWeight(i);
+        particles.pushBack(particle);
+    }
+    const int numThreads = omp_get_max_threads();
+    omp_set_num_threads(4);
+    particles.sortByCell(&grid);
+    omp_set_num_threads(numThreads);
+
+    const std::vector<int>& offsets = particles.getCellOffsets();
+    ASSERT_EQ(particles.size(), offsets.back());
+    for (int c = 0; c < numCells.volume(); c++)
+        for (int idx = offsets[c] + 1; idx < offsets[c + 1]; idx++)
+            ASSERT_LT(particles[idx - 1].getWeight(), particles[idx].getWeight());
+}
+
+TEST_F(ParticleArraySoATest, SortByCellPeriodically)
+{
+    YeeGrid grid(Int3(2, 2, 2), FP3(0, 0, 0), FP3(1, 1, 1), Int3(2, 2, 2));
+    ParticleArray3d particles;
+    for (int i = 0; i < 50; i++)
+        particles.pushBack(randomParticle(grid.origin, grid.origin + grid.steps * grid.numCells, Electron));
+    ASSERT_EQ(0, particles.getSortPeriod());
+    particles.sortByCellPeriodically(&grid);
+    ASSERT_TRUE(particles.getCellOffsets().empty());
+
+    particles.setSortPeriod(3);
+    for (int step = 1; step <= 3; step++) {
+        ASSERT_TRUE(particles.getCellOffsets().empty());
+        particles.sortByCellPeriodically(&grid);
+    }
+    ASSERT_EQ(grid.numCells.volume() + 1, (int)particles.getCellOffsets().size());
+}
+
+TEST_F(ParticleArraySoATest, ReserveKeepsColumnsInPlace)
+{
+    ParticleArray3d particles;
+    const int capacity = 100;
+    particles.reserve(capacity);
+    ASSERT_EQ(0, particles.size());
+    particles.pushBack(randomParticle());
+    FP* positions = particles.getPositionData(0);
+    FP* momenta = particles.getPData(2);
+    FP* weights = particles.getWeightData();
+    for (int i = 1; i < capacity; i++) {
+        particles.pushBack(randomParticle());
+        ASSERT_EQ(positions, particles.getPositionData(0));
+        ASSERT_EQ(momenta, particles.getPData(2));
+        ASSERT_EQ(weights, particles.getWeightData());
+    }
+    ASSERT_EQ(capacity, particles.size());
+}
@@ -4,6 +4,42 @@
 
 template <class SpeciesArrayType>
 class PusherTest : public SpeciesTest<SpeciesArrayType> {
+public:
+    typedef typename SpeciesTest<SpeciesArrayType>::SpeciesArray SpeciesArray;
+
+    YeeGrid* grid = nullptr;
+    SpeciesArray particles, expectedParticles;
+    std::vector<ValueField> fields;
+
+    ~PusherTest() {
+        delete grid;
+    }
+
+    /* Makes a grid with random fields of the given scale over [-10, 10), where particles
+    of randomParticle() are, adds the same particles to particles and expectedParticles
+    and the fields of the grid at their positions to fields. */
+    void initGridAndParticles(FP fieldScale, int numParticles = 12) {
+        Int3 numCells(8, 8, 8);
+        grid = new YeeGrid(numCells, FP3(-10, -10, -10), FP3(2.5, 2.5, 2.5), numCells);
+        for (int i = 0; i < grid->numCells.x; i++)
+            for (int j = 0; j < grid->numCells.y; j++)
+                for (int k = 0; k < grid->numCells.z; k++) {
+                    grid->Ex(i, j, k) = fieldScale * this->urand(-1, 1);
+                    grid->Ey(i, j, k) = fieldScale * this->urand(-1, 1);
+                    grid->Ez(i, j, k) = fieldScale * this->urand(-1, 1);
+                    grid->Bx(i, j, k) = fieldScale * this->urand(-1, 1);
+                    grid->By(i, j, k) = fieldScale * this->urand(-1, 1);
+                    grid->Bz(i, j, k) = fieldScale * this->urand(-1, 1);
+                }
+        for (int i = 0; i < numParticles; i++)
+        {
+            particles.pushBack(this->randomParticle(particles.getType()));
+            expectedParticles.pushBack(particles[i]);
+            ValueField field;
+            grid->getFields(particles[i].getPosition(), field.E, field.B);
+            fields.push_back(field);
+        }
+    }
 };
 
 
@@ -69,4 +105,227 @@ TYPED_TEST(PusherTest, BorisPusherSaveEnergyForChunk)
         MomentumType p = speciesParticles[i].getP();
         ASSERT_NEAR_FP(energy[i], p.norm2());
     }
-}
\ No newline at end of file
+}
+
+TYPED_TEST(PusherTest, BorisPusherWithGridMatchesPrecomputedFields)
+{
+    this->initGridAndParticles(1);
+    BorisPusher scalarPusher;
+    FP timeStep = 0.01;
+    scalarPusher(&this->expectedParticles, this->fields, timeStep);
+    scalarPusher(&this->particles, this->grid, timeStep);
+
+    for (int i = 0; i < this->particles.size(); i++)
+    {
+        ASSERT_NEAR_FP3(this->expectedParticles[i].getP(), this->particles[i].getP());
+        ASSERT_NEAR_FP3(this->expectedParticles[i].getPosition(), this->particles[i].getPosition());
+    }
+}
+
+TYPED_TEST(PusherTest, RadiationReactionWithGridMatchesPrecomputedFields)
+{
+    // the fields are strong enough for the friction
+    this->initGridAndParticles(1e12);
+    RadiationReaction radiationReaction;
+    FP timeStep = 1e-22;
+    radiationReaction(&this->expectedParticles, this->fields, timeStep);
+    radiationReaction(&this->particles, this->grid, timeStep);
+
+    for (int i = 0; i < this->particles.size(); i++)
+        ASSERT_NEAR_FP3(this->expectedParticles[i].getP(), this->particles[i].getP());
+}
+
+TYPED_TEST(PusherTest, VayAndHigueraCaryPushersSaveEnergyInMagneticField)
+{
+    typedef typename SpeciesTest<TypeParam>::SpeciesArray SpeciesArray;
+    typedef typename SpeciesTest<TypeParam>::MomentumType MomentumType;
+
+    SpeciesArray vayParticles, higueraCaryParticles;
+    std::vector<FP> energy;
+    std::vector<ValueField> fields;
+    int numParticles = 12;
+    for (int i = 0; i < numParticles; i++)
+    {
+        vayParticles.pushBack(this->randomParticle(vayParticles.getType()));
+        higueraCaryParticles.pushBack(vayParticles[i]);
+        MomentumType p = vayParticles[i].getP();
+        energy.push_back(p.norm2());
+        fields.push_back(ValueField(0.0, 0.0, 0.0, 1.0, 1.0, 1.0));
+    }
+
+    VayPusher vayPusher;
+    HigueraCaryPusher higueraCaryPusher;
+    FP timeStep = 0.01;
+    vayPusher(&vayParticles, fields, timeStep);
+    higueraCaryPusher(&higueraCaryParticles, fields, timeStep);
+
+    for (int i = 0; i < numParticles; i++)
+    {
+        MomentumType p = vayParticles[i].getP();
+        ASSERT_NEAR_FP(energy[i], p.norm2());
+        p = higueraCaryParticles[i].getP();
+        ASSERT_NEAR_FP(energy[i], p.norm2());
+    }
+}
+
+class ColumnPusherTest : public BaseParticleFixture<Particle3d> {
+public:
+    ParticleArray3d particles;
+    ParticleArrayAoS3d expectedParticles;
+    std::vector<ValueField> fields;
+
+    void createParticles(ParticleTypes type, int numParticles) {
+        particles.setType(type);
+        expectedParticles.setType(type);
+        for (int i = 0; i < numParticles; i++) {
+            Particle3d particle = randomParticle(type);
+            particles.pushBack(particle);
+            expectedParticles.pushBack(particle);
+            fields.push_back(ValueField(urandFP3(FP3(-1, -1, -1), FP3(1, 1, 1)),
+                urandFP3(FP3(-1, -1, -1), FP3(1, 1, 1))));
+        }
+    }
+
+    void checkParticles() {
+        ASSERT_EQ(expectedParticles.size(), particles.size());
+        for (int i = 0; i < particles.size(); i++) {
+            ASSERT_NEAR_FP3(expectedParticles[i].getP(), particles[i].getP());
+            ASSERT_NEAR_FP(expectedParticles[i].getGamma(), particles[i].getGamma());
+            ASSERT_NEAR_FP3(expectedParticles[i].getPosition(), particles[i].getPosition());
+        }
+    }
+
+    template<class Pusher>
+    void checkPusherMatchesProxyPath() {
+        Pusher pusher;
+        FP timeStep = 0.01;
+        createParticles(Positron, 1003);
+        pusher(&expectedParticles, fields, timeStep);
+        pusher(&particles, fields, timeStep);
+        checkParticles();
+    }
+
+    /* In crossed fields with E < B a particle moving with the drift velocity c * E x B / B^2
+    is at rest in the frame without the electric field, so its momentum must not change.
+    The Vay and Higuera-Cary pushers keep it for time steps much larger than the period of
+    the rotation, the Boris pusher does not. */
+    template<class Pusher>
+    void checkDriftInCrossedFields() {
+        const FP b = 1.0, e = 0.9 * b;
+        const FP beta = e / b, gamma = 1 / sqrt(1 - beta * beta);
+        const FP3 p(gamma * beta, 0, 0);
+        particles.setType(Electron);
+        particles.pushBack(Particle3d(FP3(0, 0, 0),
+            p * (Constants<FP>::electronMass() * Constants<FP>::lightVelocity())));
+        fields.assign(1, ValueField(0, e, 0, 0, 0, b));
+
+        // the rotation by the magnetic field over a step is many periods
+        FP timeStep = 100 * Constants<FP>::electronMass() * Constants<FP>::lightVelocity() /
+            (fabs(Constants<FP>::electronCharge()) * b);
+        Pusher pusher;
+        int numSteps = 100;
+        for (int step = 0; step < numSteps; step++)
+            pusher(&particles, fields, timeStep);
+
+        ASSERT_NEAR_FP3(p, particles[0].getP());
+        ASSERT_NEAR_FP(numSteps * timeStep * beta * Constants<FP>::lightVelocity(),
+            particles[0].getPosition().x);
+    }
+};
+
+TEST_F(ColumnPusherTest, BorisPusherMatchesProxyPath)
+{
+    ParticleTypes types[] = { Electron, Positron, Proton };
+    BorisPusher pusher;
+    FP timeStep = 0.01;
+    for (int t = 0; t < 3; t++) {
+        particles.clear();
+        expectedParticles.clear();
+        fields.clear();
+        // the number of particles is not a multiple of a vector length
+        createParticles(types[t], 1003);
+        pusher(&expectedParticles, fields, timeStep);
+        pusher(&particles, fields, timeStep);
+        checkParticles();
+    }
+}
+
+TEST_F(ColumnPusherTest, BorisPusherWithGridMatchesProxyPath)
+{
+    Int3 numCells(8, 8, 8);
+    FP3 steps(2.5, 2.5, 2.5);
+    YeeGrid grid(numCells, FP3(-10, -10, -10), steps, numCells);
+    for (int i = 0; i < grid.numCells.x; i++)
+        for (int j = 0; j < grid.numCells.y; j++)
+            for (int k = 0; k < grid.numCells.z; k++) {
+                grid.Ex(i, j, k) = urand(-1, 1);
+                grid.By(i, j, k) = urand(-1, 1);
+                grid.Bz(i, j, k) = urand(-1, 1);
+            }
+    createParticles(Electron, 700);
+
+    BorisPusher pusher;
+    FP timeStep = 0.01;
+    pusher(&expectedParticles, &grid, timeStep);
+    pusher(&particles, &grid, timeStep);
+    checkParticles();
+}
+
+TEST_F(ColumnPusherTest, VayPusherMatchesProxyPath)
+{
+    checkPusherMatchesProxyPath<VayPusher>();
+}
+
+TEST_F(ColumnPusherTest, HigueraCaryPusherMatchesProxyPath)
+{
+    checkPusherMatchesProxyPath<HigueraCaryPusher>();
+}
+
+TEST_F(ColumnPusherTest, VayPusherGivesDriftInCrossedFields)
+{
+    checkDriftInCrossedFields<VayPusher>();
+}
+
+TEST_F(ColumnPusherTest, HigueraCaryPusherGivesDriftInCrossedFields)
+{
+    checkDriftInCrossedFields<HigueraCaryPusher>();
+}
+
+TEST_F(ColumnPusherTest, BorisPusherWithRadiationReactionMatchesTwoPasses)
+{
+    // the fields are strong enough for the friction to change the momentum noticeably over a step
+    const FP fieldScale = 1e12, timeStep = 1e-22;
+    ParticleTypes types[] = { Electron, Positron, Proton };
+    BorisPusher borisPusher;
+    RadiationReaction radiationReaction;
+    BorisPusherWithRadiationReaction pusher;
+    for (int t = 0; t < 3; t++) {
+        particles.clear();
+        expectedParticles.clear();
+        fields.clear();
+        createParticles(types[t], 1003);
+        for (int i = 0; i < (int)fields.size(); i++) {
+            fields[i].E = fields[i].E * fieldScale;
+            fields[i].B = fields[i].B * fieldScale;
+        }
+        ParticleArrayAoS3d fusedParticles = expectedParticles, borisParticles = expectedParticles;
+
+        borisPusher(&expectedParticles, fields, timeStep);
+        radiationReaction(&expectedParticles, fields, timeStep);
+        pusher(&particles, fields, timeStep);
+        pusher(&fusedParticles, fields, timeStep);
+        borisPusher(&borisParticles, fields, timeStep);
+
+        checkParticles();
+        FP maxFriction = 0;
+        for (int i = 0; i < particles.size(); i++) {
+            ASSERT_NEAR_FP3(expectedParticles[i].getP(), fusedParticles[i].getP());
+            maxFriction = std::max(maxFriction, dist(borisParticles[i].getP(), fusedParticles[i].getP()) /
+                borisParticles[i].getP().norm());
+        }
+        if (types[t] == Proton)
+            ASSERT_EQ(0, maxFriction);
+        else
+            ASSERT_GT(maxFriction, 100 * maxRelativeError);
+    }
+}
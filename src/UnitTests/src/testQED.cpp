@@ -0,0 +1,97 @@
+#include "TestingUtility.h"
+
+#include "QED_AEG.h"
+
+using namespace pfc;
+
+
+class QEDTest : public BaseParticleFixture<Particle3d> {
+public:
+    YeeGrid* grid;
+    ScalarQED_AEG_only_electron_Yee qed;
+    Ensemble3d particles;
+    FP timeStep;
+
+    virtual void SetUp() {
+        BaseParticleFixture<Particle3d>::SetUp();
+        Int3 numCells(8, 8, 8);
+        grid = new YeeGrid(numCells, FP3(0, 0, 0), FP3(1, 1, 1), numCells);
+        timeStep = 1e-6 / Constants<FP>::lightVelocity();
+        qed.setSeed(42);
+    }
+
+    virtual void TearDown() {
+        delete grid;
+    }
+
+    void setMagneticField(FP bz) {
+        for (int i = 0; i < grid->Bz.getSize().x; i++)
+            for (int j = 0; j < grid->Bz.getSize().y; j++)
+                for (int k = 0; k < grid->Bz.getSize().z; k++)
+                    grid->Bz(i, j, k) = bz;
+    }
+
+    // particles of the type moving along x with the given gamma in the middle of the grid
+    void addParticles(ParticleTypes type, int numParticles, FP gamma) {
+        FP3 momentum(gamma * Constants<FP>::electronMass() * Constants<FP>::lightVelocity(), 0, 0);
+        for (int i = 0; i < numParticles; i++)
+            particles.addParticle(Particle3d(FP3(4, 4, 4), momentum * (1 + (FP)(i % 7)), 1, type));
+    }
+
+    // the particles after numSteps steps of a new QED handler with the seed and the number of threads
+    Ensemble3d processWithThreads(int numThreads, int numSteps) {
+#ifdef __USE_OMP__
+        int maxThreads = omp_get_max_threads();
+        omp_set_num_threads(numThreads);
+#endif
+        // buffers of threads are allocated by the constructor
+        ScalarQED_AEG_only_electron_Yee handler;
+        handler.setSeed(42);
+        handler.setProcessCoefficients(1, 1);
+        Ensemble3d result = particles;
+        for (int step = 0; step < numSteps; step++)
+            handler.processParticles(&result, grid, timeStep);
+#ifdef __USE_OMP__
+        omp_set_num_threads(maxThreads);
+#endif
+        return result;
+    }
+};
+
+TEST_F(QEDTest, DecayedPhotonsAreRemoved)
+{
+    setMagneticField(3e12);
+    int numPhotons = 1000;
+    addParticles(Photon, numPhotons, 1e5);
+    // only pair production, each decayed photon gives an electron and a positron
+    qed.setProcessCoefficients(0, 1);
+
+    qed.processParticles(&particles, grid, timeStep);
+
+    int numPairs = particles[Electron].size();
+    ASSERT_GT(numPairs, 0);
+    ASSERT_EQ(numPairs, particles[Positron].size());
+    ASSERT_EQ(numPhotons - numPairs, particles[Photon].size());
+    for (int i = 0; i < particles[Photon].size(); i++)
+        ASSERT_FALSE(particles[Photon].isRemoved(i));
+}
+
+TEST_F(QEDTest, ResultDoesNotDependOnNumberOfThreads)
+{
+    setMagneticField(3e11);
+    addParticles(Electron, 300, 300);
+    addParticles(Photon, 300, 1e5);
+
+    Ensemble3d expected = processWithThreads(1, 10);
+    Ensemble3d actual = processWithThreads(4, 10);
+
+    ASSERT_GT(expected[Photon].size(), 300);
+    for (int t = 0; t < sizeParticleTypes; t++) {
+        ASSERT_EQ(expected[t].size(), actual[t].size());
+        for (int i = 0; i < expected[t].size(); i++) {
+            ASSERT_EQ_FP3(expected[t][i].getPosition(), actual[t][i].getPosition());
+            ASSERT_EQ_FP3(expected[t][i].getP(), actual[t][i].getP());
+            ASSERT_EQ(expected[t][i].getWeight(), actual[t][i].getWeight());
+        }
+    }
+}
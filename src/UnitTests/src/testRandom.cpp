@@ -0,0 +1,59 @@
+#include "TestingUtility.h"
+
+#include "Random.h"
+
+using namespace pfc;
+
+
+// Known answers of Philox4x32-10 from the Random123 distribution
+TEST(RandomTest, PhiloxKnownAnswers) {
+    Philox4x32::Counter zeroCounter = { { 0, 0, 0, 0 } };
+    Philox4x32::Key zeroKey = { { 0, 0 } };
+    Philox4x32::Counter result = Philox4x32::generate(zeroCounter, zeroKey);
+    ASSERT_EQ(0x6627e8d5u, result.v[0]);
+    ASSERT_EQ(0xe169c58du, result.v[1]);
+    ASSERT_EQ(0xbc57ac4cu, result.v[2]);
+    ASSERT_EQ(0x9b00dbd8u, result.v[3]);
+
+    Philox4x32::Counter piCounter = { { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 } };
+    Philox4x32::Key piKey = { { 0xa4093822, 0x299f31d0 } };
+    result = Philox4x32::generate(piCounter, piKey);
+    ASSERT_EQ(0xd16cfe09u, result.v[0]);
+    ASSERT_EQ(0x94fdccebu, result.v[1]);
+    ASSERT_EQ(0x5001e420u, result.v[2]);
+    ASSERT_EQ(0x24126ea1u, result.v[3]);
+}
+
+TEST(RandomTest, SameIdsGiveSameNumbers) {
+    RandomStream first(17, 3, 1, 100), second(17, 3, 1, 100);
+    for (int i = 0; i < 10; i++)
+        ASSERT_EQ(first.next(), second.next());
+}
+
+TEST(RandomTest, DifferentIdsGiveDifferentNumbers) {
+    RandomStream stream(17, 3, 1, 100);
+    RandomStream otherSeed(18, 3, 1, 100), otherStep(17, 4, 1, 100),
+        otherType(17, 3, 2, 100), otherIndex(17, 3, 1, 101);
+    for (int i = 0; i < 10; i++) {
+        FP value = stream.next();
+        ASSERT_NE(value, otherSeed.next());
+        ASSERT_NE(value, otherStep.next());
+        ASSERT_NE(value, otherType.next());
+        ASSERT_NE(value, otherIndex.next());
+    }
+}
+
+TEST(RandomTest, UniformInUnitInterval) {
+    RandomStream stream(5);
+    const int numValues = 100000;
+    FP sum = 0, sumSquares = 0;
+    for (int i = 0; i < numValues; i++) {
+        FP value = stream.next();
+        ASSERT_LE(0, value);
+        ASSERT_GT(1, value);
+        sum += value;
+        sumSquares += value * value;
+    }
+    ASSERT_NEAR(0.5, sum / numValues, 0.01);
+    ASSERT_NEAR(1.0 / 3.0, sumSquares / numValues, 0.01);
+}
@@ -62,7 +62,7 @@ TYPED_TEST(ScalarFieldTest, IndexAccess) {
             }
 }
 
-/*TYPED_TEST(ScalarFieldTest, Zeroize) {
+TYPED_TEST(ScalarFieldTest, Zeroize) {
     typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
     Int3 size(5, 3, 8);
     ScalarField f(this->createScalarField(size));
@@ -72,4 +72,111 @@ TYPED_TEST(ScalarFieldTest, IndexAccess) {
         for (int j = 0; j < size.y; j++)
             for (int k = 0; k < size.z; k++)
                 ASSERT_EQ(f(i, j, k), 0);
-}*/
+}
+
+TYPED_TEST(ScalarFieldTest, BrickLayoutKeepsValues) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    Int3 size(5, 3, 8);
+    ScalarField f(this->createScalarField(size));
+    f.setLayout(ScalarFieldLayout_Bricks, 2);
+    ASSERT_EQ(ScalarFieldLayout_Bricks, f.getLayout());
+    ASSERT_GE(f.getStorageSize(), size.volume());
+    std::vector<bool> used(f.getStorageSize(), false);
+    for (int i = 0; i < size.x; i++)
+        for (int j = 0; j < size.y; j++)
+            for (int k = 0; k < size.z; k++) {
+                ASSERT_EQ(f(i, j, k), k + (j + i * size.y) * size.z);
+                int idx = f.index(i, j, k);
+                ASSERT_TRUE(idx >= 0 && idx < f.getStorageSize());
+                ASSERT_FALSE(used[idx]);
+                used[idx] = true;
+            }
+    f.setLayout(ScalarFieldLayout_RowMajor);
+    ASSERT_EQ(size.volume(), f.getStorageSize());
+    for (int i = 0; i < size.x; i++)
+        for (int j = 0; j < size.y; j++)
+            for (int k = 0; k < size.z; k++)
+                ASSERT_EQ(f.getData()[k + (j + i * size.y) * size.z], k + (j + i * size.y) * size.z);
+}
+
+TYPED_TEST(ScalarFieldTest, BrickLayoutKeepsInterpolation) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    Int3 size(9, 7, 1);
+    ScalarField f(this->createScalarField(size)), g(f);
+    g.setLayout(ScalarFieldLayout_Bricks, 4);
+    for (int testIdx = 0; testIdx < 20; testIdx++) {
+        Int3 base = this->urandInt3(Int3(1, 1, 0), Int3(5, 3, 0));
+        FP3 coeffs = this->urandFP3(FP3(0, 0, 0), FP3(1, 1, 1));
+        ASSERT_EQ(f.interpolateCIC(base, coeffs), g.interpolateCIC(base, coeffs));
+        ASSERT_EQ(f.interpolateTSC(base, coeffs), g.interpolateTSC(base, coeffs));
+        ASSERT_EQ(f.interpolatePCS(base, coeffs), g.interpolatePCS(base, coeffs));
+    }
+}
+
+TYPED_TEST(ScalarFieldTest, PaddedLayoutAlignsRows) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    Int3 size(4, 3, 5);
+    ScalarField f(this->createScalarField(size));
+    f.setLayout(ScalarFieldLayout_Padded);
+    ASSERT_EQ(ScalarFieldLayout_Padded, f.getLayout());
+    ASSERT_GE(f.getPitch(), size.z);
+    ASSERT_EQ(size.x * size.y * f.getPitch(), f.getStorageSize());
+    for (int i = 0; i < size.x; i++)
+        for (int j = 0; j < size.y; j++) {
+            ASSERT_EQ(0, (size_t)&f(i, j, 0) % 64);
+            for (int k = 0; k < size.z; k++)
+                ASSERT_EQ(f(i, j, k), k + (j + i * size.y) * size.z);
+        }
+}
+
+TYPED_TEST(ScalarFieldTest, PlaceRowsKeepsValues) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    Int3 size(6, 5, 3);
+    ScalarField f(this->createScalarField(size)), g(f);
+    g.setLayout(ScalarFieldLayout_Padded);
+    f.placeRows(Int3(1, 1, 0), Int3(5, 4, 3));
+    g.placeRows(Int3(1, 1, 0), Int3(5, 4, 3));
+    for (int i = 0; i < size.x; i++)
+        for (int j = 0; j < size.y; j++)
+            for (int k = 0; k < size.z; k++) {
+                ASSERT_EQ(f(i, j, k), k + (j + i * size.y) * size.z);
+                ASSERT_EQ(g(i, j, k), k + (j + i * size.y) * size.z);
+            }
+    f.setLayout(ScalarFieldLayout_Bricks);
+    ASSERT_ANY_THROW(f.placeRows(Int3(0, 0, 0), size));
+}
+
+TYPED_TEST(ScalarFieldTest, HugePagesGiveZeroValues) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    Int3 size(64, 64, 64);
+    HugePages modes[] = { HugePages_Transparent, HugePages_Explicit };
+    for (int m = 0; m < 2; m++) {
+        setHugePages(modes[m]);
+        ScalarField f(size);
+        ASSERT_EQ(0, (size_t)f.getData() % 64);
+        for (int idx = 0; idx < size.volume(); idx++)
+            ASSERT_EQ(0, f.getData()[idx]);
+        f.getData()[size.volume() - 1] = 1;
+    }
+    setHugePages(HugePages_None);
+}
+
+TYPED_TEST(ScalarFieldTest, StridesGiveValues) {
+    typedef typename ScalarFieldTest<TypeParam>::ScalarFieldType ScalarField;
+    Int3 size(4, 3, 5);
+    ScalarField rowMajor(this->createScalarField(size)), padded(rowMajor), bricks(rowMajor);
+    padded.setLayout(ScalarFieldLayout_Padded);
+    bricks.setLayout(ScalarFieldLayout_Bricks);
+    std::vector<TypeParam> memory(2 * size.volume());
+    ScalarField interleaved(memory.data() + 1, size, 2);
+    ScalarField* fields[] = { &rowMajor, &padded, &interleaved };
+    for (int f = 0; f < 3; f++) {
+        Int3 strides = fields[f]->getStrides();
+        for (int i = 0; i < size.x; i++)
+            for (int j = 0; j < size.y; j++)
+                for (int k = 0; k < size.z; k++)
+                    ASSERT_EQ(&(*fields[f])(i, j, k),
+                        fields[f]->getData() + i * strides.x + j * strides.y + k * strides.z);
+    }
+    ASSERT_ANY_THROW(bricks.getStrides());
+}
@@ -0,0 +1,83 @@
+#include "TestingUtility.h"
+
+#include "SynchrotronTables.h"
+
+using namespace pfc;
+
+
+class SynchrotronTablesTest : public BaseFixture {
+public:
+    SynchrotronTables tables;
+
+    SynchrotronTablesTest() : tables(64, 128) {}
+
+    // rate and mean fraction by the midpoint rule, the photon spectrum is integrated over d = r^3
+    void integrate(FP(*spectrum)(FP, FP), bool cubic, FP chi, FP& rate, FP& meanFraction) {
+        const int numPoints = 200000;
+        rate = 0;
+        FP moment = 0;
+        for (int i = 0; i < numPoints; i++) {
+            FP r = (i + (FP)0.5) / numPoints;
+            FP d = cubic ? r * r * r : r;
+            FP value = spectrum(chi, d) * (cubic ? 3 * r * r : 1) / numPoints;
+            rate += value;
+            moment += value * d;
+        }
+        meanFraction = moment / rate;
+    }
+
+    template <class Sample>
+    FP tableMean(Sample sample) {
+        const int numPoints = 100000;
+        FP sum = 0;
+        for (int i = 0; i < numPoints; i++)
+            sum += sample((i + (FP)0.5) / numPoints);
+        return sum / numPoints;
+    }
+};
+
+TEST_F(SynchrotronTablesTest, WrongParametersThrow) {
+    ASSERT_ANY_THROW(SynchrotronTables(2, 128));
+    ASSERT_ANY_THROW(SynchrotronTables(64, 128, 1.0, 0.1));
+}
+
+TEST_F(SynchrotronTablesTest, Contains) {
+    ASSERT_TRUE(tables.contains(1.0));
+    ASSERT_FALSE(tables.contains(tables.getChiMin() / 2));
+    ASSERT_FALSE(tables.contains(tables.getChiMax() * 2));
+}
+
+TEST_F(SynchrotronTablesTest, PhotonRatesAndFractions) {
+    FP chis[] = { 0.0123, 0.77, 47.0 };
+    for (size_t i = 0; i < sizeof(chis) / sizeof(*chis); i++) {
+        FP chi = chis[i], rate, meanFraction;
+        integrate(&SynchrotronTables::photonSpectrum, true, chi, rate, meanFraction);
+        ASSERT_NEAR(rate, tables.photonRate(chi), 0.005 * rate);
+        FP mean = tableMean([&](FP r) { return tables.photonFraction(chi, r); });
+        ASSERT_NEAR(meanFraction, mean, 0.01 * meanFraction);
+    }
+}
+
+TEST_F(SynchrotronTablesTest, PairRatesAndFractions) {
+    FP chis[] = { 0.77, 47.0 };
+    for (size_t i = 0; i < sizeof(chis) / sizeof(*chis); i++) {
+        FP chi = chis[i], rate, meanFraction;
+        integrate(&SynchrotronTables::pairSpectrum, false, chi, rate, meanFraction);
+        ASSERT_NEAR(rate, tables.pairRate(chi), 0.005 * rate);
+        FP mean = tableMean([&](FP r) { return tables.pairFraction(chi, r); });
+        ASSERT_NEAR(meanFraction, mean, 0.01 * meanFraction);
+    }
+}
+
+TEST_F(SynchrotronTablesTest, FractionsAreInUnitInterval) {
+    FP chis[] = { tables.getChiMin(), 0.5, tables.getChiMax() };
+    for (size_t i = 0; i < sizeof(chis) / sizeof(*chis); i++)
+        for (int j = 0; j <= 100; j++) {
+            FP r = std::min((FP)j / 100, (FP)1 - (FP)1e-12);
+            FP photon = tables.photonFraction(chis[i], r), pair = tables.pairFraction(chis[i], r);
+            ASSERT_LE(0, photon);
+            ASSERT_GE(1, photon);
+            ASSERT_LE(0, pair);
+            ASSERT_GE(1, pair);
+        }
+}
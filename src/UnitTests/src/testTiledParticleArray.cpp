@@ -0,0 +1,131 @@
+#include "TestingUtility.h"
+
+#include "TiledParticleArray.h"
+
+using namespace pfc;
+
+
+class TiledParticleArrayTest : public BaseParticleFixture<Particle3d> {
+public:
+    Int3 numCells;
+    FP3 minCoords, steps;
+    TiledParticleArray<Three>* particles;
+
+    virtual void SetUp() {
+        BaseParticleFixture<Particle3d>::SetUp();
+        numCells = Int3(20, 13, 7);
+        minCoords = FP3(-1.0, 0.5, 0.0);
+        steps = FP3(0.1, 0.2, 0.3);
+        particles = new TiledParticleArray<Three>(Electron, numCells, minCoords, steps, Int3(6, 6, 6));
+    }
+
+    virtual void TearDown() {
+        delete particles;
+    }
+
+    Particle3d randomParticle() {
+        return BaseParticleFixture<Particle3d>::randomParticle(minCoords, minCoords + steps * numCells, Electron);
+    }
+
+    // all particles are in the cells of their tiles
+    bool inTiles() {
+        for (int t = 0; t < particles->getNumTiles(); t++) {
+            FP3 begin = minCoords + steps * particles->getTileBegin(t);
+            FP3 end = begin + steps * particles->getTileCells(t);
+            for (int idx = 0; idx < particles->getTile(t).size(); idx++) {
+                FP3 position = particles->getTile(t)[idx].getPosition();
+                for (int d = 0; d < 3; d++)
+                    if (position[d] < begin[d] || position[d] >= end[d])
+                        return false;
+            }
+        }
+        return true;
+    }
+
+    FP totalWeight() {
+        FP result = 0;
+        for (int t = 0; t < particles->getNumTiles(); t++)
+            for (int idx = 0; idx < particles->getTile(t).size(); idx++)
+                result += particles->getTile(t)[idx].getWeight();
+        return result;
+    }
+};
+
+TEST_F(TiledParticleArrayTest, Tiles) {
+    ASSERT_EQ_INT3(Int3(4, 3, 2), particles->getNumTilesPerDimension());
+    ASSERT_EQ(24, particles->getNumTiles());
+    int last = particles->getTileIndex(Int3(3, 2, 1));
+    ASSERT_EQ_INT3(Int3(3, 2, 1), particles->getTileCoords(last));
+    ASSERT_EQ_INT3(Int3(18, 12, 6), particles->getTileBegin(last));
+    ASSERT_EQ_INT3(Int3(2, 1, 1), particles->getTileCells(last));
+}
+
+TEST_F(TiledParticleArrayTest, WrongSizesThrow) {
+    ASSERT_ANY_THROW(TiledParticleArray<Three>(Electron, Int3(0, 1, 1), minCoords, steps));
+    ASSERT_ANY_THROW(TiledParticleArray<Three>(Electron, numCells, minCoords, steps, Int3(8, 0, 8)));
+}
+
+TEST_F(TiledParticleArrayTest, PushBackGoesToTiles) {
+    for (int i = 0; i < 500; i++)
+        particles->pushBack(randomParticle());
+    ASSERT_EQ(500, particles->size());
+    ASSERT_TRUE(inTiles());
+}
+
+TEST_F(TiledParticleArrayTest, ExchangeMovesParticlesToTiles) {
+    for (int i = 0; i < 500; i++)
+        particles->pushBack(randomParticle());
+    FP weight = totalWeight();
+    for (int t = 0; t < particles->getNumTiles(); t++)
+        for (int idx = 0; idx < particles->getTile(t).size(); idx++)
+            particles->getTile(t)[idx].setPosition(randomParticle().getPosition());
+    particles->exchange();
+    ASSERT_EQ(500, particles->size());
+    ASSERT_NEAR_FP(weight, totalWeight());
+    ASSERT_TRUE(inTiles());
+}
+
+TEST_F(TiledParticleArrayTest, ParticlesOutsideGoToBoundaryTiles) {
+    particles->pushBack(Particle3d(minCoords - steps, FP3(0, 0, 0), 1, Electron));
+    particles->pushBack(Particle3d(minCoords + steps * (numCells + Int3(1, 1, 1)), FP3(0, 0, 0), 1, Electron));
+    ASSERT_EQ(1, particles->getTile(0).size());
+    ASSERT_EQ(1, particles->getTile(particles->getNumTiles() - 1).size());
+}
+
+TEST_F(TiledParticleArrayTest, SortByCell) {
+    for (int i = 0; i < 1000; i++)
+        particles->pushBack(randomParticle());
+    particles->sortByCell();
+    ASSERT_EQ(1000, particles->size());
+    for (int t = 0; t < particles->getNumTiles(); t++) {
+        const Int3 begin = particles->getTileBegin(t), cells = particles->getTileCells(t);
+        const std::vector<int>& offsets = particles->getCellOffsets(t);
+        ASSERT_EQ(cells.x * cells.y * cells.z + 1, (int)offsets.size());
+        ASSERT_EQ(0, offsets.front());
+        ASSERT_EQ(particles->getTile(t).size(), offsets.back());
+        for (int i = 0; i < cells.x; i++)
+            for (int j = 0; j < cells.y; j++)
+                for (int k = 0; k < cells.z; k++) {
+                    int c = (i * cells.y + j) * cells.z + k;
+                    FP3 cellMin = minCoords + steps * (begin + Int3(i, j, k));
+                    FP3 cellMax = cellMin + steps;
+                    for (int idx = offsets[c]; idx < offsets[c + 1]; idx++) {
+                        FP3 position = particles->getTile(t)[idx].getPosition();
+                        for (int d = 0; d < 3; d++) {
+                            ASSERT_LE(cellMin[d] - 1e-12, position[d]);
+                            ASSERT_GE(cellMax[d] + 1e-12, position[d]);
+                        }
+                    }
+                }
+    }
+}
+
+TEST_F(TiledParticleArrayTest, SortPeriod) {
+    for (int i = 0; i < 100; i++)
+        particles->pushBack(randomParticle());
+    particles->setSortPeriod(2);
+    particles->exchange();
+    ASSERT_TRUE(particles->getCellOffsets(0).empty());
+    particles->exchange();
+    ASSERT_FALSE(particles->getCellOffsets(0).empty());
+}
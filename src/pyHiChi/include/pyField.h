@@ -1,6 +1,7 @@
 #pragma once
 #include <memory>
 #include "Grid.h"
+#include "Enums.h"
 #include "AnalyticalField.h"
 #include "FieldValue.h"
 #include "Mapping.h"
@@ -10,6 +11,7 @@
 #include "Mapping.h"
 
 #include "pybind11/pybind11.h"
+#include "pybind11/numpy.h"
 
 namespace py = pybind11;
 using namespace pybind11::literals;
@@ -50,6 +52,57 @@ namespace pfc
     };
 
 
+    typedef py::array_t<FP, py::array::c_style | py::array::forcecast> FPArray;
+
+    /* Vectorized python functions are called once per layer i = const of the grid
+    with 2d numpy arrays of coordinates and return arrays of the same shape or scalars. */
+
+    // coordinates getCoords(i, j, k) of the layer i
+    template <class GetCoords>
+    void getLayerCoords(int i, const Int3& numCells, GetCoords getCoords, FPArray& x, FPArray& y, FPArray& z)
+    {
+        const int ny = numCells.y, nz = numCells.z;
+        x = FPArray(std::vector<ssize_t>{ ny, nz });
+        y = FPArray(std::vector<ssize_t>{ ny, nz });
+        z = FPArray(std::vector<ssize_t>{ ny, nz });
+        FP* xData = x.mutable_data(), *yData = y.mutable_data(), *zData = z.mutable_data();
+        OMP_FOR()
+        for (int j = 0; j < ny; j++)
+            for (int k = 0; k < nz; k++) {
+                FP3 coords = getCoords(i, j, k);
+                xData[j * nz + k] = coords.x;
+                yData[j * nz + k] = coords.y;
+                zData[j * nz + k] = coords.z;
+            }
+    }
+
+    inline FPArray getLayer(ScalarField<FP>& field, int i, const Int3& numCells)
+    {
+        const int ny = numCells.y, nz = numCells.z;
+        FPArray values(std::vector<ssize_t>{ ny, nz });
+        FP* data = values.mutable_data();
+        OMP_FOR()
+        for (int j = 0; j < ny; j++)
+            for (int k = 0; k < nz; k++)
+                data[j * nz + k] = field(i, j, k);
+        return values;
+    }
+
+    inline void setLayer(ScalarField<FP>& field, int i, const Int3& numCells, py::handle result)
+    {
+        const int ny = numCells.y, nz = numCells.z;
+        FPArray values = py::cast<FPArray>(result);
+        if (values.size() != 1 && values.size() != (ssize_t)ny * nz)
+            throw py::value_error("vectorized function should return values of the shape of coordinates");
+        const FP* data = values.data();
+        const int step = values.size() == 1 ? 0 : 1;
+        OMP_FOR()
+        for (int j = 0; j < ny; j++)
+            for (int k = 0; k < nz; k++)
+                field(i, j, k) = data[(j * nz + k) * step];
+    }
+
+
 
     template <class TGrid, class TFieldSolver, class TDerived, bool ifStraggered>
     class pyStraggeredFieldInterface {};
@@ -173,6 +226,25 @@ OMP_SIMD()
                     }
         }
 
+        /* Vectorized version of pySetEMField: func(x, y, z) returns the sequence
+        (Ex, Ey, Ez, Bx, By, Bz) of values in a layer of the grid. */
+        void pySetEMFieldVectorized(py::function func)
+        {
+            TDerived* derived = static_cast<TDerived*>(this);
+            pyFieldEntity<TGrid, TFieldSolver>* fieldEntity = derived->getFieldEntity();
+            ScalarField<FP>* fields[] = { &fieldEntity->Ex, &fieldEntity->Ey, &fieldEntity->Ez,
+                &fieldEntity->Bx, &fieldEntity->By, &fieldEntity->Bz };
+            for (int i = 0; i < fieldEntity->numCells.x; i++) {
+                FPArray x, y, z;
+                getLayerCoords(i, fieldEntity->numCells, [derived, fieldEntity](int i, int j, int k) {
+                    return derived->convertCoords(fieldEntity->ExPosition(i, j, k));
+                }, x, y, z);
+                py::object result = func("x"_a = x, "y"_a = y, "z"_a = z);
+                for (int c = 0; c < 6; c++)
+                    setLayer(*fields[c], i, fieldEntity->numCells, result[py::int_(c)]);
+            }
+        }
+
         void setEMField(int64_t _fValueField)
         {
             TDerived* derived = static_cast<TDerived*>(this);
@@ -241,6 +313,31 @@ OMP_SIMD()
                     }
         }
 
+        /* Vectorized version of pyApplyFunction: func(x, y, z, Ex, Ey, Ez, Bx, By, Bz)
+        gets the values in a layer of the grid and returns the sequence of their new values. */
+        void pyApplyFunctionVectorized(py::function func)
+        {
+            TDerived* derived = static_cast<TDerived*>(this);
+            pyFieldEntity<TGrid, TFieldSolver>* fieldEntity = derived->getFieldEntity();
+            ScalarField<FP>* fields[] = { &fieldEntity->Ex, &fieldEntity->Ey, &fieldEntity->Ez,
+                &fieldEntity->Bx, &fieldEntity->By, &fieldEntity->Bz };
+            for (int i = 0; i < fieldEntity->numCells.x; i++) {
+                FPArray x, y, z;
+                getLayerCoords(i, fieldEntity->numCells, [derived, fieldEntity](int i, int j, int k) {
+                    return derived->convertCoords(fieldEntity->ExPosition(i, j, k));
+                }, x, y, z);
+                py::object result = func("x"_a = x, "y"_a = y, "z"_a = z,
+                    "ex"_a = getLayer(*fields[0], i, fieldEntity->numCells),
+                    "ey"_a = getLayer(*fields[1], i, fieldEntity->numCells),
+                    "ez"_a = getLayer(*fields[2], i, fieldEntity->numCells),
+                    "bx"_a = getLayer(*fields[3], i, fieldEntity->numCells),
+                    "by"_a = getLayer(*fields[4], i, fieldEntity->numCells),
+                    "bz"_a = getLayer(*fields[5], i, fieldEntity->numCells));
+                for (int c = 0; c < 6; c++)
+                    setLayer(*fields[c], i, fieldEntity->numCells, result[py::int_(c)]);
+            }
+        }
+
         void applyFunction(int64_t _func)
         {
             TDerived* derived = static_cast<TDerived*>(this);
@@ -300,6 +397,57 @@ OMP_SIMD()
     {
     public:
 
+        /* Vectorized versions of the setters: the functions of coordinates x, y, z
+        return values of a component or the sequence of three components in a layer
+        of the grid. */
+        void pySetExyzVectorized(py::function fEx, py::function fEy, py::function fEz)
+        {
+            pyFieldEntity<TGrid, TFieldSolver>* fieldEntity = static_cast<TDerived*>(this)->getFieldEntity();
+            setVectorized(fieldEntity->Ex, &TGrid::ExPosition, fieldEntity->timeShiftE, fEx, -1);
+            setVectorized(fieldEntity->Ey, &TGrid::EyPosition, fieldEntity->timeShiftE, fEy, -1);
+            setVectorized(fieldEntity->Ez, &TGrid::EzPosition, fieldEntity->timeShiftE, fEz, -1);
+        }
+
+        void pySetEVectorized(py::function fE)
+        {
+            pyFieldEntity<TGrid, TFieldSolver>* fieldEntity = static_cast<TDerived*>(this)->getFieldEntity();
+            setVectorized(fieldEntity->Ex, &TGrid::ExPosition, fieldEntity->timeShiftE, fE, 0);
+            setVectorized(fieldEntity->Ey, &TGrid::EyPosition, fieldEntity->timeShiftE, fE, 1);
+            setVectorized(fieldEntity->Ez, &TGrid::EzPosition, fieldEntity->timeShiftE, fE, 2);
+        }
+
+        void pySetBxyzVectorized(py::function fBx, py::function fBy, py::function fBz)
+        {
+            pyFieldEntity<TGrid, TFieldSolver>* fieldEntity = static_cast<TDerived*>(this)->getFieldEntity();
+            setVectorized(fieldEntity->Bx, &TGrid::BxPosition, fieldEntity->timeShiftB, fBx, -1);
+            setVectorized(fieldEntity->By, &TGrid::ByPosition, fieldEntity->timeShiftB, fBy, -1);
+            setVectorized(fieldEntity->Bz, &TGrid::BzPosition, fieldEntity->timeShiftB, fBz, -1);
+        }
+
+        void pySetBVectorized(py::function fB)
+        {
+            pyFieldEntity<TGrid, TFieldSolver>* fieldEntity = static_cast<TDerived*>(this)->getFieldEntity();
+            setVectorized(fieldEntity->Bx, &TGrid::BxPosition, fieldEntity->timeShiftB, fB, 0);
+            setVectorized(fieldEntity->By, &TGrid::ByPosition, fieldEntity->timeShiftB, fB, 1);
+            setVectorized(fieldEntity->Bz, &TGrid::BzPosition, fieldEntity->timeShiftB, fB, 2);
+        }
+
+        void pySetJxyzVectorized(py::function fJx, py::function fJy, py::function fJz)
+        {
+            pyFieldEntity<TGrid, TFieldSolver>* fieldEntity = static_cast<TDerived*>(this)->getFieldEntity();
+            setVectorized(fieldEntity->Jx, &TGrid::JxPosition, fieldEntity->timeShiftJ, fJx, -1);
+            setVectorized(fieldEntity->Jy, &TGrid::JyPosition, fieldEntity->timeShiftJ, fJy, -1);
+            setVectorized(fieldEntity->Jz, &TGrid::JzPosition, fieldEntity->timeShiftJ, fJz, -1);
+        }
+
+        void pySetJVectorized(py::function fJ)
+        {
+            pyFieldEntity<TGrid, TFieldSolver>* fieldEntity = static_cast<TDerived*>(this)->getFieldEntity();
+            setVectorized(fieldEntity->Jx, &TGrid::JxPosition, fieldEntity->timeShiftJ, fJ, 0);
+            setVectorized(fieldEntity->Jy, &TGrid::JyPosition, fieldEntity->timeShiftJ, fJ, 1);
+            setVectorized(fieldEntity->Jz, &TGrid::JzPosition, fieldEntity->timeShiftJ, fJ, 2);
+        }
+
         void pySetExyz(py::function fEx, py::function fEy, py::function fEz)
         {
             TDerived* derived = static_cast<TDerived*>(this);
@@ -623,6 +771,30 @@ OMP_SIMD()
         TGrid* getGrid() {
             return static_cast<TGrid*>(static_cast<TDerived*>(this)->getFieldEntity());
         }
+
+    private:
+
+        typedef const FP3(TGrid::*Position)(int, int, int) const;
+
+        // component < 0 means that func returns the values of the field, not a vector
+        void setVectorized(ScalarField<FP>& field, Position position, FP timeShift,
+            py::function func, int component)
+        {
+            TDerived* derived = static_cast<TDerived*>(this);
+            pyFieldEntity<TGrid, TFieldSolver>* fieldEntity = derived->getFieldEntity();
+            for (int i = 0; i < fieldEntity->numCells.x; i++) {
+                FPArray x, y, z;
+                getLayerCoords(i, fieldEntity->numCells,
+                    [derived, fieldEntity, position, timeShift](int i, int j, int k) {
+                    return derived->convertCoords((fieldEntity->*position)(i, j, k), timeShift);
+                }, x, y, z);
+                py::object result = func("x"_a = x, "y"_a = y, "z"_a = z);
+                if (component < 0)
+                    setLayer(field, i, fieldEntity->numCells, result);
+                else
+                    setLayer(field, i, fieldEntity->numCells, result[py::int_(component)]);
+            }
+        }
     };
 
 
@@ -690,6 +862,25 @@ OMP_SIMD()
     };
 
 
+    template <class TGrid, class TFieldSolver, class TDerived, bool>
+    class pySpectralFieldSolverInterface {};
+
+    template <class TGrid, class TFieldSolver, class TDerived>
+    class pySpectralFieldSolverInterface<TGrid, TFieldSolver, TDerived, true> {
+    public:
+        // the complex grid shares memory with the real grid,
+        // its values are valid after the transform to the complex space
+        Grid<complexFP, TGrid::gridType>* getComplexGrid() {
+            return static_cast<TDerived*>(this)->getFieldEntity()->complexGrid;
+        }
+
+        void doFourierTransform(bool toComplex) {
+            static_cast<TDerived*>(this)->getFieldEntity()->doFourierTransform(toComplex ?
+                fourier_transform::Direction::RtoC : fourier_transform::Direction::CtoR);
+        }
+    };
+
+
     template <class TGrid, class TFieldSolver, class TDerived, bool>
     class pyFieldGeneratorSolverInterface {};
 
@@ -727,6 +918,11 @@ OMP_SIMD()
         std::is_same<TFieldSolver, PSATD>::value || std::is_same<TFieldSolver, PSATDPoisson>::value ||
         std::is_same<TFieldSolver, PSATDTimeStraggered>::value ||
         std::is_same<TFieldSolver, PSATDTimeStraggeredPoisson>::value>,
+        public pySpectralFieldSolverInterface<TGrid, TFieldSolver, TDerived,
+        std::is_same<TFieldSolver, PSTD>::value ||
+        std::is_same<TFieldSolver, PSATD>::value || std::is_same<TFieldSolver, PSATDPoisson>::value ||
+        std::is_same<TFieldSolver, PSATDTimeStraggered>::value ||
+        std::is_same<TFieldSolver, PSATDTimeStraggeredPoisson>::value>,
         public pyFieldGeneratorSolverInterface<TGrid, TFieldSolver, TDerived,
         std::is_same<TFieldSolver, FDTD>::value>,
         public pyPMLSolverInterface<TGrid, TFieldSolver, TDerived,
@@ -792,6 +988,45 @@ OMP_SIMD()
             b = getB(coords);
         }
 
+        // values at an array of points, composite fields override these to dispatch once per array
+        virtual void getEArray(const FP3* coords, FP3* values, int size) const {
+            OMP_FOR()
+            for (int i = 0; i < size; i++)
+                values[i] = getE(coords[i]);
+        }
+
+        virtual void getBArray(const FP3* coords, FP3* values, int size) const {
+            OMP_FOR()
+            for (int i = 0; i < size; i++)
+                values[i] = getB(coords[i]);
+        }
+
+        virtual void getJArray(const FP3* coords, FP3* values, int size) const {
+            OMP_FOR()
+            for (int i = 0; i < size; i++)
+                values[i] = getJ(coords[i]);
+        }
+
+        /* Values of a component (x, y, z, or the norm for component 3) of E, B or J at points
+        origin + i0 * step0 + i1 * step1 stored as values[i1 * n0 + i0], used for slices of fields. */
+        void extractSlice(Field field, int component, const FP3& origin, const FP3& step0,
+            const FP3& step1, int n0, int n1, FP* values) const
+        {
+            const int size = n0 * n1;
+            std::vector<FP3> coords(size), vectors(size);
+            OMP_FOR()
+            for (int idx = 0; idx < size; idx++)
+                coords[idx] = origin + step0 * (FP)(idx % n0) + step1 * (FP)(idx / n0);
+            switch (field) {
+            case Field::E: getEArray(coords.data(), vectors.data(), size); break;
+            case Field::B: getBArray(coords.data(), vectors.data(), size); break;
+            case Field::J: getJArray(coords.data(), vectors.data(), size); break;
+            }
+            OMP_FOR()
+            for (int idx = 0; idx < size; idx++)
+                values[idx] = (component == 3) ? vectors[idx].norm() : vectors[idx][component];
+        }
+
         virtual void updateFields() = 0;
         virtual void advance(FP dt) = 0;
 
@@ -964,6 +1199,27 @@ OMP_SIMD()
             return pyWrappedField1->getJ(coords) + pyWrappedField2->getJ(coords);
         }
 
+        void getEArray(const FP3* coords, FP3* values, int size) const override {
+            std::vector<FP3> values2(size);
+            pyWrappedField1->getEArray(coords, values, size);
+            pyWrappedField2->getEArray(coords, values2.data(), size);
+            add(values, values2, size);
+        }
+
+        void getBArray(const FP3* coords, FP3* values, int size) const override {
+            std::vector<FP3> values2(size);
+            pyWrappedField1->getBArray(coords, values, size);
+            pyWrappedField2->getBArray(coords, values2.data(), size);
+            add(values, values2, size);
+        }
+
+        void getJArray(const FP3* coords, FP3* values, int size) const override {
+            std::vector<FP3> values2(size);
+            pyWrappedField1->getJArray(coords, values, size);
+            pyWrappedField2->getJArray(coords, values2.data(), size);
+            add(values, values2, size);
+        }
+
         void updateFields() override {
             pyWrappedField1->updateFields();
             pyWrappedField2->updateFields();
@@ -976,6 +1232,12 @@ OMP_SIMD()
 
     private:
 
+        static void add(FP3* values, const std::vector<FP3>& values2, int size) {
+            OMP_FOR()
+            for (int i = 0; i < size; i++)
+                values[i] += values2[i];
+        }
+
         std::shared_ptr<pyFieldBase> pyWrappedField1;
         std::shared_ptr<pyFieldBase> pyWrappedField2;
     };
@@ -1017,6 +1279,21 @@ OMP_SIMD()
             return pyWrappedField->getJ(coords) * factor;
         }
 
+        void getEArray(const FP3* coords, FP3* values, int size) const override {
+            pyWrappedField->getEArray(coords, values, size);
+            multiply(values, size);
+        }
+
+        void getBArray(const FP3* coords, FP3* values, int size) const override {
+            pyWrappedField->getBArray(coords, values, size);
+            multiply(values, size);
+        }
+
+        void getJArray(const FP3* coords, FP3* values, int size) const override {
+            pyWrappedField->getJArray(coords, values, size);
+            multiply(values, size);
+        }
+
         void updateFields() override {
             pyWrappedField->updateFields();
         }
@@ -1027,6 +1304,12 @@ OMP_SIMD()
 
     private:
 
+        void multiply(FP3* values, int size) const {
+            OMP_FOR()
+            for (int i = 0; i < size; i++)
+                values[i] = values[i] * factor;
+        }
+
         FP factor = 1.0;
         std::shared_ptr<pyFieldBase> pyWrappedField;
     };
@@ -2,14 +2,18 @@
 //
 
 #include <algorithm>
+#include <complex>
+#include <fstream>
 
 #include "pybind11/pybind11.h"
+#include "pybind11/numpy.h"
 #include "pybind11/stl.h"
 #include <pybind11/operators.h>
 
 #include "pyField.h"
 
 #include "Constants.h"
+#include "CpuDispatch.h"
 #include "Dimension.h"
 #include "Ensemble.h"
 #include "Fdtd.h"
@@ -65,9 +69,52 @@
         py::arg("Ex"), py::arg("Ey"), py::arg("Ez"), py::arg("t"))         \
     .def("set_B", &pyFieldType::setBxyzt,                                  \
         py::arg("Bx"), py::arg("By"), py::arg("Bz"), py::arg("t"))         \
+    .def("set_E_vectorized", &pyFieldType::pySetEVectorized,               \
+        py::arg("func"))                                                   \
+    .def("set_B_vectorized", &pyFieldType::pySetBVectorized,               \
+        py::arg("func"))                                                   \
+    .def("set_J_vectorized", &pyFieldType::pySetJVectorized,               \
+        py::arg("func"))                                                   \
+    .def("set_E_vectorized", &pyFieldType::pySetExyzVectorized,            \
+        py::arg("Ex"), py::arg("Ey"), py::arg("Ez"))                       \
+    .def("set_B_vectorized", &pyFieldType::pySetBxyzVectorized,            \
+        py::arg("Bx"), py::arg("By"), py::arg("Bz"))                       \
+    .def("set_J_vectorized", &pyFieldType::pySetJxyzVectorized,            \
+        py::arg("Jx"), py::arg("Jy"), py::arg("Jz"))                       \
+    .def("get_E_views", [](pyFieldType& self) {                            \
+        return makeFieldViews<FP>(self.getGrid()->Ex, self.getGrid()->Ey,  \
+            self.getGrid()->Ez, &self); })                                 \
+    .def("get_B_views", [](pyFieldType& self) {                            \
+        return makeFieldViews<FP>(self.getGrid()->Bx, self.getGrid()->By,  \
+            self.getGrid()->Bz, &self); })                                 \
+    .def("get_J_views", [](pyFieldType& self) {                            \
+        return makeFieldViews<FP>(self.getGrid()->Jx, self.getGrid()->Jy,  \
+            self.getGrid()->Jz, &self); })                                 \
     SET_FIELD_CONFIGURATIONS_GRID_METHODS(pyFieldType)
 
 
+#define SET_SPECTRAL_FIELD_METHODS(pyFieldType)                            \
+    .def("set_vectorized", &pyFieldType::pySetEMFieldVectorized,           \
+        py::arg("func"))                                                   \
+    .def("apply_function_vectorized",                                      \
+        &pyFieldType::pyApplyFunctionVectorized, py::arg("func"))          \
+    .def("fourier_transform", &pyFieldType::doFourierTransform,            \
+        py::arg("to_complex"),                                             \
+        py::call_guard<py::gil_scoped_release>())                          \
+    .def("get_complex_E_views", [](pyFieldType& self) {                    \
+        auto grid = self.getComplexGrid();                                 \
+        return makeFieldViews<std::complex<FP>>(grid->Ex, grid->Ey,        \
+            grid->Ez, &self); })                                           \
+    .def("get_complex_B_views", [](pyFieldType& self) {                    \
+        auto grid = self.getComplexGrid();                                 \
+        return makeFieldViews<std::complex<FP>>(grid->Bx, grid->By,        \
+            grid->Bz, &self); })                                           \
+    .def("get_complex_J_views", [](pyFieldType& self) {                    \
+        auto grid = self.getComplexGrid();                                 \
+        return makeFieldViews<std::complex<FP>>(grid->Jx, grid->Jy,        \
+            grid->Jz, &self); })
+
+
 #define SET_COMMON_FIELD_METHODS(pyFieldType)                             \
     .def("change_time_step", &pyFieldType::changeTimeStep,                \
         py::arg("time_step"))                                             \
@@ -124,7 +171,147 @@ void processParticles(QED* self, Ensemble3d* particles,
     }
 }
 
+// coordinates, momenta and weights are 1d numpy arrays of the same size, weights may be None
+void appendParticles(ParticleArray3d* self, FPArray x, FPArray y, FPArray z,
+    FPArray px, FPArray py, FPArray pz, py::object weight)
+{
+    FPArray weights;
+    if (!weight.is_none())
+        weights = weight.cast<FPArray>();
+    const FPArray* arrays[] = { &x, &y, &z, &px, &py, &pz, &weights };
+    const int numArrays = weight.is_none() ? 6 : 7;
+    for (int i = 0; i < numArrays; i++)
+        if (arrays[i]->ndim() != 1 || arrays[i]->size() != x.size())
+            throw py::value_error("arrays of particle data should be 1d and of the same size");
+    py::gil_scoped_release release;
+    self->append(x.data(), y.data(), z.data(), px.data(), py.data(), pz.data(),
+        weight.is_none() ? 0 : weights.data(), (int)x.size());
+}
+
+// 1d numpy view of data without copying, the view keeps the owner alive
+template <class T, class Owner>
+py::array_t<T> makeView(T* data, size_t size, Owner* owner)
+{
+    return py::array_t<T>(std::vector<ssize_t>{ (ssize_t)size }, std::vector<ssize_t>{ (ssize_t)sizeof(T) },
+        data, py::cast(owner));
+}
 
+template <class Owner, class GetData>
+py::list makeViews(Owner* owner, int num, size_t size, GetData getData)
+{
+    py::list views;
+    for (int d = 0; d < num; d++)
+        views.append(makeView(getData(d), size, owner));
+    return views;
+}
+
+// 3d numpy view of a scalar field without copying, T is the numpy type of the field values
+template <class T, class Data, class Owner>
+py::array_t<T> makeFieldView(ScalarField<Data>& field, Owner* owner)
+{
+    static_assert(sizeof(T) == sizeof(Data), "numpy type should have the same size as the field values");
+    if (field.getLayout() == ScalarFieldLayout_Bricks)
+        throw py::value_error("fields with the brick layout can't be viewed as numpy arrays");
+    Int3 size = field.getSize(), strides = field.getStrides();
+    return py::array_t<T>(std::vector<ssize_t>{ size.x, size.y, size.z },
+        std::vector<ssize_t>{ (ssize_t)(strides.x * sizeof(T)), (ssize_t)(strides.y * sizeof(T)),
+        (ssize_t)(strides.z * sizeof(T)) },
+        reinterpret_cast<T*>(field.getData()), py::cast(owner));
+}
+
+template <class T, class Data, class Owner>
+py::list makeFieldViews(ScalarField<Data>& x, ScalarField<Data>& y, ScalarField<Data>& z, Owner* owner)
+{
+    py::list views;
+    views.append(makeFieldView<T>(x, owner));
+    views.append(makeFieldView<T>(y, owner));
+    views.append(makeFieldView<T>(z, owner));
+    return views;
+}
+
+// values of a field at points given by an (N, 3) array of coordinates as an (N, 3) array
+FPArray getFieldArray(const pyFieldBase& field, FPArray coords,
+    void (pyFieldBase::*getArray)(const FP3*, FP3*, int) const)
+{
+    static_assert(sizeof(FP3) == 3 * sizeof(FP), "coordinates should be stored as (N, 3) arrays");
+    if (coords.ndim() != 2 || coords.shape(1) != 3)
+        throw py::value_error("coordinates should be an (N, 3) array");
+    const int size = (int)coords.shape(0);
+    FPArray values(std::vector<ssize_t>{ size, 3 });
+    const FP3* coordsData = reinterpret_cast<const FP3*>(coords.data());
+    FP3* valuesData = reinterpret_cast<FP3*>(values.mutable_data());
+    {
+        py::gil_scoped_release release;
+        (field.*getArray)(coordsData, valuesData, size);
+    }
+    return values;
+}
+
+// values of a component of a field on a uniform grid of points, also written to a binary file if it is given
+FPArray extractSlice(const pyFieldBase& field, Field fieldType, Coordinate component, bool norm,
+    const FP3& origin, const FP3& step0, const FP3& step1, int n0, int n1,
+    const std::vector<ssize_t>& shape, const std::string& fileName)
+{
+    if (n0 < 1 || n1 < 1)
+        throw py::value_error("number of points should be positive");
+    FPArray values(shape);
+    FP* data = values.mutable_data();
+    {
+        py::gil_scoped_release release;
+        field.extractSlice(fieldType, norm ? 3 : (int)component, origin, step0, step1, n0, n1, data);
+        if (!fileName.empty()) {
+            std::ofstream file(fileName, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(data), sizeof(FP) * n0 * n1);
+            if (!file)
+                throw py::value_error("can't write file " + fileName);
+        }
+    }
+    return values;
+}
+
+// step between n points from min to max along the axis, the last point is max
+FP3 sliceStep(Coordinate axis, const FP3& minCoords, const FP3& maxCoords, int n)
+{
+    FP3 step;
+    if (n > 1)
+        step[axis] = (maxCoords[axis] - minCoords[axis]) / (n - 1);
+    return step;
+}
+
+// values[i1, i0] in the plane of the axes given by the offset along the third axis
+FPArray extractPlane(const pyFieldBase& field, Field fieldType, Coordinate component,
+    Coordinate axis0, Coordinate axis1, FP offset, const FP3& minCoords, const FP3& maxCoords,
+    std::pair<int, int> shape, bool norm, const std::string& fileName)
+{
+    if (axis0 == axis1)
+        throw py::value_error("axes of the plane should differ");
+    FP3 origin = minCoords;
+    origin[3 - axis0 - axis1] = offset;
+    return extractSlice(field, fieldType, component, norm, origin,
+        sliceStep(axis0, minCoords, maxCoords, shape.first), sliceStep(axis1, minCoords, maxCoords, shape.second),
+        shape.first, shape.second, std::vector<ssize_t>{ shape.second, shape.first }, fileName);
+}
+
+// values on the line along the axis given by the offsets along the other axes in the order x, y, z
+FPArray extractLine(const pyFieldBase& field, Field fieldType, Coordinate component,
+    Coordinate axis, std::pair<FP, FP> offset, const FP3& minCoords, const FP3& maxCoords,
+    int numPoints, bool norm, const std::string& fileName)
+{
+    FP3 origin;
+    origin[axis] = minCoords[axis];
+    origin[axis == Coordinate::x ? 1 : 0] = offset.first;
+    origin[axis == Coordinate::z ? 1 : 2] = offset.second;
+    return extractSlice(field, fieldType, component, norm, origin,
+        sliceStep(axis, minCoords, maxCoords, numPoints), FP3(), numPoints, 1,
+        std::vector<ssize_t>{ numPoints }, fileName);
+}
+
+
+/* Long-running methods release the GIL (py::call_guard<py::gil_scoped_release>),
+so other Python threads can run during them. Such methods don't touch Python
+objects and keep no state shared between objects, so calls on different objects
+can overlap; objects passed to a running call must not be used from other threads
+until it returns, e.g. diagnostics should copy the data before the next step. */
 PYBIND11_MODULE(pyHiChi, object) {
     object.doc() = "This is a pybind11 module"; // optional module docstring
 
@@ -140,6 +327,19 @@ PYBIND11_MODULE(pyHiChi, object) {
     object.attr("eV") = constants::eV;
     object.attr("meV") = constants::meV;
 
+    // ------------------- instruction set of kernels -------------------
+
+    // the instruction set is selected at import, HICHI_CPU_ISA may select a lower one
+    getCpuIsa();
+    py::enum_<CpuIsa>(object, "CpuIsa")
+        .value("GENERIC", CpuIsa_Generic)
+        .value("AVX2", CpuIsa_AVX2)
+        .value("AVX512", CpuIsa_AVX512)
+        ;
+    object.def("get_cpu_isa", &getCpuIsa);
+    object.def("detect_cpu_isa", &detectCpuIsa);
+    object.def("set_cpu_isa", &setCpuIsa, py::arg("isa"));
+
     // ------------------- auxilary structures -------------------
 
     py::enum_<Coordinate>(object, "Axis")
@@ -149,6 +349,12 @@ PYBIND11_MODULE(pyHiChi, object) {
         .export_values()
         ;
 
+    py::enum_<Field>(object, "Field")
+        .value("E", Field::E)
+        .value("B", Field::B)
+        .value("J", Field::J)
+        ;
+
     py::class_<FP3>(object, "Vector3d")
         .def(py::init<>())
         .def(py::init<FP, FP, FP>())
@@ -266,8 +472,31 @@ PYBIND11_MODULE(pyHiChi, object) {
         .def("add", &ParticleArray3d::pushBack)
         .def("get_type", &ParticleArray3d::getType)
         .def("size", &ParticleArray3d::size)
+        .def("reserve", &ParticleArray3d::reserve, py::arg("size"))
+        .def("resize", &ParticleArray3d::resize, py::arg("size"))
+        .def("append", &appendParticles, py::arg("x"), py::arg("y"), py::arg("z"),
+            py::arg("px"), py::arg("py"), py::arg("pz"), py::arg("weight") = py::none())
+        // writable views of the columns without copying, they are valid until the array
+        // is reallocated by add, append, resize, reserve, delete or compact
+        .def("get_positions", [](ParticleArray3d& arr) {
+        return makeViews(&arr, 3, arr.size(), [&arr](int d) { return arr.getPositionData(d); });
+    }, "List of x, y, z views")
+        .def("get_p", [](ParticleArray3d& arr) {
+        return makeViews(&arr, 3, arr.size(), [&arr](int d) { return arr.getPData(d); });
+    }, "List of px, py, pz views in units of mc, call update_gammas after writing")
+        .def("get_weights", [](ParticleArray3d& arr) { return makeView(arr.getWeightData(), arr.size(), &arr); })
+        .def("get_gammas", [](ParticleArray3d& arr) { return makeView(arr.getGammaData(), arr.size(), &arr); })
+        .def("update_gammas", &ParticleArray3d::updateGammas)
         .def("delete", (void (ParticleArray3d::*)(int)) &ParticleArray3d::deleteParticle)
         .def("delete", (void (ParticleArray3d::*)(ParticleArray3d::iterator&)) &ParticleArray3d::deleteParticle)
+        .def("mark_removed", &ParticleArray3d::markRemoved, py::arg("index"))
+        .def("is_removed", &ParticleArray3d::isRemoved, py::arg("index"))
+        .def("compact", &ParticleArray3d::compact, py::arg("keep_order") = true,
+            py::call_guard<py::gil_scoped_release>())
+        .def("remove_if", [](ParticleArray3d& arr, const std::vector<bool>& mask, bool keepOrder) {
+        if (mask.size() != arr.size()) throw py::value_error("mask size differs from the array size");
+        arr.removeIf(mask, keepOrder);
+    }, py::arg("mask"), py::arg("keep_order") = true, py::call_guard<py::gil_scoped_release>())
         .def("__getitem__", [](ParticleArray3d& arr, size_t i) {
         if (i >= arr.size()) throw py::index_error();
         return arr[i];
@@ -284,6 +513,8 @@ PYBIND11_MODULE(pyHiChi, object) {
         .def(py::init<>())
         .def(py::init<Ensemble3d>(), py::arg("ensemble"))
         .def("add", &Ensemble3d::addParticle, py::arg("particle"))
+        .def("compact", &Ensemble3d::compact, py::arg("keep_order") = true,
+            py::call_guard<py::gil_scoped_release>())
         .def("size", &Ensemble3d::size)
         .def("__getitem__", [](Ensemble3d& arr, size_t i) {
         if (i >= sizeParticleTypes) throw py::index_error();
@@ -311,7 +542,24 @@ PYBIND11_MODULE(pyHiChi, object) {
         .def(py::init<>())
         .def("__call__", (void (BorisPusher::*)(ParticleProxy3d*, ValueField&, FP)) &BorisPusher::operator())
         .def("__call__", (void (BorisPusher::*)(Particle3d*, ValueField&, FP)) &BorisPusher::operator())
-        .def("__call__", (void (BorisPusher::*)(ParticleArray3d*, std::vector<ValueField>&, FP)) &BorisPusher::operator())
+        .def("__call__", (void (BorisPusher::*)(ParticleArray3d*, std::vector<ValueField>&, FP)) &BorisPusher::operator(),
+            py::call_guard<py::gil_scoped_release>())
+        ;
+
+    py::class_<VayPusher>(object, "VayPusher")
+        .def(py::init<>())
+        .def("__call__", (void (VayPusher::*)(ParticleProxy3d*, ValueField&, FP)) &VayPusher::operator())
+        .def("__call__", (void (VayPusher::*)(Particle3d*, ValueField&, FP)) &VayPusher::operator())
+        .def("__call__", (void (VayPusher::*)(ParticleArray3d*, std::vector<ValueField>&, FP)) &VayPusher::operator(),
+            py::call_guard<py::gil_scoped_release>())
+        ;
+
+    py::class_<HigueraCaryPusher>(object, "HigueraCaryPusher")
+        .def(py::init<>())
+        .def("__call__", (void (HigueraCaryPusher::*)(ParticleProxy3d*, ValueField&, FP)) &HigueraCaryPusher::operator())
+        .def("__call__", (void (HigueraCaryPusher::*)(Particle3d*, ValueField&, FP)) &HigueraCaryPusher::operator())
+        .def("__call__", (void (HigueraCaryPusher::*)(ParticleArray3d*, std::vector<ValueField>&, FP)) &HigueraCaryPusher::operator(),
+            py::call_guard<py::gil_scoped_release>())
         ;
 
     // ------------------- other particle modules -------------------
@@ -320,46 +568,64 @@ PYBIND11_MODULE(pyHiChi, object) {
         .def(py::init<>())
         .def("__call__", (void (RadiationReaction::*)(ParticleProxy3d*, ValueField&, FP)) &RadiationReaction::operator())
         .def("__call__", (void (RadiationReaction::*)(Particle3d*, ValueField&, FP)) &RadiationReaction::operator())
-        .def("__call__", (void (RadiationReaction::*)(ParticleArray3d*, std::vector<ValueField>&, FP)) &RadiationReaction::operator())
+        .def("__call__", (void (RadiationReaction::*)(ParticleArray3d*, std::vector<ValueField>&, FP)) &RadiationReaction::operator(),
+            py::call_guard<py::gil_scoped_release>())
+        ;
+
+    py::class_<BorisPusherWithRadiationReaction>(object, "BorisPusherWithRadiationReaction")
+        .def(py::init<>())
+        .def("__call__", (void (BorisPusherWithRadiationReaction::*)(ParticleProxy3d*, ValueField&, FP)) &BorisPusherWithRadiationReaction::operator())
+        .def("__call__", (void (BorisPusherWithRadiationReaction::*)(Particle3d*, ValueField&, FP)) &BorisPusherWithRadiationReaction::operator())
+        .def("__call__", (void (BorisPusherWithRadiationReaction::*)(ParticleArray3d*, std::vector<ValueField>&, FP)) &BorisPusherWithRadiationReaction::operator(),
+            py::call_guard<py::gil_scoped_release>())
         ;
 
     // -------------------------- QED ---------------------------
 
     py::class_<ScalarQED_AEG_only_electron_Yee>(object, "QED_Yee")
         .def(py::init<>())
-        .def("process_particles", &ScalarQED_AEG_only_electron_Yee::processParticles)
+        .def("process_particles", &ScalarQED_AEG_only_electron_Yee::processParticles,
+            py::call_guard<py::gil_scoped_release>())
         .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_Yee,
-            pyYeeField, YeeGrid>)
+            pyYeeField, YeeGrid>, py::call_guard<py::gil_scoped_release>())
         ;
 
     py::class_<ScalarQED_AEG_only_electron_PSTD>(object, "QED_PSTD")
         .def(py::init<>())
-        .def("process_particles", &ScalarQED_AEG_only_electron_PSTD::processParticles)
+        .def("process_particles", &ScalarQED_AEG_only_electron_PSTD::processParticles,
+            py::call_guard<py::gil_scoped_release>())
         .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_PSTD,
-            pyPSTDField, PSTDGrid>)
+            pyPSTDField, PSTDGrid>, py::call_guard<py::gil_scoped_release>())
         ;
 
     py::class_<ScalarQED_AEG_only_electron_PSATD>(object, "QED_PSATD")
         .def(py::init<>())
-        .def("process_particles", &ScalarQED_AEG_only_electron_PSATD::processParticles)
+        .def("process_particles", &ScalarQED_AEG_only_electron_PSATD::processParticles,
+            py::call_guard<py::gil_scoped_release>())
         .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_PSATD,
-            pyPSATDField, PSATDGrid>)
+            pyPSATDField, PSATDGrid>, py::call_guard<py::gil_scoped_release>())
         ;
 
     py::class_<ScalarQED_AEG_only_electron_Analytical>(object, "QED_Analytical")
         .def(py::init<>())
-        .def("process_particles", &ScalarQED_AEG_only_electron_Analytical::processParticles)
+        .def("process_particles", &ScalarQED_AEG_only_electron_Analytical::processParticles,
+            py::call_guard<py::gil_scoped_release>())
         .def("process_particles", &processParticles<ScalarQED_AEG_only_electron_Analytical,
-            pyAnalyticalField, AnalyticalField>)
+            pyAnalyticalField, AnalyticalField>, py::call_guard<py::gil_scoped_release>())
         ;
 
     // ------------------- thinnings -------------------
 
-    object.def("simple_thinning", &Thinning<ParticleArray3d>::simple);
-    object.def("leveling_thinning", &Thinning<ParticleArray3d>::leveling);
-    object.def("number_conservative_thinning", &Thinning<ParticleArray3d>::numberConservative);
-    object.def("energy_conservative_thinning", &Thinning<ParticleArray3d>::energyConservative);
-    object.def("k_means_mergining", &Merging<ParticleArray3d>::merge_with_kmeans);
+    object.def("simple_thinning", &Thinning<ParticleArray3d>::simple,
+        py::call_guard<py::gil_scoped_release>());
+    object.def("leveling_thinning", &Thinning<ParticleArray3d>::leveling,
+        py::call_guard<py::gil_scoped_release>());
+    object.def("number_conservative_thinning", &Thinning<ParticleArray3d>::numberConservative,
+        py::call_guard<py::gil_scoped_release>());
+    object.def("energy_conservative_thinning", &Thinning<ParticleArray3d>::energyConservative,
+        py::call_guard<py::gil_scoped_release>());
+    object.def("k_means_mergining", &Merging<ParticleArray3d>::merge_with_kmeans,
+        py::call_guard<py::gil_scoped_release>());
 
     // ------------------- mappings -------------------
 
@@ -435,8 +701,30 @@ PYBIND11_MODULE(pyHiChi, object) {
             py::arg("coords"))
         .def("get_B", static_cast<FP3(pyFieldBase::*)(const FP3&) const>(&pyFieldBase::getB),
             py::arg("coords"))
-        .def("update_fields", &pyFieldBase::updateFields)
-        .def("advance", &pyFieldBase::advance, py::arg("time_step"))
+        .def("get_J", [](const pyFieldBase& self, FPArray coords) {
+            return getFieldArray(self, coords, &pyFieldBase::getJArray);
+        }, py::arg("coords"))
+        .def("get_E", [](const pyFieldBase& self, FPArray coords) {
+            return getFieldArray(self, coords, &pyFieldBase::getEArray);
+        }, py::arg("coords"))
+        .def("get_B", [](const pyFieldBase& self, FPArray coords) {
+            return getFieldArray(self, coords, &pyFieldBase::getBArray);
+        }, py::arg("coords"))
+        .def("get_fields", [](const pyFieldBase& self, FPArray coords) {
+            return py::make_tuple(getFieldArray(self, coords, &pyFieldBase::getEArray),
+                getFieldArray(self, coords, &pyFieldBase::getBArray));
+        }, py::arg("coords"))
+        .def("extract_plane", &extractPlane, py::arg("field"), py::arg("component"),
+            py::arg("axis0"), py::arg("axis1"), py::arg("offset"),
+            py::arg("min_coords"), py::arg("max_coords"), py::arg("shape"),
+            py::arg("norm") = false, py::arg("file_name") = "")
+        .def("extract_line", &extractLine, py::arg("field"), py::arg("component"),
+            py::arg("axis"), py::arg("offset"), py::arg("min_coords"), py::arg("max_coords"),
+            py::arg("n_points"), py::arg("norm") = false, py::arg("file_name") = "")
+        .def("update_fields", &pyFieldBase::updateFields,
+            py::call_guard<py::gil_scoped_release>())
+        .def("advance", &pyFieldBase::advance, py::arg("time_step"),
+            py::call_guard<py::gil_scoped_release>())
         ;
 
     py::class_<pySumField, std::shared_ptr<pySumField>>(
@@ -483,6 +771,7 @@ PYBIND11_MODULE(pyHiChi, object) {
         SET_COMPUTATIONAL_GRID_METHODS(pyPSTDField)
         SET_SUM_AND_MAP_FIELD_METHODS(pyPSTDField)
         SET_COMMON_FIELD_METHODS(pyPSTDField)
+        SET_SPECTRAL_FIELD_METHODS(pyPSTDField)
         .def("set_PML", &pyPSTDField::setPML,
             py::arg("pml_size_x"), py::arg("pml_size_y"), py::arg("pml_size_z"))
         .def("set", &pyPSTDField::setEMField, py::arg("func"))
@@ -496,9 +785,11 @@ PYBIND11_MODULE(pyHiChi, object) {
         SET_COMPUTATIONAL_GRID_METHODS(pyPSATDField)
         SET_SUM_AND_MAP_FIELD_METHODS(pyPSATDField)
         SET_COMMON_FIELD_METHODS(pyPSATDField)
+        SET_SPECTRAL_FIELD_METHODS(pyPSATDField)
         .def("set_PML", &pyPSATDField::setPML,
             py::arg("pml_size_x"), py::arg("pml_size_y"), py::arg("pml_size_z"))
-        .def("convert_fields_poisson_equation", &pyPSATDField::convertFieldsPoissonEquation)
+        .def("convert_fields_poisson_equation", &pyPSATDField::convertFieldsPoissonEquation,
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyPSATDField::setEMField, py::arg("func"))
         .def("set", &pyPSATDField::pySetEMField, py::arg("func"))
         .def("apply_function", &pyPSATDField::applyFunction, py::arg("func"))
@@ -510,9 +801,11 @@ PYBIND11_MODULE(pyHiChi, object) {
         SET_COMPUTATIONAL_GRID_METHODS(pyPSATDPoissonField)
         SET_SUM_AND_MAP_FIELD_METHODS(pyPSATDPoissonField)
         SET_COMMON_FIELD_METHODS(pyPSATDPoissonField)
+        SET_SPECTRAL_FIELD_METHODS(pyPSATDPoissonField)
         .def("set_PML", &pyPSATDPoissonField::setPML,
             py::arg("pml_size_x"), py::arg("pml_size_y"), py::arg("pml_size_z"))
-        .def("convert_fields_poisson_equation", &pyPSATDPoissonField::convertFieldsPoissonEquation)
+        .def("convert_fields_poisson_equation", &pyPSATDPoissonField::convertFieldsPoissonEquation,
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyPSATDPoissonField::setEMField, py::arg("func"))
         .def("set", &pyPSATDPoissonField::pySetEMField, py::arg("func"))
         .def("apply_function", &pyPSATDPoissonField::applyFunction, py::arg("func"))
@@ -524,9 +817,11 @@ PYBIND11_MODULE(pyHiChi, object) {
         SET_COMPUTATIONAL_GRID_METHODS(pyPSATDTimeStraggeredField)
         SET_SUM_AND_MAP_FIELD_METHODS(pyPSATDTimeStraggeredField)
         SET_COMMON_FIELD_METHODS(pyPSATDTimeStraggeredField)
+        SET_SPECTRAL_FIELD_METHODS(pyPSATDTimeStraggeredField)
         .def("set_PML", &pyPSATDTimeStraggeredField::setPML,
             py::arg("pml_size_x"), py::arg("pml_size_y"), py::arg("pml_size_z"))
-        .def("convert_fields_poisson_equation", &pyPSATDTimeStraggeredField::convertFieldsPoissonEquation)
+        .def("convert_fields_poisson_equation", &pyPSATDTimeStraggeredField::convertFieldsPoissonEquation,
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyPSATDTimeStraggeredField::setEMField, py::arg("func"))
         .def("set", &pyPSATDTimeStraggeredField::pySetEMField, py::arg("func"))
         .def("apply_function", &pyPSATDTimeStraggeredField::applyFunction, py::arg("func"))
@@ -538,9 +833,11 @@ PYBIND11_MODULE(pyHiChi, object) {
         SET_COMPUTATIONAL_GRID_METHODS(pyPSATDTimeStraggeredPoissonField)
         SET_SUM_AND_MAP_FIELD_METHODS(pyPSATDTimeStraggeredPoissonField)
         SET_COMMON_FIELD_METHODS(pyPSATDTimeStraggeredPoissonField)
+        SET_SPECTRAL_FIELD_METHODS(pyPSATDTimeStraggeredPoissonField)
         .def("set_PML", &pyPSATDTimeStraggeredPoissonField::setPML,
             py::arg("pml_size_x"), py::arg("pml_size_y"), py::arg("pml_size_z"))
-        .def("convert_fields_poisson_equation", &pyPSATDTimeStraggeredPoissonField::convertFieldsPoissonEquation)
+        .def("convert_fields_poisson_equation", &pyPSATDTimeStraggeredPoissonField::convertFieldsPoissonEquation,
+            py::call_guard<py::gil_scoped_release>())
         .def("set", &pyPSATDTimeStraggeredPoissonField::setEMField, py::arg("func"))
         .def("set", &pyPSATDTimeStraggeredPoissonField::pySetEMField, py::arg("func"))
         .def("apply_function", &pyPSATDTimeStraggeredPoissonField::applyFunction, py::arg("func"))